@@ -29,6 +29,15 @@
 
 using namespace std;
 
+/* removes a scene collection file along with its backup and the binary cache
+ * that obs_data_save_json_cached writes next to it */
+static void RemoveSceneCollectionFile(const std::string &file)
+{
+	os_unlink(file.c_str());
+	os_unlink((file + ".bak").c_str());
+	os_unlink((file + ".bin").c_str());
+}
+
 void EnumSceneCollections(std::function<bool(const char *, const char *)> &&cb)
 {
 	char path[512];
@@ -186,10 +195,7 @@ bool OBSBasic::AddSceneCollection(bool create_new, const QString &qname)
 			     "Failed to get scene collection config path");
 			return;
 		}
-		std::string file = path + data + ".json";
-		os_unlink(file.c_str());
-		file += ".bak";
-		os_unlink(file.c_str());
+		RemoveSceneCollectionFile(path + data + ".json");
 		Load(newPath.c_str());
 		RefreshSceneCollections();
 	};
@@ -327,9 +333,7 @@ void OBSBasic::on_actionRenameSceneCollection_triggered()
 
 		oldFile.insert(0, path);
 		oldFile += ".json";
-		os_unlink(oldFile.c_str());
-		oldFile += ".bak";
-		os_unlink(oldFile.c_str());
+		RemoveSceneCollectionFile(oldFile);
 
 		UpdateTitleBar();
 		RefreshSceneCollections();
@@ -353,9 +357,7 @@ void OBSBasic::on_actionRenameSceneCollection_triggered()
 
 		oldFile.insert(0, path);
 		oldFile += ".json";
-		os_unlink(oldFile.c_str());
-		oldFile += ".bak";
-		os_unlink(oldFile.c_str());
+		RemoveSceneCollectionFile(oldFile);
 
 		UpdateTitleBar();
 		RefreshSceneCollections();
@@ -363,9 +365,7 @@ void OBSBasic::on_actionRenameSceneCollection_triggered()
 
 	oldFile.insert(0, path);
 	oldFile += ".json";
-	os_unlink(oldFile.c_str());
-	oldFile += ".bak";
-	os_unlink(oldFile.c_str());
+	RemoveSceneCollectionFile(oldFile);
 
 	blog(LOG_INFO, "------------------------------------------------");
 	blog(LOG_INFO, "Renamed scene collection to '%s' (%s.json)",
@@ -439,10 +439,7 @@ void OBSBasic::on_actionRemoveSceneCollection_triggered()
 	};
 
 	auto redo = [this, of = oldFile, newPath](const std::string &) {
-		std::string oldFile = of;
-		os_unlink(oldFile.c_str());
-		oldFile += ".bak";
-		os_unlink(oldFile.c_str());
+		RemoveSceneCollectionFile(of);
 
 		Load(newPath.c_str());
 		RefreshSceneCollections();
@@ -453,9 +450,7 @@ void OBSBasic::on_actionRemoveSceneCollection_triggered()
 			  undo_data, "");
 	obs_data_release(data);
 
-	os_unlink(oldFile.c_str());
-	oldFile += ".bak";
-	os_unlink(oldFile.c_str());
+	RemoveSceneCollectionFile(oldFile);
 
 	Load(newPath.c_str());
 	RefreshSceneCollections();
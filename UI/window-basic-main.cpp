@@ -691,7 +691,7 @@ void OBSBasic::Save(const char *file)
 		obs_data_release(moduleObj);
 	}
 
-	if (!obs_data_save_json_safe(saveData, file, "tmp", "bak"))
+	if (!obs_data_save_json_cached(saveData, file, "tmp", "bak"))
 		blog(LOG_ERROR, "Could not save scene data to %s", file);
 
 	obs_data_release(saveData);
@@ -925,7 +925,7 @@ void OBSBasic::Load(const char *file)
 {
 	disableSaving++;
 
-	obs_data_t *data = obs_data_create_from_json_file_safe(file, "bak");
+	obs_data_t *data = obs_data_create_from_json_file_cached(file, "bak");
 	if (!data) {
 		disableSaving--;
 		blog(LOG_INFO, "No scene file found, creating default scene");
@@ -1489,6 +1489,7 @@ bool OBSBasic::InitBasicConfigDefaults()
 	config_set_default_uint(basicConfig, "Audio", "SampleRate", 48000);
 	config_set_default_string(basicConfig, "Audio", "ChannelSetup",
 				  "Stereo");
+	config_set_default_string(basicConfig, "Audio", "Resampler", "FFmpeg");
 	config_set_default_double(basicConfig, "Audio", "MeterDecayRate",
 				  VOLUME_METER_DECAY_FAST);
 	config_set_default_uint(basicConfig, "Audio", "PeakMeterType", 0);
@@ -4204,7 +4205,7 @@ bool OBSBasic::ResetAudio()
 {
 	ProfileScope("OBSBasic::ResetAudio");
 
-	struct obs_audio_info ai;
+	struct obs_audio_info2 ai;
 	ai.samples_per_sec =
 		config_get_uint(basicConfig, "Audio", "SampleRate");
 
@@ -4226,7 +4227,19 @@ bool OBSBasic::ResetAudio()
 	else
 		ai.speakers = SPEAKERS_STEREO;
 
-	return obs_reset_audio(&ai);
+	const char *resamplerStr =
+		config_get_string(basicConfig, "Audio", "Resampler");
+
+	if (astrcmpi(resamplerStr, "Fast") == 0)
+		ai.resample_type = AUDIO_RESAMPLE_NATIVE_FAST;
+	else if (astrcmpi(resamplerStr, "Medium") == 0)
+		ai.resample_type = AUDIO_RESAMPLE_NATIVE_MEDIUM;
+	else if (astrcmpi(resamplerStr, "High") == 0)
+		ai.resample_type = AUDIO_RESAMPLE_NATIVE_HIGH;
+	else
+		ai.resample_type = AUDIO_RESAMPLE_FFMPEG;
+
+	return obs_reset_audio2(&ai);
 }
 
 void OBSBasic::ResetAudioDevice(const char *sourceId, const char *deviceId,
@@ -5739,6 +5752,32 @@ void OBSBasic::on_actionViewCurrentLog_triggered()
 	}
 }
 
+void OBSBasic::on_actionProfilerTrace_triggered(bool checked)
+{
+	if (checked) {
+		profiler_trace_start(0);
+		return;
+	}
+
+	profiler_trace_stop();
+
+	char logDir[512];
+	if (GetConfigPath(logDir, sizeof(logDir), "obs-studio/logs") <= 0)
+		return;
+
+	std::string name = GenerateTimeDateFilename("json");
+	QString file = SaveFile(this,
+				QTStr("Basic.MainMenu.Help.Logs.SaveProfilerTrace"),
+				QT_UTF8(logDir) + "/" + QT_UTF8(name.c_str()),
+				"JSON Files (*.json)");
+	if (file.isEmpty())
+		return;
+
+	if (!profiler_trace_dump_json(QT_TO_UTF8(file)))
+		blog(LOG_WARNING, "Failed to save profiler trace to '%s'",
+		     QT_TO_UTF8(file));
+}
+
 void OBSBasic::on_actionShowCrashLogs_triggered()
 {
 	char logDir[512];
@@ -892,6 +892,7 @@ private slots:
 	void on_actionUploadCurrentLog_triggered();
 	void on_actionUploadLastLog_triggered();
 	void on_actionViewCurrentLog_triggered();
+	void on_actionProfilerTrace_triggered(bool checked);
 	void on_actionCheckForUpdates_triggered();
 
 	void on_actionShowCrashLogs_triggered();
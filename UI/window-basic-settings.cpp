@@ -510,6 +510,7 @@ OBSBasicSettings::OBSBasicSettings(QWidget *parent)
 	HookWidget(ui->advRBMegsMax,         SCROLL_CHANGED, OUTPUTS_CHANGED);
 	HookWidget(ui->channelSetup,         COMBO_CHANGED,  AUDIO_RESTART);
 	HookWidget(ui->sampleRate,           COMBO_CHANGED,  AUDIO_RESTART);
+	HookWidget(ui->resampler,            COMBO_CHANGED,  AUDIO_RESTART);
 	HookWidget(ui->meterDecayRate,       COMBO_CHANGED,  AUDIO_CHANGED);
 	HookWidget(ui->peakMeterType,        COMBO_CHANGED,  AUDIO_CHANGED);
 	HookWidget(ui->desktopAudioDevice1,  COMBO_CHANGED,  AUDIO_CHANGED);
@@ -903,6 +904,7 @@ OBSBasicSettings::OBSBasicSettings(QWidget *parent)
 
 	channelIndex = ui->channelSetup->currentIndex();
 	sampleRateIndex = ui->sampleRate->currentIndex();
+	resamplerIndex = ui->resampler->currentIndex();
 
 	QRegularExpression rx("\\d{1,5}x\\d{1,5}");
 	QValidator *validator = new QRegularExpressionValidator(rx, this);
@@ -2265,6 +2267,7 @@ void OBSBasicSettings::LoadAudioDevices()
 	if (obs_video_active()) {
 		ui->sampleRate->setEnabled(false);
 		ui->channelSetup->setEnabled(false);
+		ui->resampler->setEnabled(false);
 	}
 }
 
@@ -2412,6 +2415,8 @@ void OBSBasicSettings::LoadAudioSettings()
 		config_get_uint(main->Config(), "Audio", "SampleRate");
 	const char *speakers =
 		config_get_string(main->Config(), "Audio", "ChannelSetup");
+	const char *resampler =
+		config_get_string(main->Config(), "Audio", "Resampler");
 	double meterDecayRate =
 		config_get_double(main->Config(), "Audio", "MeterDecayRate");
 	uint32_t peakMeterTypeIdx =
@@ -2444,6 +2449,15 @@ void OBSBasicSettings::LoadAudioSettings()
 	else
 		ui->channelSetup->setCurrentIndex(1);
 
+	if (astrcmpi(resampler, "Fast") == 0)
+		ui->resampler->setCurrentIndex(1);
+	else if (astrcmpi(resampler, "Medium") == 0)
+		ui->resampler->setCurrentIndex(2);
+	else if (astrcmpi(resampler, "High") == 0)
+		ui->resampler->setCurrentIndex(3);
+	else
+		ui->resampler->setCurrentIndex(0);
+
 	if (meterDecayRate == VOLUME_METER_DECAY_MEDIUM)
 		ui->meterDecayRate->setCurrentIndex(1);
 	else if (meterDecayRate == VOLUME_METER_DECAY_SLOW)
@@ -3530,6 +3544,26 @@ void OBSBasicSettings::SaveAudioSettings()
 		config_set_string(main->Config(), "Audio", "ChannelSetup",
 				  channelSetup);
 
+	if (WidgetChanged(ui->resampler)) {
+		const char *resampler;
+		switch (ui->resampler->currentIndex()) {
+		case 1:
+			resampler = "Fast";
+			break;
+		case 2:
+			resampler = "Medium";
+			break;
+		case 3:
+			resampler = "High";
+			break;
+		default:
+			resampler = "FFmpeg";
+			break;
+		}
+		config_set_string(main->Config(), "Audio", "Resampler",
+				  resampler);
+	}
+
 	if (WidgetChanged(ui->meterDecayRate)) {
 		double meterDecayRate;
 		switch (ui->meterDecayRate->currentIndex()) {
@@ -3691,7 +3725,8 @@ void OBSBasicSettings::SaveSettings()
 
 	bool langChanged = (ui->language->currentIndex() != prevLangIndex);
 	bool audioRestart = (ui->channelSetup->currentIndex() != channelIndex ||
-			     ui->sampleRate->currentIndex() != sampleRateIndex);
+			     ui->sampleRate->currentIndex() != sampleRateIndex ||
+			     ui->resampler->currentIndex() != resamplerIndex);
 	bool browserHWAccelChanged =
 		(ui->browserHWAccel &&
 		 ui->browserHWAccel->isChecked() != prevBrowserAccel);
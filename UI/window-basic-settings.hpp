@@ -120,6 +120,7 @@ private:
 	std::string savedTheme;
 	int sampleRateIndex = 0;
 	int channelIndex = 0;
+	int resamplerIndex = 0;
 
 	int lastSimpleRecQualityIdx = 0;
 	int lastServiceIdx = -1;
@@ -12,6 +12,7 @@
 #include <QHBoxLayout>
 #include <QGridLayout>
 #include <QScreen>
+#include <QStringList>
 
 #include <string>
 
@@ -80,6 +81,7 @@ OBSBasicStats::OBSBasicStats(QWidget *parent, bool closeable)
 	hddSpace = new QLabel(this);
 	recordTimeLeft = new QLabel(this);
 	memUsage = new QLabel(this);
+	audioBuffering = new QLabel(this);
 
 	QString str = MakeTimeLeftText(99999, 59);
 	int textWidth = recordTimeLeft->fontMetrics().boundingRect(str).width();
@@ -89,6 +91,7 @@ OBSBasicStats::OBSBasicStats(QWidget *parent, bool closeable)
 	newStat("HDDSpaceAvailable", hddSpace, 0);
 	newStat("DiskFullIn", recordTimeLeft, 0);
 	newStat("MemoryUsage", memUsage, 0);
+	newStat("AudioBuffering", audioBuffering, 0);
 
 	fps = new QLabel(this);
 	renderTime = new QLabel(this);
@@ -354,6 +357,32 @@ void OBSBasicStats::Update()
 	str = QString::number(num, 'f', 1) + QStringLiteral(" MB");
 	memUsage->setText(str);
 
+	QStringList memTags;
+	for (int i = 0; i < BMEM_TAG_COUNT; i++) {
+		enum bmem_tag tag = (enum bmem_tag)i;
+		struct bmem_tag_stats stats;
+
+		if (!bmem_get_tag_stats(tag, &stats))
+			continue;
+
+		memTags << QString("%1: %2 MB (peak %3 MB, %4 allocations)")
+				   .arg(bmem_get_tag_name(tag),
+					QString::number(stats.bytes / 1048576.0,
+							'f', 1),
+					QString::number(
+						stats.peak_bytes / 1048576.0,
+						'f', 1),
+					QString::number(stats.count));
+	}
+	memUsage->setToolTip(memTags.join("\n"));
+
+	/* ------------------ */
+
+	num = (long double)obs_get_audio_buffering_ns() / 1000000.0l;
+
+	str = QString::number(num, 'f', 0) + QStringLiteral(" ms");
+	audioBuffering->setText(str);
+
 	/* ------------------ */
 
 	num = (long double)obs_get_average_frame_time_ns() / 1000000.0l;
@@ -20,6 +20,7 @@ class OBSBasicStats : public QWidget {
 	QLabel *hddSpace = nullptr;
 	QLabel *recordTimeLeft = nullptr;
 	QLabel *memUsage = nullptr;
+	QLabel *audioBuffering = nullptr;
 
 	QLabel *renderTime = nullptr;
 	QLabel *skippedFrames = nullptr;
@@ -537,6 +537,10 @@ struct gs_texture {
 	struct fbo_info *fbo;
 };
 
+/* number of regions in a persistently mapped unpack buffer, so that a new
+ * frame can be written while the previous ones are still being uploaded */
+#define NUM_UNPACK_REGIONS 3
+
 struct gs_texture_2d {
 	struct gs_texture base;
 
@@ -544,6 +548,12 @@ struct gs_texture_2d {
 	uint32_t height;
 	bool gen_mipmaps;
 	GLuint unpack_buffer;
+
+	/* only used for persistently mapped unpack buffers */
+	uint8_t *unpack_ptr;
+	GLsizeiptr unpack_size;
+	uint32_t unpack_idx;
+	GLsync unpack_fences[NUM_UNPACK_REGIONS];
 };
 
 struct gs_texture_3d {
@@ -613,6 +623,7 @@ static inline void fbo_info_destroy(struct fbo_info *fbo)
 struct gs_device {
 	struct gl_platform *plat;
 	enum copy_type copy_type;
+	bool persistent_unpack;
 
 	GLuint empty_vao;
 	gs_samplerstate_t *raw_load_sampler;
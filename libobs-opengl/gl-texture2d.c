@@ -45,6 +45,33 @@ static bool upload_texture_2d(struct gs_texture_2d *tex, const uint8_t **data)
 	return success;
 }
 
+/* maps the whole buffer once and leaves it mapped, which saves the map and
+ * unmap round trips, and lets the upload from one region run while the
+ * next frame is written to another one */
+static bool create_persistent_unpack_buffer(struct gs_texture_2d *tex,
+					    GLsizeiptr size)
+{
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+				 GL_MAP_COHERENT_BIT;
+	GLsizeiptr region_size = (size + 255) & ~(GLsizeiptr)255;
+
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER,
+			region_size * NUM_UNPACK_REGIONS, NULL, flags);
+	if (!gl_success("glBufferStorage"))
+		return false;
+
+	tex->unpack_ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+					   region_size * NUM_UNPACK_REGIONS,
+					   flags);
+	if (!gl_success("glMapBufferRange") || !tex->unpack_ptr) {
+		tex->unpack_ptr = NULL;
+		return false;
+	}
+
+	tex->unpack_size = region_size;
+	return true;
+}
+
 static bool create_pixel_unpack_buffer(struct gs_texture_2d *tex)
 {
 	GLsizeiptr size;
@@ -66,6 +93,23 @@ static bool create_pixel_unpack_buffer(struct gs_texture_2d *tex)
 		size /= 8;
 	}
 
+	if (tex->base.device->persistent_unpack) {
+		if (create_persistent_unpack_buffer(tex, size))
+			return gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		/* buffer storage is immutable, so start over with a new
+		 * buffer for the regular path */
+		blog(LOG_DEBUG, "Persistent unpack buffer unavailable, "
+				"falling back to glMapBuffer");
+		gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		gl_delete_buffers(1, &tex->unpack_buffer);
+
+		if (!gl_gen_buffers(1, &tex->unpack_buffer))
+			return false;
+		if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex->unpack_buffer))
+			return false;
+	}
+
 	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_DYNAMIC_DRAW);
 	if (!gl_success("glBufferData"))
 		success = false;
@@ -155,6 +199,10 @@ void gs_texture_destroy(gs_texture_t *tex)
 		if (tex->type == GS_TEXTURE_2D) {
 			struct gs_texture_2d *tex2d =
 				(struct gs_texture_2d *)tex;
+			for (size_t i = 0; i < NUM_UNPACK_REGIONS; i++) {
+				if (tex2d->unpack_fences[i])
+					glDeleteSync(tex2d->unpack_fences[i]);
+			}
 			if (tex2d->unpack_buffer)
 				gl_delete_buffers(1, &tex2d->unpack_buffer);
 		} else if (tex->type == GS_TEXTURE_3D) {
@@ -209,6 +257,38 @@ bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr, uint32_t *linesize)
 		goto fail;
 	}
 
+	if (tex2d->unpack_ptr) {
+		GLsync *fence = &tex2d->unpack_fences[tex2d->unpack_idx];
+
+		/* only blocks if the upload from this region, which was
+		 * issued NUM_UNPACK_REGIONS uploads ago, is still running */
+		if (*fence) {
+			GLenum ret = glClientWaitSync(
+				*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+
+			/* the region is still being read, so writing to it
+			 * would corrupt that upload.  the fence is kept, so
+			 * the next map waits on it again */
+			if (ret == GL_TIMEOUT_EXPIRED) {
+				blog(LOG_WARNING, "gs_texture_map (GL): timed "
+						  "out waiting for upload");
+				goto fail;
+			}
+
+			glDeleteSync(*fence);
+			*fence = NULL;
+
+			if (ret == GL_WAIT_FAILED) {
+				gl_success("glClientWaitSync");
+				goto fail;
+			}
+		}
+
+		*ptr = tex2d->unpack_ptr +
+		       tex2d->unpack_idx * tex2d->unpack_size;
+		goto success;
+	}
+
 	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex2d->unpack_buffer))
 		goto fail;
 
@@ -218,6 +298,7 @@ bool gs_texture_map(gs_texture_t *tex, uint8_t **ptr, uint32_t *linesize)
 
 	gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
+success:
 	*linesize = tex2d->width * gs_get_format_bpp(tex->format) / 8;
 	*linesize = (*linesize + 3) & 0xFFFFFFFC;
 	return true;
@@ -227,12 +308,47 @@ fail:
 	return false;
 }
 
+static void unmap_persistent(struct gs_texture_2d *tex2d)
+{
+	struct gs_texture *tex = &tex2d->base;
+	GLsizeiptr offset = tex2d->unpack_idx * tex2d->unpack_size;
+
+	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex2d->unpack_buffer))
+		goto failed;
+	if (!gl_bind_texture(GL_TEXTURE_2D, tex->texture))
+		goto failed;
+
+	/* the storage already exists, so just update it in place */
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tex2d->width, tex2d->height,
+			tex->gl_format, tex->gl_type, (const void *)offset);
+	if (!gl_success("glTexSubImage2D"))
+		goto failed;
+
+	tex2d->unpack_fences[tex2d->unpack_idx] =
+		glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	tex2d->unpack_idx = (tex2d->unpack_idx + 1) % NUM_UNPACK_REGIONS;
+
+	gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	gl_bind_texture(GL_TEXTURE_2D, 0);
+	return;
+
+failed:
+	gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	gl_bind_texture(GL_TEXTURE_2D, 0);
+	blog(LOG_ERROR, "gs_texture_unmap (GL) failed");
+}
+
 void gs_texture_unmap(gs_texture_t *tex)
 {
 	struct gs_texture_2d *tex2d = (struct gs_texture_2d *)tex;
 	if (!is_texture_2d(tex, "gs_texture_unmap"))
 		goto failed;
 
+	if (tex2d->unpack_ptr) {
+		unmap_persistent(tex2d);
+		return;
+	}
+
 	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, tex2d->unpack_buffer))
 		goto failed;
 
@@ -33,6 +33,10 @@ struct signal_info {
 	pthread_mutex_t mutex;
 	bool signalling;
 
+	/* mirrors callbacks.num so emitting a signal nobody is connected to
+	 * doesn't have to take the mutex */
+	volatile long num_callbacks;
+
 	struct signal_info *next;
 };
 
@@ -51,6 +55,7 @@ static inline struct signal_info *signal_info_create(struct decl_info *info)
 	si->func = *info;
 	si->next = NULL;
 	si->signalling = false;
+	si->num_callbacks = 0;
 	da_init(si->callbacks);
 
 	if (pthread_mutex_init(&si->mutex, &attr) != 0) {
@@ -102,6 +107,7 @@ struct signal_handler {
 
 	DARRAY(struct global_callback_info) global_callbacks;
 	pthread_mutex_t global_callbacks_mutex;
+	volatile long num_global_callbacks;
 };
 
 static struct signal_info *getsignal(signal_handler_t *handler,
@@ -239,8 +245,11 @@ static void signal_handler_connect_internal(signal_handler_t *handler,
 		os_atomic_inc_long(&handler->refs);
 
 	idx = signal_get_callback_idx(sig, callback, data);
-	if (keep_ref || idx == DARRAY_INVALID)
+	if (keep_ref || idx == DARRAY_INVALID) {
 		da_push_back(sig->callbacks, &cb_data);
+		os_atomic_set_long(&sig->num_callbacks,
+				   (long)sig->callbacks.num);
+	}
 
 	pthread_mutex_unlock(&sig->mutex);
 }
@@ -291,6 +300,8 @@ void signal_handler_disconnect(signal_handler_t *handler, const char *signal,
 		} else {
 			keep_ref = sig->callbacks.array[idx].keep_ref;
 			da_erase(sig->callbacks, idx);
+			os_atomic_set_long(&sig->num_callbacks,
+					   (long)sig->callbacks.num);
 		}
 	}
 
@@ -312,13 +323,29 @@ void signal_handler_remove_current(void)
 		current_global_cb->remove = true;
 }
 
-void signal_handler_signal(signal_handler_t *handler, const char *signal,
-			   calldata_t *params)
+signal_handle_t *signal_handler_get_handle(signal_handler_t *handler,
+					   const char *signal)
 {
 	struct signal_info *sig = getsignal_locked(handler, signal);
+
+	if (handler && !sig)
+		blog(LOG_WARNING,
+		     "signal_handler_get_handle: "
+		     "signal '%s' not found",
+		     signal);
+
+	return sig;
+}
+
+static void signal_emit(signal_handler_t *handler, struct signal_info *sig,
+			calldata_t *params)
+{
+	const char *signal = sig->func.name;
 	long remove_refs = 0;
 
-	if (!sig)
+	/* nothing connected, so skip both locks entirely */
+	if (!os_atomic_load_long(&sig->num_callbacks) &&
+	    !os_atomic_load_long(&handler->num_global_callbacks))
 		return;
 
 	pthread_mutex_lock(&sig->mutex);
@@ -343,6 +370,8 @@ void signal_handler_signal(signal_handler_t *handler, const char *signal,
 		}
 	}
 
+	os_atomic_set_long(&sig->num_callbacks, (long)sig->callbacks.num);
+
 	sig->signalling = false;
 	pthread_mutex_unlock(&sig->mutex);
 
@@ -369,6 +398,9 @@ void signal_handler_signal(signal_handler_t *handler, const char *signal,
 			if (cb->remove && !cb->signaling)
 				da_erase(handler->global_callbacks, i - 1);
 		}
+
+		os_atomic_set_long(&handler->num_global_callbacks,
+				   (long)handler->global_callbacks.num);
 	}
 
 	pthread_mutex_unlock(&handler->global_callbacks_mutex);
@@ -380,6 +412,22 @@ void signal_handler_signal(signal_handler_t *handler, const char *signal,
 	}
 }
 
+void signal_handler_signal(signal_handler_t *handler, const char *signal,
+			   calldata_t *params)
+{
+	struct signal_info *sig = getsignal_locked(handler, signal);
+
+	if (sig)
+		signal_emit(handler, sig, params);
+}
+
+void signal_handler_signal_handle(signal_handler_t *handler,
+				  signal_handle_t *sig, calldata_t *params)
+{
+	if (handler && sig)
+		signal_emit(handler, sig, params);
+}
+
 void signal_handler_connect_global(signal_handler_t *handler,
 				   global_signal_callback_t callback,
 				   void *data)
@@ -393,8 +441,11 @@ void signal_handler_connect_global(signal_handler_t *handler,
 	pthread_mutex_lock(&handler->global_callbacks_mutex);
 
 	idx = da_find(handler->global_callbacks, &cb_data, 0);
-	if (idx == DARRAY_INVALID)
+	if (idx == DARRAY_INVALID) {
 		da_push_back(handler->global_callbacks, &cb_data);
+		os_atomic_set_long(&handler->num_global_callbacks,
+				   (long)handler->global_callbacks.num);
+	}
 
 	pthread_mutex_unlock(&handler->global_callbacks_mutex);
 }
@@ -416,10 +467,13 @@ void signal_handler_disconnect_global(signal_handler_t *handler,
 		struct global_callback_info *cb =
 			handler->global_callbacks.array + idx;
 
-		if (cb->signaling)
+		if (cb->signaling) {
 			cb->remove = true;
-		else
+		} else {
 			da_erase(handler->global_callbacks, idx);
+			os_atomic_set_long(&handler->num_global_callbacks,
+					   (long)handler->global_callbacks.num);
+		}
 	}
 
 	pthread_mutex_unlock(&handler->global_callbacks_mutex);
@@ -32,7 +32,9 @@ extern "C" {
  */
 
 struct signal_handler;
+struct signal_info;
 typedef struct signal_handler signal_handler_t;
+typedef struct signal_info signal_handle_t;
 typedef void (*global_signal_callback_t)(void *, const char *, calldata_t *);
 typedef void (*signal_callback_t)(void *, calldata_t *);
 
@@ -78,6 +80,17 @@ EXPORT void signal_handler_remove_current(void);
 EXPORT void signal_handler_signal(signal_handler_t *handler, const char *signal,
 				  calldata_t *params);
 
+/*
+ * Resolves a signal name once, so that frequently emitted signals don't have
+ * to be looked up by name every time.  The handle stays valid for as long as
+ * the signal handler exists.
+ */
+EXPORT signal_handle_t *signal_handler_get_handle(signal_handler_t *handler,
+						  const char *signal);
+EXPORT void signal_handler_signal_handle(signal_handler_t *handler,
+					 signal_handle_t *signal,
+					 calldata_t *params);
+
 #ifdef __cplusplus
 }
 #endif
@@ -68,6 +68,7 @@ struct audio_output {
 
 	audio_input_callback_t input_cb;
 	void *input_param;
+	int catch_up_ticks;
 	pthread_mutex_t input_mutex;
 	struct audio_mix mixes[MAX_AUDIO_MIXES];
 };
@@ -207,6 +208,7 @@ static void *audio_thread(void *param)
 		audio_frames_to_ns(rate, AUDIO_OUTPUT_FRAMES) / 1000000);
 
 	os_set_thread_name("audio-io: audio thread");
+	bmem_set_thread_tag(BMEM_TAG_AUDIO);
 
 	const char *audio_thread_name =
 		profile_store_name(obs_get_profiler_name_store(),
@@ -227,6 +229,11 @@ static void *audio_thread(void *param)
 
 			input_and_output(audio, audio_time, prev_time);
 			prev_time = audio_time;
+
+			while (audio->catch_up_ticks) {
+				audio->catch_up_ticks--;
+				input_and_output(audio, prev_time, prev_time);
+			}
 		}
 
 		profile_end(audio_thread_name);
@@ -270,7 +277,8 @@ static inline bool audio_input_init(struct audio_input *input,
 			.samples_per_sec = input->conversion.samples_per_sec,
 			.speakers = input->conversion.speakers};
 
-		input->resampler = audio_resampler_create(&to, &from);
+		input->resampler = audio_resampler_create2(
+			&to, &from, audio->info.resample_type);
 		if (!input->resampler) {
 			blog(LOG_ERROR, "audio_input_init: Failed to "
 					"create resampler");
@@ -417,6 +425,12 @@ void audio_output_close(audio_t *audio)
 	bfree(audio);
 }
 
+void audio_output_request_catch_up(audio_t *audio)
+{
+	if (audio)
+		audio->catch_up_ticks++;
+}
+
 const struct audio_output_info *audio_output_get_info(const audio_t *audio)
 {
 	return audio ? &audio->info : NULL;
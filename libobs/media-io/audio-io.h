@@ -75,6 +75,14 @@ enum speaker_layout {
 	SPEAKERS_7POINT1 = 8, /**< Channels: FL, FR, FC, LFE, RL, RR, SL, SR */
 };
 
+/* declared here so that audio outputs can carry it, see audio-resampler.h */
+enum audio_resample_type {
+	AUDIO_RESAMPLE_FFMPEG,        /**< libswresample, the default */
+	AUDIO_RESAMPLE_NATIVE_FAST,   /**< Native, 16 tap filter */
+	AUDIO_RESAMPLE_NATIVE_MEDIUM, /**< Native, 32 tap filter */
+	AUDIO_RESAMPLE_NATIVE_HIGH,   /**< Native, 64 tap filter */
+};
+
 struct audio_data {
 	uint8_t *data[MAX_AV_PLANES];
 	uint32_t frames;
@@ -97,6 +105,9 @@ struct audio_output_info {
 	enum audio_format format;
 	enum speaker_layout speakers;
 
+	/* resampler used for connections that need a conversion */
+	enum audio_resample_type resample_type;
+
 	audio_input_callback_t input_callback;
 	void *input_param;
 };
@@ -210,6 +221,14 @@ static inline uint64_t ns_to_audio_frames(size_t sample_rate, uint64_t frames)
 EXPORT int audio_output_open(audio_t **audio, struct audio_output_info *info);
 EXPORT void audio_output_close(audio_t *audio);
 
+/*
+ * Only valid from within the input callback.  Once the callback returns, it
+ * is called once more right away with start_ts equal to end_ts, without the
+ * audio clock advancing, so that it can output audio it already has buffered
+ * and catch up after its buffering has been reduced.
+ */
+EXPORT void audio_output_request_catch_up(audio_t *audio);
+
 typedef void (*audio_output_callback_t)(void *param, size_t mix_idx,
 					struct audio_data *data);
 
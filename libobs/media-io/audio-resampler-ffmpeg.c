@@ -17,12 +17,15 @@
 
 #include "../util/bmem.h"
 #include "audio-resampler.h"
+#include "audio-resampler-native.h"
 #include "audio-io.h"
 #include <libavutil/avutil.h>
 #include <libavformat/avformat.h>
 #include <libswresample/swresample.h>
 
 struct audio_resampler {
+	struct native_resampler *native;
+
 	struct SwrContext *context;
 	bool opened;
 
@@ -148,9 +151,31 @@ audio_resampler_t *audio_resampler_create(const struct resample_info *dst,
 	return rs;
 }
 
+audio_resampler_t *audio_resampler_create2(const struct resample_info *dst,
+					   const struct resample_info *src,
+					   enum audio_resample_type type)
+{
+	struct audio_resampler *rs;
+	struct native_resampler *native;
+
+	if (type == AUDIO_RESAMPLE_FFMPEG)
+		return audio_resampler_create(dst, src);
+
+	/* libobs passes the configured type for every conversion, so don't
+	 * fail one that libswresample can still do */
+	native = native_resampler_create(dst, src, type);
+	if (!native)
+		return audio_resampler_create(dst, src);
+
+	rs = bzalloc(sizeof(struct audio_resampler));
+	rs->native = native;
+	return rs;
+}
+
 void audio_resampler_destroy(audio_resampler_t *rs)
 {
 	if (rs) {
+		native_resampler_destroy(rs->native);
 		if (rs->context)
 			swr_free(&rs->context);
 		if (rs->output_buffer[0])
@@ -166,6 +191,10 @@ bool audio_resampler_resample(audio_resampler_t *rs, uint8_t *output[],
 {
 	if (!rs)
 		return false;
+	if (rs->native)
+		return native_resampler_resample(rs->native, output,
+						 out_frames, ts_offset, input,
+						 in_frames);
 
 	struct SwrContext *context = rs->context;
 	int ret;
@@ -0,0 +1,861 @@
+/******************************************************************************
+    Copyright (C) 2026 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <math.h>
+#include <string.h>
+
+#include "../util/bmem.h"
+#include "../util/base.h"
+#include "../util/sse-intrin.h"
+#include "../util/util_uint64.h"
+#include "audio-resampler-native.h"
+
+#ifndef M_PI
+#define M_PI 3.1415926535897932384626433832795
+#endif
+#ifndef M_SQRT1_2
+#define M_SQRT1_2 0.70710678118654752440
+#endif
+
+/*
+ *   Windowed sinc polyphase resampler.  The filter bank holds one set of
+ * taps for every fractional position between two input samples.  When the
+ * rate ratio needs more positions than MAX_PHASES, the two nearest sets of
+ * taps are interpolated instead.
+ *
+ *   Output sample n lines up exactly with input time n * in_rate / out_rate,
+ * and the position of the next output sample is tracked as an exact
+ * fraction of an input sample, which is what the timestamp offset is
+ * derived from.
+ */
+
+#define MAX_PHASES 1024
+
+struct resample_preset {
+	int taps;
+	double cutoff;
+	double beta;
+};
+
+/* clang-format off */
+static const struct resample_preset presets[] = {
+	[AUDIO_RESAMPLE_NATIVE_FAST]   = {16, 0.91, 6.0},
+	[AUDIO_RESAMPLE_NATIVE_MEDIUM] = {32, 0.97, 9.0},
+	[AUDIO_RESAMPLE_NATIVE_HIGH]   = {64, 0.97, 12.0},
+};
+/* clang-format on */
+
+struct float_planes {
+	float *data;
+	size_t capacity;
+	size_t channels;
+	float *ch[MAX_AUDIO_CHANNELS];
+};
+
+struct native_resampler {
+	uint32_t in_rate;
+	uint32_t out_rate;
+	enum audio_format in_format;
+	enum audio_format out_format;
+	size_t in_ch;
+	size_t out_ch;
+
+	/* out_ch x in_ch, NULL when the layouts are the same */
+	float *matrix;
+
+	/* filter bank, num_phases + 1 rows of taps */
+	bool resample;
+	float *bank;
+	size_t taps;
+	size_t num_phases;
+
+	/* input step per output sample, as whole samples plus a fraction of
+	 * den, where den = out_rate / gcd */
+	uint32_t den;
+	uint32_t step_int;
+	uint32_t step_frac;
+
+	/* input history, and the position of the next output sample in it */
+	struct float_planes history;
+	size_t history_len;
+	size_t pos;
+	uint32_t frac;
+
+	struct float_planes in_buf;
+	struct float_planes remix_buf;
+	struct float_planes resample_buf;
+
+	uint8_t *output[MAX_AV_PLANES];
+	size_t output_capacity;
+};
+
+/* ------------------------------------------------------------------------- */
+
+static void planes_free(struct float_planes *planes)
+{
+	bfree(planes->data);
+	memset(planes, 0, sizeof(*planes));
+}
+
+static void planes_reserve(struct float_planes *planes, size_t channels,
+			   size_t frames, size_t keep)
+{
+	float *data;
+
+	planes->channels = channels;
+	if (frames <= planes->capacity)
+		return;
+
+	/* keep some headroom so that varying packet sizes don't cause a
+	 * reallocation every time */
+	frames += frames / 2;
+	data = bmalloc(sizeof(float) * frames * (channels ? channels : 1));
+
+	for (size_t c = 0; c < channels; c++) {
+		float *ch = data + c * frames;
+		if (keep)
+			memcpy(ch, planes->ch[c], keep * sizeof(float));
+		planes->ch[c] = ch;
+	}
+
+	bfree(planes->data);
+	planes->data = data;
+	planes->capacity = frames;
+}
+
+/* ------------------------------------------------------------------------- */
+/* channel remixing                                                          */
+
+enum speaker_pos {
+	POS_FL,
+	POS_FR,
+	POS_FC,
+	POS_LFE,
+	POS_BL,
+	POS_BR,
+	POS_BC,
+	POS_SL,
+	POS_SR,
+	POS_COUNT,
+};
+
+static size_t get_positions(enum speaker_layout layout,
+			    enum speaker_pos pos[MAX_AUDIO_CHANNELS])
+{
+	static const enum speaker_pos mono[] = {POS_FC};
+	static const enum speaker_pos stereo[] = {POS_FL, POS_FR};
+	static const enum speaker_pos l_2point1[] = {POS_FL, POS_FR, POS_LFE};
+	static const enum speaker_pos l_4point0[] = {POS_FL, POS_FR, POS_FC,
+						     POS_BC};
+	static const enum speaker_pos l_4point1[] = {POS_FL, POS_FR, POS_FC,
+						     POS_LFE, POS_BC};
+	static const enum speaker_pos l_5point1[] = {POS_FL,  POS_FR, POS_FC,
+						     POS_LFE, POS_BL, POS_BR};
+	static const enum speaker_pos l_7point1[] = {POS_FL, POS_FR, POS_FC,
+						     POS_LFE, POS_BL, POS_BR,
+						     POS_SL, POS_SR};
+	const enum speaker_pos *list = NULL;
+	size_t count = get_audio_channels(layout);
+
+	switch (layout) {
+	case SPEAKERS_MONO:
+		list = mono;
+		break;
+	case SPEAKERS_STEREO:
+		list = stereo;
+		break;
+	case SPEAKERS_2POINT1:
+		list = l_2point1;
+		break;
+	case SPEAKERS_4POINT0:
+		list = l_4point0;
+		break;
+	case SPEAKERS_4POINT1:
+		list = l_4point1;
+		break;
+	case SPEAKERS_5POINT1:
+		list = l_5point1;
+		break;
+	case SPEAKERS_7POINT1:
+		list = l_7point1;
+		break;
+	case SPEAKERS_UNKNOWN:
+		return 0;
+	}
+
+	if (list)
+		memcpy(pos, list, count * sizeof(*list));
+	return list ? count : 0;
+}
+
+struct remix_info {
+	float *matrix;
+	size_t in_ch;
+	int out_idx[POS_COUNT];
+};
+
+static void mix_to(struct remix_info *info, enum speaker_pos pos,
+		   size_t in_idx, float gain)
+{
+	int out = info->out_idx[pos];
+
+	/* the only layout without front left/right is mono */
+	if (out < 0 && (pos == POS_FL || pos == POS_FR)) {
+		out = info->out_idx[POS_FC];
+		gain *= (float)M_SQRT1_2;
+	}
+
+	if (out >= 0)
+		info->matrix[out * info->in_ch + in_idx] += gain;
+}
+
+static inline bool has_pos(const struct remix_info *info, enum speaker_pos pos)
+{
+	return info->out_idx[pos] >= 0;
+}
+
+/* mirrors what libswresample does by default, so that switching between
+ * resamplers doesn't change the mix */
+static float *build_matrix(enum speaker_layout dst, enum speaker_layout src,
+			   bool normalize)
+{
+	/* mono is copied to every channel but the LFE, same as the matrix
+	 * the ffmpeg resampler is set up with */
+	static const float mono_upmix[MAX_AUDIO_CHANNELS][MAX_AUDIO_CHANNELS] =
+		{
+			{1},
+			{1, 1},
+			{1, 1, 0},
+			{1, 1, 1, 1},
+			{1, 1, 1, 0, 1},
+			{1, 1, 1, 1, 1, 1},
+			{1, 1, 1, 0, 1, 1, 1},
+			{1, 1, 1, 0, 1, 1, 1, 1},
+		};
+	const float s = (float)M_SQRT1_2;
+	enum speaker_pos in_pos[MAX_AUDIO_CHANNELS];
+	enum speaker_pos out_pos[MAX_AUDIO_CHANNELS];
+	size_t in_ch = get_positions(src, in_pos);
+	size_t out_ch = get_positions(dst, out_pos);
+	struct remix_info info = {0};
+	float max_sum = 0.0f;
+
+	if (dst == src)
+		return NULL;
+
+	info.in_ch = in_ch;
+	info.matrix = bzalloc(sizeof(float) * in_ch * out_ch);
+
+	if (src == SPEAKERS_MONO) {
+		for (size_t o = 0; o < out_ch; o++)
+			info.matrix[o] = mono_upmix[out_ch - 1][o];
+		return info.matrix;
+	}
+
+	for (size_t i = 0; i < POS_COUNT; i++)
+		info.out_idx[i] = -1;
+	for (size_t o = 0; o < out_ch; o++)
+		info.out_idx[out_pos[o]] = (int)o;
+
+	for (size_t i = 0; i < in_ch; i++) {
+		enum speaker_pos pos = in_pos[i];
+
+		if (has_pos(&info, pos)) {
+			mix_to(&info, pos, i, 1.0f);
+			continue;
+		}
+
+		switch (pos) {
+		case POS_FL:
+		case POS_FR:
+			mix_to(&info, pos, i, 1.0f);
+			break;
+		case POS_FC:
+			mix_to(&info, POS_FL, i, s);
+			mix_to(&info, POS_FR, i, s);
+			break;
+		case POS_LFE:
+			break;
+		case POS_BL:
+		case POS_BR:
+			if (has_pos(&info, POS_SL))
+				mix_to(&info, pos == POS_BL ? POS_SL : POS_SR,
+				       i, 1.0f);
+			else if (has_pos(&info, POS_BC))
+				mix_to(&info, POS_BC, i, s);
+			else
+				mix_to(&info, pos == POS_BL ? POS_FL : POS_FR,
+				       i, s);
+			break;
+		case POS_BC:
+			if (has_pos(&info, POS_BL)) {
+				mix_to(&info, POS_BL, i, s);
+				mix_to(&info, POS_BR, i, s);
+			} else if (has_pos(&info, POS_SL)) {
+				mix_to(&info, POS_SL, i, s);
+				mix_to(&info, POS_SR, i, s);
+			} else {
+				mix_to(&info, POS_FL, i, s);
+				mix_to(&info, POS_FR, i, s);
+			}
+			break;
+		case POS_SL:
+		case POS_SR:
+			if (has_pos(&info, POS_BL))
+				mix_to(&info, pos == POS_SL ? POS_BL : POS_BR,
+				       i, 1.0f);
+			else if (has_pos(&info, POS_BC))
+				mix_to(&info, POS_BC, i, s);
+			else
+				mix_to(&info, pos == POS_SL ? POS_FL : POS_FR,
+				       i, s);
+			break;
+		case POS_COUNT:
+			break;
+		}
+	}
+
+	/* integer output would clip, float output is left alone */
+	if (normalize) {
+		for (size_t o = 0; o < out_ch; o++) {
+			float sum = 0.0f;
+			for (size_t i = 0; i < in_ch; i++)
+				sum += fabsf(info.matrix[o * in_ch + i]);
+			if (sum > max_sum)
+				max_sum = sum;
+		}
+
+		if (max_sum > 1.0f) {
+			for (size_t i = 0; i < in_ch * out_ch; i++)
+				info.matrix[i] /= max_sum;
+		}
+	}
+
+	return info.matrix;
+}
+
+static void remix(const struct native_resampler *rs, float *const out[],
+		  size_t out_ch, float *const in[], size_t in_ch, size_t frames)
+{
+	for (size_t o = 0; o < out_ch; o++) {
+		const float *gains = rs->matrix + o * in_ch;
+		float *dst = out[o];
+		bool first = true;
+
+		for (size_t c = 0; c < in_ch; c++) {
+			const __m128 gain = _mm_set1_ps(gains[c]);
+			const float *src = in[c];
+			size_t i = 0;
+
+			if (gains[c] == 0.0f)
+				continue;
+
+			if (first) {
+				for (; i + 4 <= frames; i += 4)
+					_mm_storeu_ps(dst + i,
+						      _mm_mul_ps(_mm_loadu_ps(
+									 src + i),
+								 gain));
+				for (; i < frames; i++)
+					dst[i] = src[i] * gains[c];
+				first = false;
+				continue;
+			}
+
+			for (; i + 4 <= frames; i += 4) {
+				__m128 v = _mm_mul_ps(_mm_loadu_ps(src + i),
+						      gain);
+				v = _mm_add_ps(_mm_loadu_ps(dst + i), v);
+				_mm_storeu_ps(dst + i, v);
+			}
+			for (; i < frames; i++)
+				dst[i] += src[i] * gains[c];
+		}
+
+		if (first)
+			memset(dst, 0, frames * sizeof(float));
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* sample format conversion                                                  */
+
+static void convert_to_float(float *const out[], const uint8_t *const in[],
+			     enum audio_format format, size_t channels,
+			     size_t frames)
+{
+	bool planar = is_audio_planar(format);
+	size_t stride = planar ? 1 : channels;
+
+	for (size_t c = 0; c < channels; c++) {
+		const uint8_t *src = planar ? in[c] : in[0];
+		size_t first = planar ? 0 : c;
+		float *dst = out[c];
+
+		switch (format) {
+		case AUDIO_FORMAT_U8BIT:
+		case AUDIO_FORMAT_U8BIT_PLANAR:
+			for (size_t i = 0; i < frames; i++)
+				dst[i] = ((float)src[first + i * stride] -
+					  128.0f) *
+					 (1.0f / 128.0f);
+			break;
+		case AUDIO_FORMAT_16BIT:
+		case AUDIO_FORMAT_16BIT_PLANAR: {
+			const int16_t *s16 = (const int16_t *)src + first;
+			for (size_t i = 0; i < frames; i++)
+				dst[i] = (float)s16[i * stride] *
+					 (1.0f / 32768.0f);
+			break;
+		}
+		case AUDIO_FORMAT_32BIT:
+		case AUDIO_FORMAT_32BIT_PLANAR: {
+			const int32_t *s32 = (const int32_t *)src + first;
+			for (size_t i = 0; i < frames; i++)
+				dst[i] = (float)((double)s32[i * stride] *
+						 (1.0 / 2147483648.0));
+			break;
+		}
+		case AUDIO_FORMAT_FLOAT:
+		case AUDIO_FORMAT_FLOAT_PLANAR: {
+			const float *f = (const float *)src + first;
+			if (stride == 1) {
+				memcpy(dst, f, frames * sizeof(float));
+				break;
+			}
+			for (size_t i = 0; i < frames; i++)
+				dst[i] = f[i * stride];
+			break;
+		}
+		case AUDIO_FORMAT_UNKNOWN:
+			break;
+		}
+	}
+}
+
+static inline double clamp_sample(double val, double min, double max)
+{
+	return val < min ? min : (val > max ? max : val);
+}
+
+static void convert_from_float(uint8_t *const out[], float *const in[],
+			       enum audio_format format, size_t channels,
+			       size_t frames)
+{
+	bool planar = is_audio_planar(format);
+	size_t stride = planar ? 1 : channels;
+
+	for (size_t c = 0; c < channels; c++) {
+		uint8_t *dst = planar ? out[c] : out[0];
+		size_t first = planar ? 0 : c;
+		const float *src = in[c];
+
+		switch (format) {
+		case AUDIO_FORMAT_U8BIT:
+		case AUDIO_FORMAT_U8BIT_PLANAR:
+			for (size_t i = 0; i < frames; i++)
+				dst[first + i * stride] = (uint8_t)lrint(
+					clamp_sample(src[i] * 128.0 + 128.0,
+						     0.0, 255.0));
+			break;
+		case AUDIO_FORMAT_16BIT:
+		case AUDIO_FORMAT_16BIT_PLANAR: {
+			int16_t *s16 = (int16_t *)dst + first;
+			for (size_t i = 0; i < frames; i++)
+				s16[i * stride] = (int16_t)lrint(clamp_sample(
+					src[i] * 32768.0, -32768.0, 32767.0));
+			break;
+		}
+		case AUDIO_FORMAT_32BIT:
+		case AUDIO_FORMAT_32BIT_PLANAR: {
+			int32_t *s32 = (int32_t *)dst + first;
+			for (size_t i = 0; i < frames; i++)
+				s32[i * stride] = (int32_t)lrint(
+					clamp_sample(src[i] * 2147483648.0,
+						     -2147483648.0,
+						     2147483647.0));
+			break;
+		}
+		case AUDIO_FORMAT_FLOAT:
+		case AUDIO_FORMAT_FLOAT_PLANAR: {
+			float *f = (float *)dst + first;
+			if (stride == 1) {
+				memcpy(f, src, frames * sizeof(float));
+				break;
+			}
+			for (size_t i = 0; i < frames; i++)
+				f[i * stride] = src[i];
+			break;
+		}
+		case AUDIO_FORMAT_UNKNOWN:
+			break;
+		}
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* filter bank                                                               */
+
+static uint32_t gcd(uint32_t a, uint32_t b)
+{
+	while (b) {
+		uint32_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/* zeroth order modified Bessel function of the first kind */
+static double bessel_i0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+
+	for (int k = 1; k < 64; k++) {
+		term *= (x * 0.5 / k) * (x * 0.5 / k);
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+
+	return sum;
+}
+
+static void build_bank(struct native_resampler *rs,
+		       const struct resample_preset *preset)
+{
+	double factor = rs->out_rate < rs->in_rate
+				? (double)rs->out_rate / (double)rs->in_rate
+				: 1.0;
+	double cutoff = preset->cutoff * factor;
+	double i0_beta = bessel_i0(preset->beta);
+	size_t taps = (size_t)ceil(preset->taps / factor);
+	double half;
+
+	/* whole SSE vectors, and symmetric around the output position */
+	taps = (taps + 3) & ~(size_t)3;
+	half = (double)(taps / 2);
+
+	rs->taps = taps;
+	rs->num_phases = rs->den <= MAX_PHASES ? rs->den : MAX_PHASES;
+	rs->bank = bmalloc(sizeof(float) * taps * (rs->num_phases + 1));
+
+	for (size_t p = 0; p <= rs->num_phases; p++) {
+		float *row = rs->bank + p * taps;
+		double f = (double)p / (double)rs->num_phases;
+		double sum = 0.0;
+
+		for (size_t k = 0; k < taps; k++) {
+			/* distance of this tap's input sample from the
+			 * output position, in input samples */
+			double d = (double)k - (half - 1.0) - f;
+			double x = d / half;
+			double w = x * x < 1.0 ? bessel_i0(preset->beta *
+							   sqrt(1.0 - x * x)) /
+							 i0_beta
+					       : 0.0;
+			double t = M_PI * cutoff * d;
+			double sinc = fabs(t) < 1e-9 ? 1.0 : sin(t) / t;
+
+			row[k] = (float)(cutoff * sinc * w);
+			sum += cutoff * sinc * w;
+		}
+
+		/* unity gain at DC for every phase */
+		for (size_t k = 0; k < taps; k++)
+			row[k] = (float)(row[k] / sum);
+	}
+}
+
+static inline float hsum_ps(__m128 v)
+{
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+	return _mm_cvtss_f32(v);
+}
+
+static inline float dot(const float *x, const float *h, size_t taps)
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	size_t k = 0;
+
+	for (; k + 8 <= taps; k += 8) {
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(x + k),
+						   _mm_loadu_ps(h + k)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(x + k + 4),
+						   _mm_loadu_ps(h + k + 4)));
+	}
+	if (k < taps)
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(x + k),
+						   _mm_loadu_ps(h + k)));
+
+	return hsum_ps(_mm_add_ps(sum0, sum1));
+}
+
+static inline float dot_interp(const float *x, const float *h, size_t taps,
+			       float t)
+{
+	const float *h2 = h + taps;
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+
+	for (size_t k = 0; k < taps; k += 4) {
+		__m128 v = _mm_loadu_ps(x + k);
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(v, _mm_loadu_ps(h + k)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(v, _mm_loadu_ps(h2 + k)));
+	}
+
+	return hsum_ps(_mm_add_ps(sum0,
+				  _mm_mul_ps(_mm_set1_ps(t),
+					     _mm_sub_ps(sum1, sum0))));
+}
+
+/* produces every output sample the history has enough input for, and
+ * returns how many.  pos and frac are only updated by the caller */
+static size_t resample_channel(const struct native_resampler *rs, float *out,
+			       const float *in, size_t *pos_io,
+			       uint32_t *frac_io)
+{
+	const size_t half = rs->taps / 2;
+	const bool exact = rs->num_phases == rs->den;
+	size_t pos = *pos_io;
+	uint32_t frac = *frac_io;
+	size_t count = 0;
+
+	while (pos + half < rs->history_len) {
+		const float *x = in + pos + 1 - half;
+
+		if (exact) {
+			out[count++] = dot(x, rs->bank + frac * rs->taps,
+					   rs->taps);
+		} else {
+			uint64_t p = (uint64_t)frac * rs->num_phases;
+			size_t phase = (size_t)(p / rs->den);
+			float t = (float)(p % rs->den) / (float)rs->den;
+
+			out[count++] = dot_interp(
+				x, rs->bank + phase * rs->taps, rs->taps, t);
+		}
+
+		pos += rs->step_int;
+		frac += rs->step_frac;
+		if (frac >= rs->den) {
+			frac -= rs->den;
+			pos++;
+		}
+	}
+
+	*pos_io = pos;
+	*frac_io = frac;
+	return count;
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct native_resampler *
+native_resampler_create(const struct resample_info *dst,
+			const struct resample_info *src,
+			enum audio_resample_type type)
+{
+	struct native_resampler *rs;
+	uint32_t div;
+
+	if (type < AUDIO_RESAMPLE_NATIVE_FAST ||
+	    type > AUDIO_RESAMPLE_NATIVE_HIGH)
+		type = AUDIO_RESAMPLE_NATIVE_MEDIUM;
+
+	if (!get_audio_channels(src->speakers) ||
+	    !get_audio_channels(dst->speakers) ||
+	    src->format == AUDIO_FORMAT_UNKNOWN ||
+	    dst->format == AUDIO_FORMAT_UNKNOWN || !src->samples_per_sec ||
+	    !dst->samples_per_sec) {
+		blog(LOG_ERROR, "native resampler: unsupported format");
+		return NULL;
+	}
+
+	rs = bzalloc(sizeof(struct native_resampler));
+	rs->in_rate = src->samples_per_sec;
+	rs->out_rate = dst->samples_per_sec;
+	rs->in_format = src->format;
+	rs->out_format = dst->format;
+	rs->in_ch = get_audio_channels(src->speakers);
+	rs->out_ch = get_audio_channels(dst->speakers);
+	rs->matrix = build_matrix(dst->speakers, src->speakers,
+				  dst->format != AUDIO_FORMAT_FLOAT &&
+					  dst->format !=
+						  AUDIO_FORMAT_FLOAT_PLANAR);
+
+	rs->resample = rs->in_rate != rs->out_rate;
+	if (rs->resample) {
+		size_t channels = rs->in_ch < rs->out_ch ? rs->in_ch
+							 : rs->out_ch;
+
+		div = gcd(rs->in_rate, rs->out_rate);
+		rs->den = rs->out_rate / div;
+		rs->step_int = (rs->in_rate / div) / rs->den;
+		rs->step_frac = (rs->in_rate / div) % rs->den;
+
+		build_bank(rs, &presets[type]);
+
+		/* start with silence up to the first output position, so
+		 * that the first output sample lines up with the first
+		 * input sample */
+		rs->history_len = rs->taps / 2 - 1;
+		rs->pos = rs->history_len;
+		planes_reserve(&rs->history, channels, rs->taps, 0);
+		for (size_t c = 0; c < channels; c++)
+			memset(rs->history.ch[c], 0,
+			       rs->history_len * sizeof(float));
+	}
+
+	return rs;
+}
+
+void native_resampler_destroy(struct native_resampler *rs)
+{
+	if (!rs)
+		return;
+
+	planes_free(&rs->history);
+	planes_free(&rs->in_buf);
+	planes_free(&rs->remix_buf);
+	planes_free(&rs->resample_buf);
+
+	bfree(rs->output[0]);
+	bfree(rs->bank);
+	bfree(rs->matrix);
+	bfree(rs);
+}
+
+static void reserve_output(struct native_resampler *rs, size_t frames)
+{
+	size_t bytes = get_audio_bytes_per_channel(rs->out_format);
+	bool planar = is_audio_planar(rs->out_format);
+	size_t planes = planar ? rs->out_ch : 1;
+	size_t plane_size;
+	uint8_t *data;
+
+	if (rs->output[0] && frames <= rs->output_capacity)
+		return;
+
+	frames += frames / 2 + 1;
+	plane_size = frames * bytes * (planar ? 1 : rs->out_ch);
+	data = bmalloc(plane_size * planes);
+
+	bfree(rs->output[0]);
+	for (size_t i = 0; i < planes; i++)
+		rs->output[i] = data + i * plane_size;
+
+	rs->output_capacity = frames;
+}
+
+static uint64_t get_offset_ns(const struct native_resampler *rs)
+{
+	/* input still waiting in the history past the next output position,
+	 * in units of 1 / den input samples */
+	uint64_t pending = (uint64_t)(rs->history_len - rs->pos) * rs->den -
+			   rs->frac;
+
+	return util_mul_div64(pending, 1000000000ULL,
+			      (uint64_t)rs->den * rs->in_rate);
+}
+
+bool native_resampler_resample(struct native_resampler *rs, uint8_t *output[],
+			       uint32_t *out_frames, uint64_t *ts_offset,
+			       const uint8_t *const input[], uint32_t in_frames)
+{
+	bool remix_first = rs->matrix && rs->out_ch < rs->in_ch;
+	float *const *cur;
+	size_t channels = rs->in_ch;
+	size_t frames = in_frames;
+
+	*ts_offset = rs->resample ? get_offset_ns(rs) : 0;
+
+	planes_reserve(&rs->in_buf, rs->in_ch, in_frames, 0);
+	convert_to_float(rs->in_buf.ch, input, rs->in_format, rs->in_ch,
+			 in_frames);
+	cur = rs->in_buf.ch;
+
+	if (remix_first) {
+		planes_reserve(&rs->remix_buf, rs->out_ch, frames, 0);
+		remix(rs, rs->remix_buf.ch, rs->out_ch, cur, channels, frames);
+		cur = rs->remix_buf.ch;
+		channels = rs->out_ch;
+	}
+
+	if (rs->resample) {
+		size_t keep_from;
+		size_t max_out;
+		size_t count = 0;
+		size_t pos = 0;
+		uint32_t frac = 0;
+
+		planes_reserve(&rs->history, channels,
+			       rs->history_len + frames, rs->history_len);
+		for (size_t c = 0; c < channels; c++)
+			memcpy(rs->history.ch[c] + rs->history_len, cur[c],
+			       frames * sizeof(float));
+		rs->history_len += frames;
+
+		max_out = (size_t)util_mul_div64(rs->history_len,
+						 rs->out_rate, rs->in_rate) +
+			  2;
+		planes_reserve(&rs->resample_buf, channels, max_out, 0);
+
+		for (size_t c = 0; c < channels; c++) {
+			pos = rs->pos;
+			frac = rs->frac;
+			count = resample_channel(rs, rs->resample_buf.ch[c],
+						 rs->history.ch[c], &pos,
+						 &frac);
+		}
+
+		/* only what the next output sample's taps reach back to
+		 * has to be kept */
+		keep_from = pos + 1 - rs->taps / 2;
+		for (size_t c = 0; c < channels; c++)
+			memmove(rs->history.ch[c],
+				rs->history.ch[c] + keep_from,
+				(rs->history_len - keep_from) * sizeof(float));
+
+		rs->history_len -= keep_from;
+		rs->pos = pos - keep_from;
+		rs->frac = frac;
+
+		cur = rs->resample_buf.ch;
+		frames = count;
+	}
+
+	if (rs->matrix && !remix_first) {
+		planes_reserve(&rs->remix_buf, rs->out_ch, frames, 0);
+		remix(rs, rs->remix_buf.ch, rs->out_ch, cur, channels, frames);
+		cur = rs->remix_buf.ch;
+		channels = rs->out_ch;
+	}
+
+	reserve_output(rs, frames);
+	convert_from_float(rs->output, cur, rs->out_format, rs->out_ch,
+			   frames);
+
+	for (size_t i = 0; i < MAX_AV_PLANES && rs->output[i]; i++)
+		output[i] = rs->output[i];
+
+	*out_frames = (uint32_t)frames;
+	return true;
+}
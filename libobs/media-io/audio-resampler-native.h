@@ -0,0 +1,36 @@
+/******************************************************************************
+    Copyright (C) 2026 by Hugh Bailey <obs.jim@gmail.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "audio-resampler.h"
+
+/* polyphase resampler and channel remixer behind the AUDIO_RESAMPLE_NATIVE_*
+ * types of audio_resampler_create2, used through the audio_resampler API */
+
+struct native_resampler;
+
+struct native_resampler *
+native_resampler_create(const struct resample_info *dst,
+			const struct resample_info *src,
+			enum audio_resample_type type);
+void native_resampler_destroy(struct native_resampler *rs);
+
+bool native_resampler_resample(struct native_resampler *rs, uint8_t *output[],
+			       uint32_t *out_frames, uint64_t *ts_offset,
+			       const uint8_t *const input[],
+			       uint32_t in_frames);
@@ -36,6 +36,10 @@ struct resample_info {
 EXPORT audio_resampler_t *
 audio_resampler_create(const struct resample_info *dst,
 		       const struct resample_info *src);
+EXPORT audio_resampler_t *
+audio_resampler_create2(const struct resample_info *dst,
+			const struct resample_info *src,
+			enum audio_resample_type type);
 EXPORT void audio_resampler_destroy(audio_resampler_t *resampler);
 
 EXPORT bool audio_resampler_resample(audio_resampler_t *resampler,
@@ -200,6 +200,18 @@ void convert_uyvx_to_i444(const uint8_t *input, uint32_t in_linesize,
 	}
 }
 
+static FORCE_INLINE void store_0yuv(uint32_t *output, __m128i lum_lo,
+				    __m128i lum_hi, __m128i uv_lo, __m128i uv_hi)
+{
+	_mm_storeu_si128((__m128i *)output, _mm_unpacklo_epi16(uv_lo, lum_lo));
+	_mm_storeu_si128((__m128i *)(output + 4),
+			 _mm_unpackhi_epi16(uv_lo, lum_lo));
+	_mm_storeu_si128((__m128i *)(output + 8),
+			 _mm_unpacklo_epi16(uv_hi, lum_hi));
+	_mm_storeu_si128((__m128i *)(output + 12),
+			 _mm_unpackhi_epi16(uv_hi, lum_hi));
+}
+
 void decompress_420(const uint8_t *const input[], const uint32_t in_linesize[],
 		    uint32_t start_y, uint32_t end_y, uint8_t *output,
 		    uint32_t out_linesize)
@@ -209,6 +221,8 @@ void decompress_420(const uint8_t *const input[], const uint32_t in_linesize[],
 	uint32_t height_d2 = end_y / 2;
 	uint32_t y;
 
+	__m128i zero = _mm_setzero_si128();
+
 	for (y = start_y_d2; y < height_d2; y++) {
 		const uint8_t *chroma0 = input[1] + y * in_linesize[1];
 		const uint8_t *chroma1 = input[2] + y * in_linesize[2];
@@ -221,7 +235,35 @@ void decompress_420(const uint8_t *const input[], const uint32_t in_linesize[],
 		output0 = (uint32_t *)(output + y * 2 * out_linesize);
 		output1 = (uint32_t *)((uint8_t *)output0 + out_linesize);
 
-		for (x = 0; x < width_d2; x++) {
+		/* 16 pixels from each of the two lines per iteration */
+		for (x = 0; x + 8 <= width_d2; x += 8) {
+			__m128i u = _mm_loadl_epi64((const __m128i *)chroma0);
+			__m128i v = _mm_loadl_epi64((const __m128i *)chroma1);
+			__m128i uv = _mm_unpacklo_epi8(v, u);
+			__m128i uv_lo = _mm_unpacklo_epi16(uv, uv);
+			__m128i uv_hi = _mm_unpackhi_epi16(uv, uv);
+
+			__m128i l0 = _mm_loadu_si128((const __m128i *)lum0);
+			__m128i l1 = _mm_loadu_si128((const __m128i *)lum1);
+			__m128i l0_lo = _mm_unpacklo_epi8(l0, zero);
+			__m128i l0_hi = _mm_unpackhi_epi8(l0, zero);
+			__m128i l1_lo = _mm_unpacklo_epi8(l1, zero);
+			__m128i l1_hi = _mm_unpackhi_epi8(l1, zero);
+
+			/* chroma word goes in the low half of each output
+			 * dword, luma in the high half */
+			store_0yuv(output0, l0_lo, l0_hi, uv_lo, uv_hi);
+			store_0yuv(output1, l1_lo, l1_hi, uv_lo, uv_hi);
+
+			chroma0 += 8;
+			chroma1 += 8;
+			lum0 += 16;
+			lum1 += 16;
+			output0 += 16;
+			output1 += 16;
+		}
+
+		for (; x < width_d2; x++) {
 			uint32_t out;
 			out = (*(chroma0++) << 8) | *(chroma1++);
 
@@ -234,6 +276,16 @@ void decompress_420(const uint8_t *const input[], const uint32_t in_linesize[],
 	}
 }
 
+/* builds 4 output pixels of 0x00VVUUYY from the low 4 luma bytes of lum8
+ * and 4 chroma words of 0xVVUU, zero-extended to 32 bits */
+static FORCE_INLINE __m128i pack_nv12_pixels(__m128i lum8, __m128i uv32)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i lum32 =
+		_mm_unpacklo_epi16(_mm_unpacklo_epi8(lum8, zero), zero);
+	return _mm_or_si128(lum32, _mm_slli_epi32(uv32, 8));
+}
+
 void decompress_nv12(const uint8_t *const input[], const uint32_t in_linesize[],
 		     uint32_t start_y, uint32_t end_y, uint8_t *output,
 		     uint32_t out_linesize)
@@ -243,6 +295,8 @@ void decompress_nv12(const uint8_t *const input[], const uint32_t in_linesize[],
 	uint32_t height_d2 = end_y / 2;
 	uint32_t y;
 
+	__m128i zero = _mm_setzero_si128();
+
 	for (y = start_y_d2; y < height_d2; y++) {
 		const uint16_t *chroma;
 		register const uint8_t *lum0, *lum1;
@@ -255,7 +309,35 @@ void decompress_nv12(const uint8_t *const input[], const uint32_t in_linesize[],
 		output0 = (uint32_t *)(output + y * 2 * out_linesize);
 		output1 = (uint32_t *)((uint8_t *)output0 + out_linesize);
 
-		for (x = 0; x < width_d2; x++) {
+		/* 8 pixels from each of the two lines per iteration */
+		for (x = 0; x + 4 <= width_d2; x += 4) {
+			__m128i uv = _mm_loadl_epi64((const __m128i *)chroma);
+			__m128i uv_dup = _mm_unpacklo_epi16(uv, uv);
+			__m128i uv_lo = _mm_unpacklo_epi16(uv_dup, zero);
+			__m128i uv_hi = _mm_unpackhi_epi16(uv_dup, zero);
+
+			__m128i l0 = _mm_loadl_epi64((const __m128i *)lum0);
+			__m128i l1 = _mm_loadl_epi64((const __m128i *)lum1);
+
+			_mm_storeu_si128((__m128i *)output0,
+					 pack_nv12_pixels(l0, uv_lo));
+			_mm_storeu_si128(
+				(__m128i *)(output0 + 4),
+				pack_nv12_pixels(_mm_srli_si128(l0, 4), uv_hi));
+			_mm_storeu_si128((__m128i *)output1,
+					 pack_nv12_pixels(l1, uv_lo));
+			_mm_storeu_si128(
+				(__m128i *)(output1 + 4),
+				pack_nv12_pixels(_mm_srli_si128(l1, 4), uv_hi));
+
+			chroma += 4;
+			lum0 += 8;
+			lum1 += 8;
+			output0 += 8;
+			output1 += 8;
+		}
+
+		for (; x < width_d2; x++) {
 			uint32_t out = *(chroma++) << 8;
 
 			*(output0++) = *(lum0++) | out;
@@ -267,6 +349,23 @@ void decompress_nv12(const uint8_t *const input[], const uint32_t in_linesize[],
 	}
 }
 
+/* expands 4 packed 422 dwords to 8 pixels.  keep_mask selects the chroma
+ * bytes and the luma byte of the first pixel, the second pixel gets the
+ * second luma value moved into the place of the first */
+static FORCE_INLINE void decompress_422_4(const uint32_t *input32,
+					  uint32_t *output32,
+					  __m128i keep_mask,
+					  __m128i lum_mask)
+{
+	__m128i dw = _mm_loadu_si128((const __m128i *)input32);
+	__m128i lum = _mm_and_si128(_mm_srli_epi32(dw, 16), lum_mask);
+	__m128i second = _mm_or_si128(_mm_and_si128(dw, keep_mask), lum);
+
+	_mm_storeu_si128((__m128i *)output32, _mm_unpacklo_epi32(dw, second));
+	_mm_storeu_si128((__m128i *)(output32 + 4),
+			 _mm_unpackhi_epi32(dw, second));
+}
+
 void decompress_422(const uint8_t *input, uint32_t in_linesize,
 		    uint32_t start_y, uint32_t end_y, uint8_t *output,
 		    uint32_t out_linesize, bool leading_lum)
@@ -276,14 +375,26 @@ void decompress_422(const uint8_t *input, uint32_t in_linesize,
 
 	register const uint32_t *input32;
 	register const uint32_t *input32_end;
+	register const uint32_t *input32_simd_end;
 	register uint32_t *output32;
 
 	if (leading_lum) {
+		__m128i keep_mask = _mm_set1_epi32((int)0xFFFFFF00);
+		__m128i lum_mask = _mm_set1_epi32(0x000000FF);
+
 		for (y = start_y; y < end_y; y++) {
 			input32 = (const uint32_t *)(input + y * in_linesize);
 			input32_end = input32 + width_d2;
+			input32_simd_end = input32 + (width_d2 & ~3);
 			output32 = (uint32_t *)(output + y * out_linesize);
 
+			while (input32 < input32_simd_end) {
+				decompress_422_4(input32, output32, keep_mask,
+						 lum_mask);
+				output32 += 8;
+				input32 += 4;
+			}
+
 			while (input32 < input32_end) {
 				register uint32_t dw = *input32;
 
@@ -297,11 +408,22 @@ void decompress_422(const uint8_t *input, uint32_t in_linesize,
 			}
 		}
 	} else {
+		__m128i keep_mask = _mm_set1_epi32((int)0xFFFF00FF);
+		__m128i lum_mask = _mm_set1_epi32(0x0000FF00);
+
 		for (y = start_y; y < end_y; y++) {
 			input32 = (const uint32_t *)(input + y * in_linesize);
 			input32_end = input32 + width_d2;
+			input32_simd_end = input32 + (width_d2 & ~3);
 			output32 = (uint32_t *)(output + y * out_linesize);
 
+			while (input32 < input32_simd_end) {
+				decompress_422_4(input32, output32, keep_mask,
+						 lum_mask);
+				output32 += 8;
+				input32 += 4;
+			}
+
 			while (input32 < input32_end) {
 				register uint32_t dw = *input32;
 
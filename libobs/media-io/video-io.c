@@ -175,6 +175,7 @@ static void *video_thread(void *param)
 	struct video_output *video = param;
 
 	os_set_thread_name("video-io: video thread");
+	bmem_set_thread_tag(BMEM_TAG_VIDEO);
 
 	const char *video_thread_name =
 		profile_store_name(obs_get_profiler_name_store(),
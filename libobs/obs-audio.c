@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include "obs-internal.h"
 #include "util/util_uint64.h"
+#include "util/sse-intrin.h"
 
 struct ts_info {
 	uint64_t start;
@@ -28,6 +29,11 @@ struct ts_info {
 #define DEBUG_LAGGED_AUDIO 0
 #define MAX_BUFFERING_TICKS 45
 
+/* buffering is only reduced once every source has had audio to spare for
+ * this long, and then by at most one tick per BUFFERING_SHRINK_STEP_SEC */
+#define BUFFERING_SHRINK_DELAY_SEC 10
+#define BUFFERING_SHRINK_STEP_SEC 1
+
 static void push_audio_tree(obs_source_t *parent, obs_source_t *source, void *p)
 {
 	struct obs_core_audio *audio = p;
@@ -46,9 +52,32 @@ static inline size_t convert_time_to_frames(size_t sample_rate, uint64_t t)
 	return (size_t)util_mul_div64(t, sample_rate, 1000000000ULL);
 }
 
+/* adds one channel of source audio into a mix, four floats at a time.  the
+ * mix pointer is offset by the source's start point, so neither pointer is
+ * guaranteed to be aligned here */
+static inline void mix_audio_channel(float *mix, const float *aud,
+				     size_t count)
+{
+	const float *end = aud + count;
+	const float *end4 = aud + (count & ~(size_t)3);
+
+	while (aud < end4) {
+		__m128 v_mix = _mm_loadu_ps(mix);
+		__m128 v_aud = _mm_loadu_ps(aud);
+		_mm_storeu_ps(mix, _mm_add_ps(v_mix, v_aud));
+
+		mix += 4;
+		aud += 4;
+	}
+
+	while (aud < end)
+		*(mix++) += *(aud++);
+}
+
 static inline void mix_audio(struct audio_output_data *mixes,
-			     obs_source_t *source, size_t channels,
-			     size_t sample_rate, struct ts_info *ts)
+			     obs_source_t *source, uint32_t mixers,
+			     size_t channels, size_t sample_rate,
+			     struct ts_info *ts)
 {
 	size_t total_floats = AUDIO_OUTPUT_FRAMES;
 	size_t start_point = 0;
@@ -65,18 +94,20 @@ static inline void mix_audio(struct audio_output_data *mixes,
 		total_floats -= start_point;
 	}
 
+	/* mixes that the output isn't using or that the source isn't routed
+	 * to have already been zeroed by obs_source_audio_render, so there
+	 * is nothing to add for them */
+	mixers &= source->audio_mixers;
+
 	for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
-		for (size_t ch = 0; ch < channels; ch++) {
-			register float *mix = mixes[mix_idx].data[ch];
-			register float *aud =
-				source->audio_output_buf[mix_idx][ch];
-			register float *end;
+		if ((mixers & (1 << mix_idx)) == 0)
+			continue;
 
-			mix += start_point;
-			end = aud + total_floats;
+		for (size_t ch = 0; ch < channels; ch++) {
+			float *mix = mixes[mix_idx].data[ch] + start_point;
+			float *aud = source->audio_output_buf[mix_idx][ch];
 
-			while (aud < end)
-				*(mix++) += *(aud++);
+			mix_audio_channel(mix, aud, total_floats);
 		}
 	}
 }
@@ -302,6 +333,8 @@ static void add_audio_buffering(struct obs_core_audio *audio,
 	size_t ms;
 	int ticks;
 
+	audio->buffering_stable_ticks = 0;
+
 	if (audio->total_buffering_ticks == MAX_BUFFERING_TICKS)
 		return;
 
@@ -364,6 +397,67 @@ static void add_audio_buffering(struct obs_core_audio *audio,
 	*ts = new_ts;
 }
 
+/* whether a source has enough audio queued past next_ts for the mix to
+ * output one extra tick right away and still have the following tick */
+static bool audio_source_has_spare_tick(struct obs_source *source,
+					size_t sample_rate, uint64_t next_ts)
+{
+	size_t needed = AUDIO_OUTPUT_FRAMES * 2;
+	size_t queued;
+
+	/* composite sources have no queue of their own, and sources without
+	 * a timestamp aren't currently producing audio */
+	if (source->info.audio_render || !source->audio_ts)
+		return true;
+
+	if (source->audio_ts > next_ts) {
+		size_t ahead = convert_time_to_frames(
+			sample_rate, source->audio_ts - next_ts);
+		if (ahead >= needed)
+			return true;
+
+		needed -= ahead;
+	}
+
+	queued = source->audio_input_buf[0].size / sizeof(float);
+	return queued >= needed;
+}
+
+static void reduce_audio_buffering(struct obs_core_audio *audio,
+				   size_t sample_rate, bool can_reduce)
+{
+	int delay_ticks = (int)(sample_rate * BUFFERING_SHRINK_DELAY_SEC /
+				AUDIO_OUTPUT_FRAMES);
+	int step_ticks = (int)(sample_rate * BUFFERING_SHRINK_STEP_SEC /
+			       AUDIO_OUTPUT_FRAMES);
+	size_t ms;
+	size_t total_ms;
+
+	if (!can_reduce || !audio->total_buffering_ticks ||
+	    audio->buffering_wait_ticks) {
+		audio->buffering_stable_ticks = 0;
+		return;
+	}
+
+	if (++audio->buffering_stable_ticks < delay_ticks)
+		return;
+
+	/* the audio thread calls back right away to output the tick that is
+	 * now one too many, so no audio is dropped and outputs stay in sync */
+	audio->total_buffering_ticks--;
+	audio->buffering_stable_ticks = delay_ticks - step_ticks;
+	audio_output_request_catch_up(audio->audio);
+
+	ms = AUDIO_OUTPUT_FRAMES * 1000 / sample_rate;
+	total_ms = audio->total_buffering_ticks * AUDIO_OUTPUT_FRAMES * 1000 /
+		   sample_rate;
+
+	blog(LOG_INFO,
+	     "removing %d milliseconds of audio buffering, total "
+	     "audio buffering is now %d milliseconds",
+	     (int)ms, (int)total_ms);
+}
+
 static bool audio_buffer_insuffient(struct obs_source *source,
 				    size_t sample_rate, uint64_t min_ts)
 {
@@ -441,6 +535,70 @@ static inline void release_audio_sources(struct obs_core_audio *audio)
 		obs_source_release(audio->render_order.array[i]);
 }
 
+static const char *render_audio_sources_name = "render_audio_sources";
+static const char *audio_mix_name = "mix_audio";
+
+static void render_audio_source(struct obs_core_audio *audio,
+				obs_source_t *source, uint32_t mixers,
+				size_t channels, size_t sample_rate,
+				uint64_t start_ts)
+{
+	size_t audio_size = AUDIO_OUTPUT_FRAMES * sizeof(float);
+	const char *profile_name = obs_source_get_profile_name(
+		source, &source->profile_audio_render_name,
+		"audio_render(%s)");
+
+	profile_start(profile_name);
+
+	obs_source_audio_render(source, mixers, channels, sample_rate,
+				audio_size);
+
+	/* if a source has gone backward in time and we can no
+	 * longer buffer, drop some or all of its audio */
+	if (audio->total_buffering_ticks == MAX_BUFFERING_TICKS &&
+	    source->audio_ts < start_ts) {
+		if (source->info.audio_render) {
+			blog(LOG_DEBUG,
+			     "render audio source %s timestamp has "
+			     "gone backwards",
+			     obs_source_get_name(source));
+
+			/* just avoid further damage */
+			source->audio_pending = true;
+#if DEBUG_AUDIO == 1
+			/* this should really be fixed */
+			assert(false);
+#endif
+		} else {
+			pthread_mutex_lock(&source->audio_buf_mutex);
+			bool rerender = ignore_audio(source, channels,
+						     sample_rate, start_ts);
+			pthread_mutex_unlock(&source->audio_buf_mutex);
+
+			/* if we (potentially) recovered, re-render */
+			if (rerender)
+				obs_source_audio_render(source, mixers,
+							channels, sample_rate,
+							audio_size);
+		}
+	}
+
+	profile_end(profile_name);
+}
+
+static void render_audio_sources(struct obs_core_audio *audio, uint32_t mixers,
+				 size_t channels, size_t sample_rate,
+				 uint64_t start_ts)
+{
+	profile_start(render_audio_sources_name);
+
+	for (size_t i = 0; i < audio->render_order.num; i++)
+		render_audio_source(audio, audio->render_order.array[i],
+				    mixers, channels, sample_rate, start_ts);
+
+	profile_end(render_audio_sources_name);
+}
+
 bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 		    uint64_t *out_ts, uint32_t mixers,
 		    struct audio_output_data *mixes)
@@ -451,18 +609,25 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	size_t sample_rate = audio_output_get_sample_rate(audio->audio);
 	size_t channels = audio_output_get_channels(audio->audio);
 	struct ts_info ts = {start_ts_in, end_ts_in};
-	size_t audio_size;
+	bool catch_up = start_ts_in == end_ts_in;
+	bool can_reduce = true;
 	uint64_t min_ts;
 
+	/* a catch up call doesn't bring a new time range, it only outputs
+	 * one that is already queued */
+	if (catch_up && (!audio->buffered_timestamps.size ||
+			 audio->buffering_wait_ticks))
+		return false;
+
 	da_resize(audio->render_order, 0);
 	da_resize(audio->root_nodes, 0);
 
-	circlebuf_push_back(&audio->buffered_timestamps, &ts, sizeof(ts));
+	if (!catch_up)
+		circlebuf_push_back(&audio->buffered_timestamps, &ts,
+				    sizeof(ts));
 	circlebuf_peek_front(&audio->buffered_timestamps, &ts, sizeof(ts));
 	min_ts = ts.start;
 
-	audio_size = AUDIO_OUTPUT_FRAMES * sizeof(float);
-
 #if DEBUG_AUDIO == 1
 	blog(LOG_DEBUG, "ts %llu-%llu", ts.start, ts.end);
 #endif
@@ -493,43 +658,7 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 
 	/* ------------------------------------------------ */
 	/* render audio data */
-	for (size_t i = 0; i < audio->render_order.num; i++) {
-		obs_source_t *source = audio->render_order.array[i];
-		obs_source_audio_render(source, mixers, channels, sample_rate,
-					audio_size);
-
-		/* if a source has gone backward in time and we can no
-		 * longer buffer, drop some or all of its audio */
-		if (audio->total_buffering_ticks == MAX_BUFFERING_TICKS &&
-		    source->audio_ts < ts.start) {
-			if (source->info.audio_render) {
-				blog(LOG_DEBUG,
-				     "render audio source %s timestamp has "
-				     "gone backwards",
-				     obs_source_get_name(source));
-
-				/* just avoid further damage */
-				source->audio_pending = true;
-#if DEBUG_AUDIO == 1
-				/* this should really be fixed */
-				assert(false);
-#endif
-			} else {
-				pthread_mutex_lock(&source->audio_buf_mutex);
-				bool rerender = ignore_audio(source, channels,
-							     sample_rate,
-							     ts.start);
-				pthread_mutex_unlock(&source->audio_buf_mutex);
-
-				/* if we (potentially) recovered, re-render */
-				if (rerender)
-					obs_source_audio_render(source, mixers,
-								channels,
-								sample_rate,
-								audio_size);
-			}
-		}
-	}
+	render_audio_sources(audio, mixers, channels, sample_rate, ts.start);
 
 	/* ------------------------------------------------ */
 	/* get minimum audio timestamp */
@@ -546,6 +675,8 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	/* ------------------------------------------------ */
 	/* mix audio */
 	if (!audio->buffering_wait_ticks) {
+		profile_start(audio_mix_name);
+
 		for (size_t i = 0; i < audio->root_nodes.num; i++) {
 			obs_source_t *source = audio->root_nodes.array[i];
 
@@ -555,11 +686,13 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 			pthread_mutex_lock(&source->audio_buf_mutex);
 
 			if (source->audio_output_buf[0][0] && source->audio_ts)
-				mix_audio(mixes, source, channels, sample_rate,
-					  &ts);
+				mix_audio(mixes, source, mixers, channels,
+					  sample_rate, &ts);
 
 			pthread_mutex_unlock(&source->audio_buf_mutex);
 		}
+
+		profile_end(audio_mix_name);
 	}
 
 	/* ------------------------------------------------ */
@@ -570,6 +703,9 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 	while (source) {
 		pthread_mutex_lock(&source->audio_buf_mutex);
 		discard_audio(audio, source, channels, sample_rate, &ts);
+		if (can_reduce)
+			can_reduce = audio_source_has_spare_tick(
+				source, sample_rate, ts.end);
 		pthread_mutex_unlock(&source->audio_buf_mutex);
 
 		source = (struct obs_source *)source->next_audio_source;
@@ -590,6 +726,9 @@ bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 		return false;
 	}
 
+	if (!catch_up)
+		reduce_audio_buffering(audio, sample_rate, can_reduce);
+
 	UNUSED_PARAMETER(param);
 	return true;
 }
@@ -20,6 +20,10 @@
 #include "util/dstr.h"
 #include "util/darray.h"
 #include "util/platform.h"
+#include "util/crc32.h"
+#include "util/array-serializer.h"
+#include "util/file-serializer.h"
+#include "util/str-hash.h"
 #include "graphics/vec2.h"
 #include "graphics/vec3.h"
 #include "graphics/vec4.h"
@@ -31,8 +35,10 @@
 struct obs_data_item {
 	volatile long ref;
 	struct obs_data *parent;
+	struct obs_data_item *prev;
 	struct obs_data_item *next;
 	enum obs_data_type type;
+	uint32_t name_hash;
 	size_t name_len;
 	size_t data_len;
 	size_t data_size;
@@ -46,6 +52,11 @@ struct obs_data {
 	volatile long ref;
 	char *json;
 	struct obs_data_item *first_item;
+	struct obs_data_item *last_item;
+
+	size_t num_items;
+	struct obs_data_item **index;
+	size_t index_size;
 };
 
 struct obs_data_array {
@@ -70,6 +81,15 @@ static inline size_t get_align_size(size_t size)
 	return (size + alignment - 1) & ~(alignment - 1);
 }
 
+/* items and objects are created and destroyed constantly, so they come from
+ * the pooled allocator and are charged to the data tag */
+static inline void *data_zalloc(size_t size)
+{
+	void *mem = bmalloc_pooled(size, BMEM_TAG_DATA);
+	memset(mem, 0, size);
+	return mem;
+}
+
 /* ensures data after the name has alignment (in case of SSE) */
 static inline size_t get_name_align_size(const char *name)
 {
@@ -261,6 +281,131 @@ static inline void item_autoselect_data_addref(struct obs_data_item *item)
 	}
 }
 
+/* ------------------------------------------------------------------------- */
+/* Name index
+ *
+ *   Once an object has more than a handful of items, it also keeps an open
+ * addressing (linear probing) hash table of them so that looking an item up
+ * by name doesn't have to walk the list.  The list still owns the items and
+ * keeps them sorted by name.  Each item caches the hash of its name, which
+ * also lets list walks skip most string compares. */
+
+#define INDEX_MIN_ITEMS 8
+
+static inline bool item_name_equal(struct obs_data_item *item,
+				   const char *name, uint32_t hash)
+{
+	return item->name_hash == hash && strcmp(get_item_name(item), name) == 0;
+}
+
+static void index_insert_slot(struct obs_data *data,
+			      struct obs_data_item *item)
+{
+	size_t mask = data->index_size - 1;
+	size_t idx = item->name_hash & mask;
+
+	while (data->index[idx])
+		idx = (idx + 1) & mask;
+
+	data->index[idx] = item;
+}
+
+static void index_rebuild(struct obs_data *data, size_t size)
+{
+	bfree(data->index);
+	data->index = bzalloc(sizeof(struct obs_data_item *) * size);
+	data->index_size = size;
+
+	for (struct obs_data_item *item = data->first_item; item;
+	     item = item->next)
+		index_insert_slot(data, item);
+}
+
+/* called after the item has been linked into the list */
+static void index_add(struct obs_data *data, struct obs_data_item *item)
+{
+	data->num_items++;
+
+	if (data->index && data->num_items * 2 <= data->index_size) {
+		index_insert_slot(data, item);
+
+	} else if (data->num_items > INDEX_MIN_ITEMS) {
+		size_t size = data->index_size ? data->index_size * 2 : 32;
+		while (size < data->num_items * 2)
+			size *= 2;
+
+		index_rebuild(data, size);
+	}
+}
+
+/* item may already be freed after a realloc, so it is only compared */
+static size_t index_find_slot(struct obs_data *data,
+			      struct obs_data_item *item, uint32_t hash)
+{
+	size_t mask = data->index_size - 1;
+	size_t idx = hash & mask;
+
+	while (data->index[idx]) {
+		if (data->index[idx] == item)
+			return idx;
+		idx = (idx + 1) & mask;
+	}
+
+	return DARRAY_INVALID;
+}
+
+static void index_remove(struct obs_data *data, struct obs_data_item *item)
+{
+	size_t mask, idx, next;
+
+	data->num_items--;
+
+	if (!data->index)
+		return;
+
+	idx = index_find_slot(data, item, item->name_hash);
+	if (idx == DARRAY_INVALID)
+		return;
+
+	/* backward shift deletion: move later entries of the probe sequence
+	 * into the hole unless their home slot lies after the hole */
+	mask = data->index_size - 1;
+	next = idx;
+
+	for (;;) {
+		struct obs_data_item *cur;
+		size_t home;
+
+		next = (next + 1) & mask;
+		cur = data->index[next];
+		if (!cur)
+			break;
+
+		home = cur->name_hash & mask;
+		if (next > idx ? (home <= idx || home > next)
+			       : (home <= idx && home > next)) {
+			data->index[idx] = cur;
+			idx = next;
+		}
+	}
+
+	data->index[idx] = NULL;
+}
+
+static inline void index_replace(struct obs_data *data,
+				 struct obs_data_item *old_ptr,
+				 struct obs_data_item *new_ptr)
+{
+	size_t idx;
+
+	if (!data->index)
+		return;
+
+	idx = index_find_slot(data, old_ptr, new_ptr->name_hash);
+	if (idx != DARRAY_INVALID)
+		data->index[idx] = new_ptr;
+}
+
 static struct obs_data_item *obs_data_item_create(const char *name,
 						  const void *data, size_t size,
 						  enum obs_data_type type,
@@ -276,7 +421,7 @@ static struct obs_data_item *obs_data_item_create(const char *name,
 	name_size = get_name_align_size(name);
 	total_size = name_size + sizeof(struct obs_data_item) + size;
 
-	item = bzalloc(total_size);
+	item = data_zalloc(total_size);
 
 	item->capacity = total_size;
 	item->type = type;
@@ -297,50 +442,99 @@ static struct obs_data_item *obs_data_item_create(const char *name,
 
 	strcpy(get_item_name(item), name);
 	memcpy(get_item_data(item), data, size);
+	item->name_hash = str_hash(name);
 
 	item_data_addref(item);
 	return item;
 }
 
-static struct obs_data_item **get_item_prev_next(struct obs_data *data,
-						 struct obs_data_item *current)
+/* items are doubly linked so that they can be unlinked or moved after a
+ * realloc without walking the list.  an item that has been detached has no
+ * neighbors and isn't the head of its parent's list. */
+static inline bool obs_data_item_attached(struct obs_data *data,
+					  struct obs_data_item *item)
 {
-	if (!current || !data)
-		return NULL;
+	return data && (item->prev || data->first_item == item);
+}
 
-	struct obs_data_item **prev_next = &data->first_item;
-	struct obs_data_item *item = data->first_item;
+static inline void obs_data_item_detach(struct obs_data_item *item)
+{
+	struct obs_data *data = item->parent;
 
-	while (item) {
-		if (item == current)
-			return prev_next;
+	if (!obs_data_item_attached(data, item))
+		return;
 
-		prev_next = &item->next;
-		item = item->next;
-	}
+	if (item->prev)
+		item->prev->next = item->next;
+	else
+		data->first_item = item->next;
 
-	return NULL;
+	if (item->next)
+		item->next->prev = item->prev;
+	else
+		data->last_item = item->prev;
+
+	item->prev = NULL;
+	item->next = NULL;
+	index_remove(data, item);
 }
 
-static inline void obs_data_item_detach(struct obs_data_item *item)
+/* old_ptr has already been freed by the realloc, so it is only compared */
+static inline void obs_data_item_reattach(struct obs_data_item *old_ptr,
+					  struct obs_data_item *new_ptr)
 {
-	struct obs_data_item **prev_next =
-		get_item_prev_next(item->parent, item);
+	struct obs_data *data = new_ptr->parent;
 
-	if (prev_next) {
-		*prev_next = item->next;
-		item->next = NULL;
-	}
+	if (new_ptr->prev)
+		new_ptr->prev->next = new_ptr;
+	else if (data && data->first_item == old_ptr)
+		data->first_item = new_ptr;
+	else
+		return;
+
+	if (new_ptr->next)
+		new_ptr->next->prev = new_ptr;
+	else
+		data->last_item = new_ptr;
+
+	index_replace(data, old_ptr, new_ptr);
 }
 
-static inline void obs_data_item_reattach(struct obs_data_item *old_ptr,
-					  struct obs_data_item *new_ptr)
+static void obs_data_item_attach(struct obs_data *data,
+				 struct obs_data_item *item)
 {
-	struct obs_data_item **prev_next =
-		get_item_prev_next(new_ptr->parent, old_ptr);
+	const char *name = get_item_name(item);
+	struct obs_data_item *prev = NULL;
+	struct obs_data_item *next = data->first_item;
+
+	/* items are usually added in order when loading, so try the end of
+	 * the list before walking it */
+	if (data->last_item &&
+	    strcmp(get_item_name(data->last_item), name) < 0) {
+		prev = data->last_item;
+		next = NULL;
+	} else {
+		while (next && strcmp(get_item_name(next), name) < 0) {
+			prev = next;
+			next = next->next;
+		}
+	}
+
+	item->parent = data;
+	item->prev = prev;
+	item->next = next;
+
+	if (prev)
+		prev->next = item;
+	else
+		data->first_item = item;
+
+	if (next)
+		next->prev = item;
+	else
+		data->last_item = item;
 
-	if (prev_next)
-		*prev_next = new_ptr;
+	index_add(data, item);
 }
 
 static struct obs_data_item *
@@ -624,7 +818,7 @@ static json_t *obs_data_to_json(obs_data_t *data)
 
 obs_data_t *obs_data_create()
 {
-	struct obs_data *data = bzalloc(sizeof(struct obs_data));
+	struct obs_data *data = data_zalloc(sizeof(struct obs_data));
 	data->ref = 1;
 
 	return data;
@@ -712,6 +906,8 @@ static inline void obs_data_destroy(struct obs_data *data)
 		item = next;
 	}
 
+	bfree(data->index);
+
 	/* NOTE: don't use bfree for json text, allocated by json */
 	free(data->json);
 	bfree(data);
@@ -772,6 +968,548 @@ bool obs_data_save_json_safe(obs_data_t *data, const char *file,
 	return false;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Binary format
+ *
+ *   header:  "OBSD", version, source crc, body size, body crc (all u32 LE)
+ *   body:    string table (u32 count, then u32 length + bytes + NUL each),
+ *            followed by the root object
+ *   object:  u32 item count, then per item u32 name index, u8 type, value
+ *
+ *   Like JSON, only user values are stored, and array entries are objects.
+ * The source crc is the crc32 of the JSON text that a cache file was written
+ * for, or 0 for standalone files. */
+
+#define BINARY_MAGIC "OBSD"
+#define BINARY_VERSION 1
+#define BINARY_HEADER_SIZE 20
+#define BINARY_MAX_DEPTH 512
+#define BINARY_CACHE_EXT ".bin"
+
+enum binary_type {
+	BINARY_STRING,
+	BINARY_INT,
+	BINARY_DOUBLE,
+	BINARY_TRUE,
+	BINARY_FALSE,
+	BINARY_OBJECT,
+	BINARY_ARRAY,
+};
+
+struct binary_writer {
+	struct serializer s;
+	struct array_output_data out;
+
+	DARRAY(const char *) strings;
+	uint32_t *slots;
+	size_t num_slots;
+};
+
+static void binary_strings_grow(struct binary_writer *w)
+{
+	size_t mask;
+
+	bfree(w->slots);
+	w->num_slots = w->num_slots ? w->num_slots * 2 : 256;
+	w->slots = bmalloc(sizeof(uint32_t) * w->num_slots);
+	memset(w->slots, 0xFF, sizeof(uint32_t) * w->num_slots);
+	mask = w->num_slots - 1;
+
+	for (size_t i = 0; i < w->strings.num; i++) {
+		size_t slot = str_hash(w->strings.array[i]) & mask;
+
+		while (w->slots[slot] != UINT32_MAX)
+			slot = (slot + 1) & mask;
+		w->slots[slot] = (uint32_t)i;
+	}
+}
+
+static uint32_t binary_intern(struct binary_writer *w, const char *str)
+{
+	size_t mask;
+	size_t slot;
+	uint32_t idx;
+
+	if (!str)
+		str = "";
+
+	if ((w->strings.num + 1) * 2 > w->num_slots)
+		binary_strings_grow(w);
+
+	mask = w->num_slots - 1;
+	slot = str_hash(str) & mask;
+
+	while ((idx = w->slots[slot]) != UINT32_MAX) {
+		if (strcmp(w->strings.array[idx], str) == 0)
+			return idx;
+		slot = (slot + 1) & mask;
+	}
+
+	idx = (uint32_t)w->strings.num;
+	da_push_back(w->strings, &str);
+	w->slots[slot] = idx;
+	return idx;
+}
+
+static inline void write_le32(uint8_t *p, uint32_t val)
+{
+	p[0] = (uint8_t)val;
+	p[1] = (uint8_t)(val >> 8);
+	p[2] = (uint8_t)(val >> 16);
+	p[3] = (uint8_t)(val >> 24);
+}
+
+static inline uint32_t read_le32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+	       ((uint32_t)p[3] << 24);
+}
+
+static inline bool binary_should_write(struct obs_data_item *item)
+{
+	return obs_data_item_has_user_value(item) && item->type != OBS_DATA_NULL;
+}
+
+static void binary_write_obj(struct binary_writer *w, obs_data_t *data);
+
+static void binary_write_item(struct binary_writer *w,
+			      struct obs_data_item *item)
+{
+	struct serializer *s = &w->s;
+
+	s_wl32(s, binary_intern(w, get_item_name(item)));
+
+	if (item->type == OBS_DATA_STRING) {
+		s_w8(s, BINARY_STRING);
+		s_wl32(s, binary_intern(w, obs_data_item_get_string(item)));
+
+	} else if (item->type == OBS_DATA_NUMBER) {
+		if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT) {
+			s_w8(s, BINARY_INT);
+			s_wl64(s, (uint64_t)obs_data_item_get_int(item));
+		} else {
+			s_w8(s, BINARY_DOUBLE);
+			s_wld(s, obs_data_item_get_double(item));
+		}
+
+	} else if (item->type == OBS_DATA_BOOLEAN) {
+		s_w8(s, obs_data_item_get_bool(item) ? BINARY_TRUE
+						     : BINARY_FALSE);
+
+	} else if (item->type == OBS_DATA_OBJECT) {
+		s_w8(s, BINARY_OBJECT);
+		binary_write_obj(w, get_item_obj(item));
+
+	} else if (item->type == OBS_DATA_ARRAY) {
+		obs_data_array_t *array = get_item_array(item);
+		size_t count = array ? array->objects.num : 0;
+
+		s_w8(s, BINARY_ARRAY);
+		s_wl32(s, (uint32_t)count);
+		for (size_t i = 0; i < count; i++)
+			binary_write_obj(w, array->objects.array[i]);
+	}
+}
+
+static void binary_write_obj(struct binary_writer *w, obs_data_t *data)
+{
+	struct obs_data_item *item;
+	uint32_t count = 0;
+
+	for (item = data ? data->first_item : NULL; item; item = item->next) {
+		if (binary_should_write(item))
+			count++;
+	}
+
+	s_wl32(&w->s, count);
+
+	for (item = data ? data->first_item : NULL; item; item = item->next) {
+		if (binary_should_write(item))
+			binary_write_item(w, item);
+	}
+}
+
+static bool obs_data_save_binary_internal(obs_data_t *data, const char *file,
+					  uint32_t source_crc)
+{
+	struct binary_writer w = {0};
+	struct array_output_data table;
+	struct serializer table_s;
+	struct serializer file_s;
+	uint8_t header[BINARY_HEADER_SIZE];
+	uint32_t crc;
+	size_t body_size;
+	bool success = false;
+
+	if (!data || !file)
+		return false;
+
+	array_output_serializer_init(&w.s, &w.out);
+	binary_write_obj(&w, data);
+
+	/* the string table is only complete once the tree has been written,
+	 * so it's serialized separately and goes in front of it */
+	array_output_serializer_init(&table_s, &table);
+	s_wl32(&table_s, (uint32_t)w.strings.num);
+	for (size_t i = 0; i < w.strings.num; i++) {
+		const char *str = w.strings.array[i];
+		size_t len = strlen(str);
+
+		s_wl32(&table_s, (uint32_t)len);
+		s_write(&table_s, str, len + 1);
+	}
+
+	body_size = table.bytes.num + w.out.bytes.num;
+	crc = calc_crc32(0, table.bytes.array, table.bytes.num);
+	crc = calc_crc32(crc, w.out.bytes.array, w.out.bytes.num);
+
+	memcpy(header, BINARY_MAGIC, 4);
+	write_le32(header + 4, BINARY_VERSION);
+	write_le32(header + 8, source_crc);
+	write_le32(header + 12, (uint32_t)body_size);
+	write_le32(header + 16, crc);
+
+	if (file_output_serializer_init_safe(&file_s, file, "tmp")) {
+		size_t written = s_write(&file_s, header, sizeof(header));
+		written += s_write(&file_s, table.bytes.array,
+				   table.bytes.num);
+		written += s_write(&file_s, w.out.bytes.array,
+				   w.out.bytes.num);
+		success = written == sizeof(header) + body_size;
+
+		file_output_serializer_free(&file_s);
+	}
+
+	array_output_serializer_free(&table);
+	array_output_serializer_free(&w.out);
+	da_free(w.strings);
+	bfree(w.slots);
+	return success;
+}
+
+bool obs_data_save_binary(obs_data_t *data, const char *file)
+{
+	return obs_data_save_binary_internal(data, file, 0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct binary_reader {
+	const uint8_t *pos;
+	const uint8_t *end;
+	const char **strings;
+	uint32_t num_strings;
+	bool error;
+};
+
+static inline const uint8_t *binary_take(struct binary_reader *r, size_t size)
+{
+	const uint8_t *p = r->pos;
+
+	if (r->error || (size_t)(r->end - r->pos) < size) {
+		r->error = true;
+		return NULL;
+	}
+
+	r->pos += size;
+	return p;
+}
+
+static inline uint8_t binary_r8(struct binary_reader *r)
+{
+	const uint8_t *p = binary_take(r, 1);
+	return p ? *p : 0;
+}
+
+static inline uint32_t binary_r32(struct binary_reader *r)
+{
+	const uint8_t *p = binary_take(r, 4);
+	return p ? read_le32(p) : 0;
+}
+
+static inline uint64_t binary_r64(struct binary_reader *r)
+{
+	const uint8_t *p = binary_take(r, 8);
+	return p ? (uint64_t)read_le32(p) | ((uint64_t)read_le32(p + 4) << 32)
+		 : 0;
+}
+
+static inline const char *binary_rstr(struct binary_reader *r)
+{
+	uint32_t idx = binary_r32(r);
+
+	if (r->error || idx >= r->num_strings) {
+		r->error = true;
+		return NULL;
+	}
+
+	return r->strings[idx];
+}
+
+static bool binary_read_strings(struct binary_reader *r)
+{
+	uint32_t count = binary_r32(r);
+
+	/* every string takes at least five bytes */
+	if (r->error || count > (size_t)(r->end - r->pos) / 5)
+		return false;
+
+	r->strings = bmalloc(sizeof(const char *) * (count ? count : 1));
+	r->num_strings = count;
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t len = binary_r32(r);
+		const uint8_t *str = binary_take(r, (size_t)len + 1);
+
+		if (!str || str[len] != 0)
+			return false;
+
+		r->strings[i] = (const char *)str;
+	}
+
+	return true;
+}
+
+static void binary_read_obj(struct binary_reader *r, obs_data_t *data,
+			    int depth);
+
+static obs_data_t *binary_read_new_obj(struct binary_reader *r, int depth)
+{
+	obs_data_t *obj = obs_data_create();
+
+	binary_read_obj(r, obj, depth + 1);
+	return obj;
+}
+
+static void binary_read_item(struct binary_reader *r, obs_data_t *data,
+			     int depth)
+{
+	const char *name = binary_rstr(r);
+	uint8_t type = binary_r8(r);
+
+	if (r->error)
+		return;
+
+	switch ((enum binary_type)type) {
+	case BINARY_STRING: {
+		const char *str = binary_rstr(r);
+		if (str)
+			obs_data_set_string(data, name, str);
+		break;
+	}
+	case BINARY_INT:
+		obs_data_set_int(data, name, (long long)binary_r64(r));
+		break;
+	case BINARY_DOUBLE: {
+		uint64_t bits = binary_r64(r);
+		double val;
+
+		memcpy(&val, &bits, sizeof(val));
+		obs_data_set_double(data, name, val);
+		break;
+	}
+	case BINARY_TRUE:
+		obs_data_set_bool(data, name, true);
+		break;
+	case BINARY_FALSE:
+		obs_data_set_bool(data, name, false);
+		break;
+	case BINARY_OBJECT: {
+		obs_data_t *obj = binary_read_new_obj(r, depth);
+		obs_data_set_obj(data, name, obj);
+		obs_data_release(obj);
+		break;
+	}
+	case BINARY_ARRAY: {
+		obs_data_array_t *array = obs_data_array_create();
+		uint32_t count = binary_r32(r);
+
+		/* every object takes at least four bytes */
+		if (count > (size_t)(r->end - r->pos) / 4)
+			r->error = true;
+
+		for (uint32_t i = 0; i < count && !r->error; i++) {
+			obs_data_t *obj = binary_read_new_obj(r, depth);
+			obs_data_array_push_back(array, obj);
+			obs_data_release(obj);
+		}
+
+		obs_data_set_array(data, name, array);
+		obs_data_array_release(array);
+		break;
+	}
+	default:
+		r->error = true;
+	}
+}
+
+static void binary_read_obj(struct binary_reader *r, obs_data_t *data,
+			    int depth)
+{
+	uint32_t count = binary_r32(r);
+
+	if (depth > BINARY_MAX_DEPTH)
+		r->error = true;
+
+	for (uint32_t i = 0; i < count && !r->error; i++)
+		binary_read_item(r, data, depth);
+}
+
+static obs_data_t *obs_data_create_from_binary(const uint8_t *buf,
+					       size_t size,
+					       const uint32_t *source_crc)
+{
+	struct binary_reader r = {0};
+	obs_data_t *data = NULL;
+	uint32_t body_size;
+
+	if (size < BINARY_HEADER_SIZE || memcmp(buf, BINARY_MAGIC, 4) != 0)
+		return NULL;
+	if (read_le32(buf + 4) != BINARY_VERSION)
+		return NULL;
+	if (source_crc && read_le32(buf + 8) != *source_crc)
+		return NULL;
+
+	body_size = read_le32(buf + 12);
+	if (body_size != size - BINARY_HEADER_SIZE)
+		return NULL;
+	if (calc_crc32(0, buf + BINARY_HEADER_SIZE, body_size) !=
+	    read_le32(buf + 16))
+		return NULL;
+
+	r.pos = buf + BINARY_HEADER_SIZE;
+	r.end = r.pos + body_size;
+
+	if (binary_read_strings(&r)) {
+		data = obs_data_create();
+		binary_read_obj(&r, data, 0);
+
+		if (r.error || r.pos != r.end) {
+			obs_data_release(data);
+			data = NULL;
+		}
+	}
+
+	bfree(r.strings);
+	return data;
+}
+
+static uint8_t *read_binary_file(const char *file, size_t *size)
+{
+	FILE *f = os_fopen(file, "rb");
+	uint8_t *buf = NULL;
+	int64_t file_size;
+
+	if (!f)
+		return NULL;
+
+	os_fseeki64(f, 0, SEEK_END);
+	file_size = os_ftelli64(f);
+	os_fseeki64(f, 0, SEEK_SET);
+
+	if (file_size > 0 && (uint64_t)file_size <= UINT32_MAX) {
+		buf = bmalloc((size_t)file_size);
+		if (fread(buf, 1, (size_t)file_size, f) != (size_t)file_size) {
+			bfree(buf);
+			buf = NULL;
+		}
+	}
+
+	fclose(f);
+	*size = buf ? (size_t)file_size : 0;
+	return buf;
+}
+
+static obs_data_t *obs_data_create_from_binary_file_internal(
+	const char *file, const uint32_t *source_crc)
+{
+	obs_data_t *data = NULL;
+	size_t size;
+	uint8_t *buf = read_binary_file(file, &size);
+
+	if (buf) {
+		data = obs_data_create_from_binary(buf, size, source_crc);
+		bfree(buf);
+	}
+
+	return data;
+}
+
+obs_data_t *obs_data_create_from_binary_file(const char *file)
+{
+	obs_data_t *data = obs_data_create_from_binary_file_internal(file, NULL);
+
+	if (!data && os_file_exists(file))
+		blog(LOG_ERROR,
+		     "obs-data.c: [obs_data_create_from_binary_file] "
+		     "Failed reading binary file '%s'",
+		     file);
+
+	return data;
+}
+
+/* ------------------------------------------------------------------------- */
+
+obs_data_t *obs_data_create_from_json_file_cached(const char *json_file,
+						  const char *backup_ext)
+{
+	char *json = os_quick_read_utf8_file(json_file);
+	struct dstr cache_file = {0};
+	obs_data_t *data = NULL;
+	uint32_t crc;
+
+	if (!json)
+		return obs_data_create_from_json_file_safe(json_file,
+							   backup_ext);
+
+	crc = calc_crc32(0, json, strlen(json));
+	dstr_printf(&cache_file, "%s" BINARY_CACHE_EXT, json_file);
+
+	data = obs_data_create_from_binary_file_internal(cache_file.array,
+							 &crc);
+	if (!data) {
+		data = obs_data_create_from_json(json);
+
+		/* refresh the cache so the next load doesn't need to parse
+		 * the JSON again */
+		if (data)
+			obs_data_save_binary_internal(data, cache_file.array,
+						      crc);
+	}
+
+	if (!data)
+		data = obs_data_create_from_json_file_safe(json_file,
+							   backup_ext);
+
+	dstr_free(&cache_file);
+	bfree(json);
+	return data;
+}
+
+bool obs_data_save_json_cached(obs_data_t *data, const char *file,
+			       const char *temp_ext, const char *backup_ext)
+{
+	const char *json = obs_data_get_json(data);
+	struct dstr cache_file = {0};
+	size_t len;
+
+	if (!json || !*json)
+		return false;
+
+	len = strlen(json);
+	if (!os_quick_write_utf8_file_safe(file, json, len, false, temp_ext,
+					   backup_ext))
+		return false;
+
+	/* the cache is only an optimization, a stale or missing one just
+	 * means that the next load parses the JSON */
+	dstr_printf(&cache_file, "%s" BINARY_CACHE_EXT, file);
+	obs_data_save_binary_internal(data, cache_file.array,
+				      calc_crc32(0, json, len));
+	dstr_free(&cache_file);
+	return true;
+}
+
 static void get_defaults_array_cb(obs_data_t *data, void *vp)
 {
 	obs_data_array_t *defs = (obs_data_array_t *)vp;
@@ -869,10 +1607,26 @@ static struct obs_data_item *get_item(struct obs_data *data, const char *name)
 	if (!data)
 		return NULL;
 
+	uint32_t hash = str_hash(name);
+
+	if (data->index) {
+		size_t mask = data->index_size - 1;
+		size_t idx = hash & mask;
+		struct obs_data_item *item;
+
+		while ((item = data->index[idx]) != NULL) {
+			if (item_name_equal(item, name, hash))
+				return item;
+			idx = (idx + 1) & mask;
+		}
+
+		return NULL;
+	}
+
 	struct obs_data_item *item = data->first_item;
 
 	while (item) {
-		if (strcmp(get_item_name(item), name) == 0)
+		if (item_name_equal(item, name, hash))
 			return item;
 
 		item = item->next;
@@ -891,31 +1645,8 @@ static void set_item_data(struct obs_data *data, struct obs_data_item **item,
 	if ((!item || !*item) && data) {
 		new_item = obs_data_item_create(name, ptr, size, type,
 						default_data, autoselect_data);
-
-		obs_data_item_t *prev = obs_data_first(data);
-		obs_data_item_t *next = obs_data_first(data);
-		obs_data_item_next(&next);
-		for (; prev && next;
-		     obs_data_item_next(&prev), obs_data_item_next(&next)) {
-			if (strcmp(get_item_name(next), name) > 0)
-				break;
-		}
-
-		new_item->parent = data;
-		if (prev && strcmp(get_item_name(prev), name) < 0) {
-			prev->next = new_item;
-			new_item->next = next;
-
-		} else {
-			data->first_item = new_item;
-			new_item->next = prev;
-		}
-
-		if (!prev)
-			data->first_item = new_item;
-
-		obs_data_item_release(&prev);
-		obs_data_item_release(&next);
+		if (new_item)
+			obs_data_item_attach(data, new_item);
 
 	} else if (default_data) {
 		obs_data_item_set_default_data(item, ptr, size, type);
@@ -76,6 +76,18 @@ EXPORT bool obs_data_save_json_safe(obs_data_t *data, const char *file,
 				    const char *temp_ext,
 				    const char *backup_ext);
 
+/* compact binary form of the same tree, validated by a checksum */
+EXPORT obs_data_t *obs_data_create_from_binary_file(const char *file);
+EXPORT bool obs_data_save_binary(obs_data_t *data, const char *file);
+
+/* same as the _safe JSON functions, but also keep a binary copy next to the
+ * JSON file that is loaded instead while it still matches the JSON */
+EXPORT obs_data_t *obs_data_create_from_json_file_cached(const char *json_file,
+							 const char *backup_ext);
+EXPORT bool obs_data_save_json_cached(obs_data_t *data, const char *file,
+				      const char *temp_ext,
+				      const char *backup_ext);
+
 EXPORT void obs_data_apply(obs_data_t *target, obs_data_t *apply_data);
 
 EXPORT void obs_data_erase(obs_data_t *data, const char *name);
@@ -196,6 +196,26 @@ static inline bool gpu_encode_available(const struct obs_encoder *encoder)
 	       obs->video.using_nv12_tex;
 }
 
+/* scaled encoders that don't need a different format share a scaled output
+ * rendered on the GPU instead of each running their own CPU scaler */
+static struct obs_video_rung *
+get_video_rung(struct obs_encoder *encoder,
+	       const struct video_scale_info *info)
+{
+	const struct video_output_info *voi;
+	voi = video_output_get_info(encoder->media);
+
+	if (!has_scaling(encoder))
+		return NULL;
+	if (info->format != voi->format || info->colorspace != voi->colorspace ||
+	    info->range != voi->range)
+		return NULL;
+	if (encoder->media != obs->video.video)
+		return NULL;
+
+	return obs_video_rung_acquire(info->width, info->height);
+}
+
 static void add_connection(struct obs_encoder *encoder)
 {
 	if (encoder->info.type == OBS_ENCODER_AUDIO) {
@@ -211,8 +231,10 @@ static void add_connection(struct obs_encoder *encoder)
 		if (gpu_encode_available(encoder)) {
 			start_gpu_encode(encoder);
 		} else {
-			start_raw_video(encoder->media, &info, receive_video,
-					encoder);
+			encoder->rung = get_video_rung(encoder, &info);
+			start_raw_video(encoder->rung ? encoder->rung->video
+						      : encoder->media,
+					&info, receive_video, encoder);
 		}
 	}
 
@@ -227,6 +249,11 @@ static void remove_connection(struct obs_encoder *encoder, bool shutdown)
 	} else {
 		if (gpu_encode_available(encoder)) {
 			stop_gpu_encode(encoder);
+		} else if (encoder->rung) {
+			stop_raw_video(encoder->rung->video, receive_video,
+				       encoder);
+			obs_video_rung_release(encoder->rung);
+			encoder->rung = NULL;
 		} else {
 			stop_raw_video(encoder->media, receive_video, encoder);
 		}
@@ -856,6 +883,7 @@ static void send_first_video_packet(struct obs_encoder *encoder,
 				    struct encoder_packet *packet)
 {
 	struct encoder_packet first_packet;
+	struct encoder_packet sei_packet;
 	DARRAY(uint8_t) data;
 	uint8_t *sei;
 	size_t size;
@@ -875,14 +903,18 @@ static void send_first_video_packet(struct obs_encoder *encoder,
 	da_push_back_array(data, sei, size);
 	da_push_back_array(data, packet->data, packet->size);
 
-	first_packet = *packet;
-	first_packet.data = data.array;
-	first_packet.size = data.num;
+	sei_packet = *packet;
+	sei_packet.data = data.array;
+	sei_packet.size = data.num;
+
+	/* callbacks may keep a reference to the packet they receive */
+	obs_encoder_packet_create_instance(&first_packet, &sei_packet);
+	da_free(data);
 
 	cb->new_packet(cb->param, &first_packet);
 	cb->sent_first_packet = true;
 
-	da_free(data);
+	obs_encoder_packet_release(&first_packet);
 }
 
 static inline void send_packet(struct obs_encoder *encoder,
@@ -930,6 +962,8 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success,
 	}
 
 	if (received) {
+		struct encoder_packet shared;
+
 		if (!encoder->first_received) {
 			encoder->offset_usec = packet_dts_usec(pkt);
 			encoder->first_received = true;
@@ -945,15 +979,21 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success,
 		pkt->sys_dts_usec += encoder->pause.ts_offset / 1000;
 		pthread_mutex_unlock(&encoder->pause.mutex);
 
+		/* the data is copied once here and then shared by every
+		 * output, which just take a reference to it */
+		obs_encoder_packet_create_instance(&shared, pkt);
+
 		pthread_mutex_lock(&encoder->callbacks_mutex);
 
 		for (size_t i = encoder->callbacks.num; i > 0; i--) {
 			struct encoder_callback *cb;
 			cb = encoder->callbacks.array + (i - 1);
-			send_packet(encoder, cb, pkt);
+			send_packet(encoder, cb, &shared);
 		}
 
 		pthread_mutex_unlock(&encoder->callbacks_mutex);
+
+		obs_encoder_packet_release(&shared);
 	}
 }
 
@@ -967,6 +1007,7 @@ bool do_encode(struct obs_encoder *encoder, struct encoder_frame *frame)
 					   "encode(%s)", encoder->context.name);
 
 	struct encoder_packet pkt = {0};
+	enum bmem_tag prev_tag = bmem_set_thread_tag(BMEM_TAG_ENCODER);
 	bool received = false;
 	bool success;
 
@@ -980,6 +1021,7 @@ bool do_encode(struct obs_encoder *encoder, struct encoder_frame *frame)
 	profile_end(encoder->profile_encoder_encode_name);
 	send_off_encoder_packet(encoder, success, received, &pkt);
 
+	bmem_set_thread_tag(prev_tag);
 	profile_end(do_encode_name);
 
 	return success;
@@ -1308,16 +1350,232 @@ void obs_encoder_remove_output(struct obs_encoder *encoder,
 	pthread_mutex_unlock(&encoder->outputs_mutex);
 }
 
+/* ------------------------------------------------------------------------- */
+/* packet pool
+ *
+ * Packet data is allocated in power-of-two size classes and recycled once
+ * the last reference is released, so steady streams of similar sized packets
+ * stop hitting the allocator.  As before, the reference count sits right in
+ * front of the data, which keeps packets from obs_parse_avc_packet and
+ * plugins that build their own reference-counted packets working.  Pooled
+ * blocks are told apart by a flag bit in the reference count. */
+
+#define PACKET_POOL_MIN_SHIFT 12 /* 4 KiB */
+#define PACKET_POOL_NUM_CLASSES 12 /* up to 8 MiB */
+#define PACKET_POOL_MAX_CACHED (64 * 1024 * 1024)
+#define PACKET_POOL_REF_FLAG (1L << (sizeof(long) * 8 - 2))
+
+struct packet_block {
+	struct packet_block *next;
+	int size_class;
+	volatile long refs; /* must directly precede the data */
+};
+
+struct packet_pool_class {
+	pthread_mutex_t mutex;
+	struct packet_block *free_list;
+};
+
+struct packet_pool {
+	struct packet_pool_class classes[PACKET_POOL_NUM_CLASSES];
+	volatile long cached_bytes;
+
+	/* set by obs_encoder_packet_pool_free.  packets that outputs or
+	 * plugins still hold at that point are freed directly on release */
+	volatile bool freed;
+
+	volatile long allocs;
+	volatile long reused;
+	volatile long peak_cached_bytes;
+};
+
+#define POOL_CLASS_INIT {PTHREAD_MUTEX_INITIALIZER, NULL}
+static struct packet_pool packet_pool = {
+	.classes = {POOL_CLASS_INIT, POOL_CLASS_INIT, POOL_CLASS_INIT,
+		    POOL_CLASS_INIT, POOL_CLASS_INIT, POOL_CLASS_INIT,
+		    POOL_CLASS_INIT, POOL_CLASS_INIT, POOL_CLASS_INIT,
+		    POOL_CLASS_INIT, POOL_CLASS_INIT, POOL_CLASS_INIT}};
+#undef POOL_CLASS_INIT
+
+static inline size_t packet_class_size(int size_class)
+{
+	return (size_t)1 << (PACKET_POOL_MIN_SHIFT + size_class);
+}
+
+static inline int get_packet_class(size_t size)
+{
+	for (int i = 0; i < PACKET_POOL_NUM_CLASSES; i++) {
+		if (size <= packet_class_size(i))
+			return i;
+	}
+
+	return -1;
+}
+
+static inline struct packet_block *get_packet_block(long *p_refs)
+{
+	return (struct packet_block *)((uint8_t *)p_refs -
+				       offsetof(struct packet_block, refs));
+}
+
+static void update_peak_cached(long cached)
+{
+	long peak = os_atomic_load_long(&packet_pool.peak_cached_bytes);
+
+	while (cached > peak) {
+		if (os_atomic_compare_exchange_long(
+			    &packet_pool.peak_cached_bytes, &peak, cached))
+			break;
+	}
+}
+
+/* accounts for a block being put back into the pool, fails if the pool
+ * already holds as much memory as it is allowed to */
+static bool reserve_cached(long size)
+{
+	long cached = os_atomic_load_long(&packet_pool.cached_bytes);
+
+	do {
+		if (cached + size > PACKET_POOL_MAX_CACHED)
+			return false;
+	} while (!os_atomic_compare_exchange_long(&packet_pool.cached_bytes,
+						  &cached, cached + size));
+
+	update_peak_cached(cached + size);
+	return true;
+}
+
+static void unreserve_cached(long size)
+{
+	long cached = os_atomic_load_long(&packet_pool.cached_bytes);
+
+	while (!os_atomic_compare_exchange_long(&packet_pool.cached_bytes,
+						&cached, cached - size))
+		;
+}
+
+static const char *packet_pool_miss_name = "packet_pool_miss";
+static struct packet_block *packet_pool_alloc(size_t size)
+{
+	int size_class = get_packet_class(size);
+	struct packet_block *block = NULL;
+
+	os_atomic_inc_long(&packet_pool.allocs);
+
+	if (size_class != -1) {
+		struct packet_pool_class *pc =
+			&packet_pool.classes[size_class];
+
+		pthread_mutex_lock(&pc->mutex);
+		block = pc->free_list;
+		if (block)
+			pc->free_list = block->next;
+		pthread_mutex_unlock(&pc->mutex);
+	}
+
+	if (block) {
+		os_atomic_inc_long(&packet_pool.reused);
+		unreserve_cached((long)packet_class_size(size_class));
+	} else {
+		size_t alloc_size = size_class != -1
+					    ? packet_class_size(size_class)
+					    : size;
+
+		profile_start(packet_pool_miss_name);
+		block = bmalloc(sizeof(struct packet_block) + alloc_size);
+		block->size_class = size_class;
+		profile_end(packet_pool_miss_name);
+	}
+
+	block->next = NULL;
+	block->refs = PACKET_POOL_REF_FLAG | 1;
+	return block;
+}
+
+static void packet_pool_free(struct packet_block *block)
+{
+	struct packet_pool_class *pc;
+	long size;
+	bool freed;
+
+	if (block->size_class == -1 ||
+	    os_atomic_load_bool(&packet_pool.freed)) {
+		bfree(block);
+		return;
+	}
+
+	size = (long)packet_class_size(block->size_class);
+	if (!reserve_cached(size)) {
+		bfree(block);
+		return;
+	}
+
+	/* checked again under the lock, as the pool may have been freed
+	 * after the check above but before this class was emptied */
+	pc = &packet_pool.classes[block->size_class];
+	pthread_mutex_lock(&pc->mutex);
+	freed = os_atomic_load_bool(&packet_pool.freed);
+	if (!freed) {
+		block->next = pc->free_list;
+		pc->free_list = block;
+	}
+	pthread_mutex_unlock(&pc->mutex);
+
+	if (freed) {
+		unreserve_cached(size);
+		bfree(block);
+	}
+}
+
+void obs_encoder_packet_pool_free(void)
+{
+	long allocs = os_atomic_load_long(&packet_pool.allocs);
+	long reused = os_atomic_load_long(&packet_pool.reused);
+	long peak = os_atomic_load_long(&packet_pool.peak_cached_bytes);
+
+	os_atomic_store_bool(&packet_pool.freed, true);
+
+	for (size_t i = 0; i < PACKET_POOL_NUM_CLASSES; i++) {
+		struct packet_pool_class *pc = &packet_pool.classes[i];
+		struct packet_block *block;
+
+		pthread_mutex_lock(&pc->mutex);
+		block = pc->free_list;
+		pc->free_list = NULL;
+		pthread_mutex_unlock(&pc->mutex);
+
+		while (block) {
+			struct packet_block *next = block->next;
+			unreserve_cached((long)packet_class_size((int)i));
+			bfree(block);
+			block = next;
+		}
+	}
+
+	if (allocs) {
+		blog(LOG_INFO,
+		     "Encoder packet pool: %ld packets, %ld reused (%.1f%%), "
+		     "peak cached %.1f MiB",
+		     allocs, reused, (double)reused * 100.0 / (double)allocs,
+		     (double)peak / (1024.0 * 1024.0));
+	}
+}
+
+static const char *packet_create_instance_name =
+	"obs_encoder_packet_create_instance";
 void obs_encoder_packet_create_instance(struct encoder_packet *dst,
 					const struct encoder_packet *src)
 {
-	long *p_refs;
+	struct packet_block *block;
+
+	profile_start(packet_create_instance_name);
 
 	*dst = *src;
-	p_refs = bmalloc(src->size + sizeof(long));
-	dst->data = (void *)(p_refs + 1);
-	*p_refs = 1;
+	block = packet_pool_alloc(src->size);
+	dst->data = (uint8_t *)(&block->refs + 1);
 	memcpy(dst->data, src->data, src->size);
+
+	profile_end(packet_create_instance_name);
 }
 
 /* OBS_DEPRECATED */
@@ -1354,8 +1612,12 @@ void obs_encoder_packet_release(struct encoder_packet *pkt)
 
 	if (pkt->data) {
 		long *p_refs = ((long *)pkt->data) - 1;
-		if (os_atomic_dec_long(p_refs) == 0)
+		long refs = os_atomic_dec_long(p_refs);
+
+		if (refs == 0)
 			bfree(p_refs);
+		else if (refs == PACKET_POOL_REF_FLAG)
+			packet_pool_free(get_packet_block(p_refs));
 	}
 
 	memset(pkt, 0, sizeof(struct encoder_packet));
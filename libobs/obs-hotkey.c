@@ -138,12 +138,12 @@ void obs_hotkey_pair_set_descriptions(obs_hotkey_pair_id id, const char *desc0,
 static void hotkey_signal(const char *signal, obs_hotkey_t *hotkey)
 {
 	calldata_t data;
-	calldata_init(&data);
+	uint8_t stack[128];
+
+	calldata_init_fixed(&data, stack, sizeof(stack));
 	calldata_set_ptr(&data, "key", hotkey);
 
 	signal_handler_signal(obs->hotkeys.signals, signal, &data);
-
-	calldata_free(&data);
 }
 
 static inline void fixup_pointers(void);
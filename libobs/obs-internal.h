@@ -24,6 +24,7 @@
 #include "util/threading.h"
 #include "util/platform.h"
 #include "util/profiler.h"
+#include "util/task-pool.h"
 #include "callback/signal.h"
 #include "callback/proc.h"
 
@@ -243,6 +244,24 @@ struct obs_task_info {
 	void *param;
 };
 
+/* a scaled copy of the output, rendered and converted on the GPU from the
+ * same frame as the main output, for encoders that use a scaled size */
+struct obs_video_rung {
+	uint32_t width;
+	uint32_t height;
+	long refs;
+
+	video_t *video;
+	gs_texture_t *output_texture;
+	gs_texture_t *convert_textures[NUM_CHANNELS];
+	gs_stagesurf_t *copy_surfaces[NUM_TEXTURES][NUM_CHANNELS];
+	gs_stagesurf_t *mapped_surfaces[NUM_CHANNELS];
+	bool textures_copied[NUM_TEXTURES];
+	bool frame_ready;
+	struct video_data frame;
+	float conversion_width_i;
+};
+
 struct obs_core_video {
 	graphics_t *graphics;
 	gs_stagesurf_t *copy_surfaces[NUM_TEXTURES][NUM_CHANNELS];
@@ -318,6 +337,16 @@ struct obs_core_video {
 
 	pthread_mutex_t task_mutex;
 	struct circlebuf tasks;
+
+	DARRAY(obs_source_t *) tick_sources;
+	DARRAY(obs_source_t *) async_uploads;
+
+	pthread_mutex_t rungs_mutex;
+	DARRAY(struct obs_video_rung *) rungs;
+
+	/* rungs whose last reference was dropped, freed on the graphics
+	 * thread because the release can come from the rung's own thread */
+	DARRAY(struct obs_video_rung *) released_rungs;
 };
 
 struct audio_monitor;
@@ -333,6 +362,10 @@ struct obs_core_audio {
 	int buffering_wait_ticks;
 	int total_buffering_ticks;
 
+	/* ticks in a row in which every source had enough audio queued for
+	 * the mix to give up a tick of buffering */
+	int buffering_stable_ticks;
+
 	float user_volume;
 
 	pthread_mutex_t monitoring_mutex;
@@ -341,6 +374,15 @@ struct obs_core_audio {
 	char *monitoring_device_id;
 };
 
+/* name lookup table for one of the context lists, chained by hash_next */
+struct obs_context_index {
+	pthread_rwlock_t lock;
+	struct obs_context_data **buckets;
+	size_t num_buckets;
+	size_t count;
+	uint64_t next_order;
+};
+
 /* user sources, output channels, and displays */
 struct obs_core_data {
 	struct obs_source *first_source;
@@ -357,6 +399,10 @@ struct obs_core_data {
 	pthread_mutex_t services_mutex;
 	pthread_mutex_t audio_sources_mutex;
 	pthread_mutex_t draw_callbacks_mutex;
+	struct obs_context_index sources_index;
+	struct obs_context_index outputs_index;
+	struct obs_context_index encoders_index;
+	struct obs_context_index services_index;
 	DARRAY(struct draw_callback) draw_callbacks;
 	DARRAY(struct tick_callback) tick_callbacks;
 
@@ -420,6 +466,7 @@ struct obs_core {
 
 	signal_handler_t *signals;
 	proc_handler_t *procs;
+	signal_handle_t *source_volume_signal;
 
 	char *locale;
 	char *module_config_path;
@@ -475,6 +522,18 @@ extern void stop_raw_video(video_t *video,
 					    struct video_data *frame),
 			   void *param);
 
+extern bool obs_create_convert_textures(gs_texture_t *textures[NUM_CHANNELS],
+					enum video_format format,
+					uint32_t width, uint32_t height);
+extern bool obs_create_copy_surfaces(gs_stagesurf_t *surfaces[NUM_CHANNELS],
+				     enum video_format format, uint32_t width,
+				     uint32_t height);
+
+extern struct obs_video_rung *obs_video_rung_acquire(uint32_t width,
+						     uint32_t height);
+extern void obs_video_rung_release(struct obs_video_rung *rung);
+extern void obs_free_released_video_rungs(void);
+
 /* ------------------------------------------------------------------------- */
 /* obs shared context data */
 
@@ -497,6 +556,11 @@ struct obs_context_data {
 	struct obs_context_data *next;
 	struct obs_context_data **prev_next;
 
+	struct obs_context_index *index;
+	struct obs_context_data *hash_next;
+	uint64_t index_order;
+	uint32_t name_hash;
+
 	bool private;
 };
 
@@ -630,6 +694,13 @@ struct obs_source {
 	/* used to temporarily disable sources if needed */
 	bool enabled;
 
+	/* static content tracking for the scene item render cache; only the
+	 * generation is touched outside of the graphics thread */
+	volatile long content_generation;
+	uint64_t content_check_time;
+	uint64_t content_state;
+	bool content_static;
+
 	/* timing (if video is present, is based upon video) */
 	volatile bool timing_set;
 	volatile uint64_t timing_adjust;
@@ -640,8 +711,10 @@ struct obs_source {
 	uint64_t last_frame_ts;
 	uint64_t last_sys_timestamp;
 	bool async_rendered;
+	const char *profile_upload_name;
 
 	/* audio */
+	const char *profile_audio_render_name;
 	bool audio_failed;
 	bool audio_pending;
 	bool pending_stop;
@@ -668,6 +741,7 @@ struct obs_source {
 	uint32_t audio_mixers;
 	float user_volume;
 	float volume;
+	signal_handle_t *volume_signal;
 	int64_t sync_offset;
 	int64_t last_sync_offset;
 	float balance;
@@ -790,11 +864,22 @@ struct audio_monitor *audio_monitor_create(obs_source_t *source);
 void audio_monitor_reset(struct audio_monitor *monitor);
 extern void audio_monitor_destroy(struct audio_monitor *monitor);
 
+/* when publish is false the source isn't added to the source list and
+ * source_create isn't signaled until obs_source_publish is called */
 extern obs_source_t *obs_source_create_set_last_ver(const char *id,
 						    const char *name,
 						    obs_data_t *settings,
 						    obs_data_t *hotkey_data,
-						    uint32_t last_obs_ver);
+						    uint32_t last_obs_ver,
+						    bool publish);
+extern void obs_source_publish(obs_source_t *source);
+
+/* returns *cached, building it from format and the source's name first if it
+ * hasn't been yet.  cached must be one of the source's profile_*_name fields,
+ * so renaming the source updates it */
+extern const char *obs_source_get_profile_name(obs_source_t *source,
+					       const char **cached,
+					       const char *format);
 extern void obs_source_destroy(struct obs_source *source);
 
 enum view_type {
@@ -849,6 +934,7 @@ convert_video_format(enum video_format format)
 extern void obs_source_activate(obs_source_t *source, enum view_type type);
 extern void obs_source_deactivate(obs_source_t *source, enum view_type type);
 extern void obs_source_video_tick(obs_source_t *source, float seconds);
+extern void obs_source_upload_async_video(obs_source_t *source);
 extern float obs_source_get_target_volume(obs_source_t *source,
 					  obs_source_t *target);
 
@@ -856,6 +942,19 @@ extern void obs_source_audio_render(obs_source_t *source, uint32_t mixers,
 				    size_t channels, size_t sample_rate,
 				    size_t size);
 
+static inline uint64_t content_state_mix(uint64_t state, uint64_t val)
+{
+	state = (state ^ val) * 0x100000001B3ULL;
+	return state ^ (state >> 32);
+}
+
+/* returns false if the source's video may change from frame to frame.
+ * otherwise, state only changes when its rendered output does */
+extern bool obs_source_get_content_state(obs_source_t *source,
+					 uint64_t *state);
+extern bool obs_scene_get_content_state(obs_source_t *source,
+					uint64_t *state);
+
 extern void add_alignment(struct vec2 *v, uint32_t align, int cx, int cy);
 
 extern struct obs_source_frame *filter_async_video(obs_source_t *source,
@@ -1035,6 +1134,7 @@ extern void obs_output_remove_encoder(struct obs_output *output,
 extern void
 obs_encoder_packet_create_instance(struct encoder_packet *dst,
 				   const struct encoder_packet *src);
+extern void obs_encoder_packet_pool_free(void);
 void obs_output_destroy(obs_output_t *output);
 
 /* ------------------------------------------------------------------------- */
@@ -1073,6 +1173,9 @@ struct obs_encoder {
 	uint32_t scaled_height;
 	enum video_format preferred_format;
 
+	/* GPU scaled output used instead of a CPU scaler, if any */
+	struct obs_video_rung *rung;
+
 	volatile bool active;
 	volatile bool paused;
 	bool initialized;
@@ -508,12 +508,21 @@ lookup_t *obs_module_load_locale(obs_module_t *module,
 {
 	struct dstr str = {0};
 	lookup_t *lookup = NULL;
+	const char *profile_name = NULL;
 
 	if (!module || !default_locale || !locale) {
 		blog(LOG_WARNING, "obs_module_load_locale: Invalid parameters");
 		return NULL;
 	}
 
+	/* the name store belongs to the core, which may not exist yet */
+	if (obs)
+		profile_name = profile_store_name(obs_get_profiler_name_store(),
+						  "obs_module_load_locale(%s)",
+						  module->file);
+	if (profile_name)
+		profile_start(profile_name);
+
 	dstr_copy(&str, "locale/");
 	dstr_cat(&str, default_locale);
 	dstr_cat(&str, ".ini");
@@ -546,6 +555,8 @@ lookup_t *obs_module_load_locale(obs_module_t *module,
 	bfree(file);
 cleanup:
 	dstr_free(&str);
+	if (profile_name)
+		profile_end(profile_name);
 	return lookup;
 }
 
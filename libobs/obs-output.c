@@ -1346,7 +1346,10 @@ static inline void send_interleaved(struct obs_output *output)
 		pthread_mutex_unlock(&output->caption_mutex);
 	}
 
+	enum bmem_tag prev_tag = bmem_set_thread_tag(BMEM_TAG_OUTPUT);
 	output->info.encoded_packet(output->context.data, &out);
+	bmem_set_thread_tag(prev_tag);
+
 	obs_encoder_packet_release(&out);
 }
 
@@ -1710,7 +1713,7 @@ static void interleave_packets(void *data, struct encoder_packet *packet)
 	if (output->active_delay_ns)
 		out = *packet;
 	else
-		obs_encoder_packet_create_instance(&out, packet);
+		obs_encoder_packet_ref(&out, packet);
 
 	if (was_started)
 		apply_interleaved_packet_offset(output, &out);
@@ -1746,7 +1749,9 @@ static void default_encoded_callback(void *param, struct encoder_packet *packet)
 		if (packet->type == OBS_ENCODER_AUDIO)
 			packet->track_idx = get_track_index(output, packet);
 
+		enum bmem_tag prev_tag = bmem_set_thread_tag(BMEM_TAG_OUTPUT);
 		output->info.encoded_packet(output->context.data, packet);
+		bmem_set_thread_tag(prev_tag);
 
 		if (packet->type == OBS_ENCODER_VIDEO)
 			output->total_frames++;
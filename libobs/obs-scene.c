@@ -373,6 +373,8 @@ static void update_item_transform(struct obs_scene_item *item, bool update_tex)
 	struct calldata params;
 	uint8_t stack[128];
 
+	os_atomic_inc_long(&item->transform_generation);
+
 	if (os_atomic_load_long(&item->defer_update) > 0)
 		return;
 
@@ -561,14 +563,89 @@ static void render_item_texture(struct obs_scene_item *item)
 	GS_DEBUG_MARKER_END();
 }
 
+/* state of what ends up in item_render: the source and the crop */
+static bool item_content_state(struct obs_scene_item *item, uint64_t *state)
+{
+	uint64_t val;
+
+	if (transition_active(item->show_transition) ||
+	    transition_active(item->hide_transition))
+		return false;
+	if (!obs_source_get_content_state(item->source, &val))
+		return false;
+
+	val = content_state_mix(val, item->crop.left);
+	val = content_state_mix(val, item->crop.top);
+	val = content_state_mix(val, item->crop.right);
+	val = content_state_mix(val, item->crop.bottom);
+
+	*state = val;
+	return true;
+}
+
+bool obs_scene_get_content_state(obs_source_t *source, uint64_t *state)
+{
+	struct obs_scene *scene = source->context.data;
+	struct obs_scene_item *item;
+	uint64_t val = *state;
+	bool is_static = true;
+
+	if (!scene)
+		return false;
+
+	video_lock(scene);
+
+	item = scene->first_item;
+	while (item) {
+		uint64_t item_state;
+
+		if (!item->user_visible &&
+		    !transition_active(item->hide_transition)) {
+			item = item->next;
+			continue;
+		}
+
+		/* pending transform updates are applied when the scene
+		 * renders, so the scene has to render to pick them up */
+		if (os_atomic_load_bool(&item->update_transform) ||
+		    obs_source_removed(item->source) ||
+		    source_size_changed(item) ||
+		    !item_content_state(item, &item_state)) {
+			is_static = false;
+			break;
+		}
+
+		val = content_state_mix(val, (uint64_t)item->id);
+		val = content_state_mix(
+			val,
+			(uint64_t)os_atomic_load_long(
+				&item->transform_generation));
+		val = content_state_mix(val, item->scale_filter);
+		val = content_state_mix(val, item_state);
+
+		item = item->next;
+	}
+
+	video_unlock(scene);
+
+	*state = val;
+	return is_static;
+}
+
+static const char *render_item_cached_name = "render_item (cached)";
+
 static inline void render_item(struct obs_scene_item *item)
 {
+	bool cache_hit = false;
+
 	GS_DEBUG_MARKER_BEGIN_FORMAT(GS_DEBUG_COLOR_ITEM, "Item: %s",
 				     obs_source_get_name(item->source));
 
 	if (item->item_render) {
 		uint32_t width = obs_source_get_width(item->source);
 		uint32_t height = obs_source_get_height(item->source);
+		uint64_t state = 0;
+		bool cacheable;
 
 		if (!width || !height) {
 			goto cleanup;
@@ -577,7 +654,20 @@ static inline void render_item(struct obs_scene_item *item)
 		uint32_t cx = calc_cx(item, width);
 		uint32_t cy = calc_cy(item, height);
 
+		/* cached textures are skipped by the reset in the tick, so
+		 * throw them away here once their content goes stale */
+		cacheable = item_content_state(item, &state);
+		if (item->render_cached &&
+		    (!cacheable || state != item->render_state))
+			gs_texrender_reset(item->item_render);
+
+		item->render_cached = cacheable;
+		item->render_state = state;
+		cache_hit = cacheable;
+
 		if (cx && cy && gs_texrender_begin(item->item_render, cx, cy)) {
+			cache_hit = false;
+
 			float cx_scale = (float)width / (float)cx;
 			float cy_scale = (float)height / (float)cy;
 			struct vec4 clear_color;
@@ -621,7 +711,11 @@ static inline void render_item(struct obs_scene_item *item)
 	gs_matrix_push();
 	gs_matrix_mul(&item->draw_transform);
 	if (item->item_render) {
+		if (cache_hit)
+			profile_start(render_item_cached_name);
 		render_item_texture(item);
+		if (cache_hit)
+			profile_end(render_item_cached_name);
 	} else if (item->user_visible &&
 		   transition_active(item->show_transition)) {
 		const int cx = obs_source_get_width(item->source);
@@ -652,7 +746,7 @@ static void scene_video_tick(void *data, float seconds)
 	video_lock(scene);
 	item = scene->first_item;
 	while (item) {
-		if (item->item_render)
+		if (item->item_render && !item->render_cached)
 			gs_texrender_reset(item->item_render);
 		item = item->next;
 	}
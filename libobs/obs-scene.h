@@ -50,6 +50,12 @@ struct obs_scene_item {
 	gs_texrender_t *item_render;
 	struct obs_sceneitem_crop crop;
 
+	/* item_render is kept across frames while the content state of the
+	 * item stays the same */
+	volatile long transform_generation;
+	uint64_t render_state;
+	bool render_cached;
+
 	struct vec2 pos;
 	struct vec2 scale;
 	float rot;
@@ -115,8 +115,15 @@ bool obs_source_init_context(struct obs_source *source, obs_data_t *settings,
 				   settings, name, hotkey_data, private))
 		return false;
 
-	return signal_handler_add_array(source->context.signals,
-					source_signals);
+	if (!signal_handler_add_array(source->context.signals,
+				      source_signals))
+		return false;
+
+	/* volume changes are signalled continuously while a fader is being
+	 * dragged, so resolve the signal once up front */
+	source->volume_signal = signal_handler_get_handle(
+		source->context.signals, "volume");
+	return true;
 }
 
 const char *obs_source_get_display_name(const char *id)
@@ -334,10 +341,19 @@ static void obs_source_init_audio_hotkeys(struct obs_source *source)
 		obs_source_hotkey_push_to_talk, source);
 }
 
+void obs_source_publish(obs_source_t *source)
+{
+	if (!source->context.private) {
+		obs_source_dosignal(source, "source_create", NULL);
+	}
+
+	obs_source_init_finalize(source);
+}
+
 static obs_source_t *
 obs_source_create_internal(const char *id, const char *name,
 			   obs_data_t *settings, obs_data_t *hotkey_data,
-			   bool private, uint32_t last_obs_ver)
+			   bool private, uint32_t last_obs_ver, bool publish)
 {
 	struct obs_source *source = bzalloc(sizeof(struct obs_source));
 
@@ -399,11 +415,8 @@ obs_source_create_internal(const char *id, const char *name,
 	source->flags = source->default_flags;
 	source->enabled = true;
 
-	if (!private) {
-		obs_source_dosignal(source, "source_create", NULL);
-	}
-
-	obs_source_init_finalize(source);
+	if (publish)
+		obs_source_publish(source);
 	return source;
 
 fail:
@@ -416,23 +429,24 @@ obs_source_t *obs_source_create(const char *id, const char *name,
 				obs_data_t *settings, obs_data_t *hotkey_data)
 {
 	return obs_source_create_internal(id, name, settings, hotkey_data,
-					  false, LIBOBS_API_VER);
+					  false, LIBOBS_API_VER, true);
 }
 
 obs_source_t *obs_source_create_private(const char *id, const char *name,
 					obs_data_t *settings)
 {
 	return obs_source_create_internal(id, name, settings, NULL, true,
-					  LIBOBS_API_VER);
+					  LIBOBS_API_VER, true);
 }
 
 obs_source_t *obs_source_create_set_last_ver(const char *id, const char *name,
 					     obs_data_t *settings,
 					     obs_data_t *hotkey_data,
-					     uint32_t last_obs_ver)
+					     uint32_t last_obs_ver,
+					     bool publish)
 {
 	return obs_source_create_internal(id, name, settings, hotkey_data,
-					  false, last_obs_ver);
+					  false, last_obs_ver, publish);
 }
 
 static char *get_new_filter_name(obs_source_t *dst, const char *name)
@@ -921,6 +935,7 @@ static void obs_source_deferred_update(obs_source_t *source)
 				    source->context.settings);
 		os_atomic_compare_swap_long(&source->defer_update_count, count,
 					    0);
+		os_atomic_inc_long(&source->content_generation);
 	}
 }
 
@@ -938,7 +953,77 @@ void obs_source_update(obs_source_t *source, obs_data_t *settings)
 	} else if (source->context.data && source->info.update) {
 		source->info.update(source->context.data,
 				    source->context.settings);
+		os_atomic_inc_long(&source->content_generation);
+	}
+}
+
+void obs_source_content_changed(obs_source_t *source)
+{
+	if (!obs_source_valid(source, "obs_source_content_changed"))
+		return;
+
+	os_atomic_inc_long(&source->content_generation);
+}
+
+static bool get_content_state(obs_source_t *source, uint64_t *state)
+{
+	uint32_t flags = source->info.output_flags;
+	uint64_t val = 0xCBF29CE484222325ULL;
+	bool is_static = true;
+
+	if (source->info.type == OBS_SOURCE_TYPE_SCENE) {
+		if (!obs_scene_get_content_state(source, &val))
+			return false;
+	} else if ((flags & OBS_SOURCE_ASYNC) != 0 ||
+		   (flags & OBS_SOURCE_STATIC_VIDEO) == 0) {
+		return false;
+	}
+
+	val = content_state_mix(
+		val, (uint64_t)os_atomic_load_long(&source->content_generation));
+	val = content_state_mix(val, source->enabled);
+	val = content_state_mix(val, obs_source_get_width(source));
+	val = content_state_mix(val, obs_source_get_height(source));
+
+	/* the filter list is hashed rather than versioned so that adding,
+	 * removing, reordering and toggling filters are all picked up */
+	pthread_mutex_lock(&source->filter_mutex);
+	for (size_t i = 0; i < source->filters.num; i++) {
+		obs_source_t *filter = source->filters.array[i];
+		uint64_t filter_state;
+
+		val = content_state_mix(val, (uint64_t)(uintptr_t)filter);
+		val = content_state_mix(val, filter->enabled);
+		if (!filter->enabled)
+			continue;
+
+		if (!obs_source_get_content_state(filter, &filter_state)) {
+			is_static = false;
+			break;
+		}
+
+		val = content_state_mix(val, filter_state);
+	}
+	pthread_mutex_unlock(&source->filter_mutex);
+
+	*state = val;
+	return is_static;
+}
+
+bool obs_source_get_content_state(obs_source_t *source, uint64_t *state)
+{
+	uint64_t frame_time = obs->video.video_time;
+
+	/* a source can be reached through several scenes, so only work it
+	 * out once per frame */
+	if (source->content_check_time != frame_time) {
+		source->content_static =
+			get_content_state(source, &source->content_state);
+		source->content_check_time = frame_time;
 	}
+
+	*state = source->content_state;
+	return source->content_static;
 }
 
 void obs_source_reset_settings(obs_source_t *source, obs_data_t *settings)
@@ -2148,6 +2233,13 @@ static void obs_source_update_async_video(obs_source_t *source)
 	}
 }
 
+void obs_source_upload_async_video(obs_source_t *source)
+{
+	if (deinterlacing_enabled(source))
+		deinterlace_update_async_video(source);
+	obs_source_update_async_video(source);
+}
+
 static void rotate_async_video(obs_source_t *source, long rotation)
 {
 	float x = 0;
@@ -2272,11 +2364,8 @@ static inline void render_video(obs_source_t *source)
 
 	if (source->info.type == OBS_SOURCE_TYPE_INPUT &&
 	    (source->info.output_flags & OBS_SOURCE_ASYNC) != 0 &&
-	    !source->rendering_filter) {
-		if (deinterlacing_enabled(source))
-			deinterlace_update_async_video(source);
-		obs_source_update_async_video(source);
-	}
+	    !source->rendering_filter)
+		obs_source_upload_async_video(source);
 
 	if (!source->context.data || !source->enabled) {
 		if (source->filter_parent)
@@ -3246,8 +3335,8 @@ static inline void reset_resampler(obs_source_t *source,
 		return;
 	}
 
-	source->resampler =
-		audio_resampler_create(&output_info, &source->sample_info);
+	source->resampler = audio_resampler_create2(
+		&output_info, &source->sample_info, obs_info->resample_type);
 
 	source->audio_failed = source->resampler == NULL;
 	if (source->resampler == NULL)
@@ -3586,6 +3675,40 @@ const char *obs_source_get_name(const obs_source_t *source)
 		       : NULL;
 }
 
+/* the profiler keeps every name it's given, so names that were already built
+ * for the source are replaced rather than changed.  they're built and replaced
+ * under the context's rename mutex, as the threads that use them would
+ * otherwise read context.name while a rename is changing it */
+static void update_profile_names(obs_source_t *source)
+{
+	profiler_name_store_t *names = obs_get_profiler_name_store();
+
+	pthread_mutex_lock(&source->context.rename_cache_mutex);
+	if (source->profile_upload_name)
+		source->profile_upload_name = profile_store_name(
+			names, "upload(%s)", source->context.name);
+	if (source->profile_audio_render_name)
+		source->profile_audio_render_name = profile_store_name(
+			names, "audio_render(%s)", source->context.name);
+	pthread_mutex_unlock(&source->context.rename_cache_mutex);
+}
+
+const char *obs_source_get_profile_name(obs_source_t *source,
+					const char **cached, const char *format)
+{
+	const char *name;
+
+	pthread_mutex_lock(&source->context.rename_cache_mutex);
+	name = *cached;
+	if (!name)
+		name = *cached = profile_store_name(
+			obs_get_profiler_name_store(), format,
+			source->context.name);
+	pthread_mutex_unlock(&source->context.rename_cache_mutex);
+
+	return name;
+}
+
 void obs_source_set_name(obs_source_t *source, const char *name)
 {
 	if (!obs_source_valid(source, "obs_source_set_name"))
@@ -3596,6 +3719,7 @@ void obs_source_set_name(obs_source_t *source, const char *name)
 		struct calldata data;
 		char *prev_name = bstrdup(source->context.name);
 		obs_context_data_setname(&source->context, name);
+		update_profile_names(source);
 
 		calldata_init(&data);
 		calldata_set_ptr(&data, "source", source);
@@ -3869,10 +3993,12 @@ void obs_source_set_volume(obs_source_t *source, float volume)
 		calldata_set_ptr(&data, "source", source);
 		calldata_set_float(&data, "volume", volume);
 
-		signal_handler_signal(source->context.signals, "volume", &data);
+		signal_handler_signal_handle(source->context.signals,
+					     source->volume_signal, &data);
 		if (!source->context.private)
-			signal_handler_signal(obs->signals, "source_volume",
-					      &data);
+			signal_handler_signal_handle(obs->signals,
+						     obs->source_volume_signal,
+						     &data);
 
 		volume = (float)calldata_float(&data, "volume");
 
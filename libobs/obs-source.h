@@ -196,6 +196,20 @@ enum obs_media_state {
  */
 #define OBS_SOURCE_SRGB (1 << 15)
 
+/**
+ * Source's video only changes when its settings are updated or when it calls
+ * obs_source_content_changed, so scenes may keep compositing it from a cached
+ * texture instead of rendering it again every frame.
+ */
+#define OBS_SOURCE_STATIC_VIDEO (1 << 16)
+
+/**
+ * Source's create callback is thread-safe, so when a scene collection is
+ * loaded it may be created on a worker thread at the same time as other
+ * sources, before its saved volume, flags, filters and so on are applied.
+ */
+#define OBS_SOURCE_PARALLEL_CREATE (1 << 17)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent,
@@ -29,8 +29,14 @@
 #include <windows.h>
 #endif
 
+static inline bool is_async_video(const struct obs_source *source)
+{
+	return (source->info.output_flags & OBS_SOURCE_ASYNC) != 0;
+}
+
 static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 {
+	struct obs_core_video *video = &obs->video;
 	struct obs_core_data *data = &obs->data;
 	struct obs_source *source;
 	uint64_t delta_time;
@@ -57,7 +63,7 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 	pthread_mutex_unlock(&obs->data.draw_callbacks_mutex);
 
 	/* ------------------------------------- */
-	/* call the tick function of each source */
+	/* get references to every source        */
 
 	pthread_mutex_lock(&data->sources_mutex);
 
@@ -66,17 +72,66 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 		struct obs_source *cur_source = obs_source_get_ref(source);
 		source = (struct obs_source *)source->context.next;
 
-		if (cur_source) {
-			obs_source_video_tick(cur_source, seconds);
-			obs_source_release(cur_source);
-		}
+		if (cur_source)
+			da_push_back(video->tick_sources, &cur_source);
 	}
 
 	pthread_mutex_unlock(&data->sources_mutex);
 
+	/* ------------------------------------- */
+	/* call the tick function of each source */
+
+	for (size_t i = 0; i < video->tick_sources.num; i++)
+		obs_source_video_tick(video->tick_sources.array[i], seconds);
+
+	/* ------------------------------------- */
+	/* queue visible async frames for upload */
+
+	for (size_t i = 0; i < video->tick_sources.num; i++) {
+		source = video->tick_sources.array[i];
+
+		if (source->info.type == OBS_SOURCE_TYPE_INPUT &&
+		    is_async_video(source) && obs_source_showing(source)) {
+			obs_source_addref(source);
+			da_push_back(video->async_uploads, &source);
+		}
+	}
+
+	for (size_t i = 0; i < video->tick_sources.num; i++)
+		obs_source_release(video->tick_sources.array[i]);
+
+	da_resize(video->tick_sources, 0);
+
 	return cur_time;
 }
 
+/* uploads the new frames of all visible async sources before anything is
+ * drawn, rather than in the middle of rendering when each source is first
+ * drawn.  every source still maps and unmaps its own textures, the uploads
+ * are only moved ahead of rendering and grouped under one profiler scope.
+ * sources that weren't queued still upload when they're rendered */
+static const char *upload_async_frames_name = "upload_async_frames";
+static void upload_async_frames(struct obs_core_video *video)
+{
+	profile_start(upload_async_frames_name);
+
+	for (size_t i = 0; i < video->async_uploads.num; i++) {
+		struct obs_source *source = video->async_uploads.array[i];
+		const char *name = obs_source_get_profile_name(
+			source, &source->profile_upload_name, "upload(%s)");
+
+		profile_start(name);
+		obs_source_upload_async_video(source);
+		profile_end(name);
+
+		obs_source_release(source);
+	}
+
+	da_resize(video->async_uploads, 0);
+
+	profile_end(upload_async_frames_name);
+}
+
 /* in obs-display.c */
 extern void render_display(struct obs_display *display);
 
@@ -158,13 +213,14 @@ static inline void render_main_texture(struct obs_core_video *video)
 }
 
 static inline gs_effect_t *
-get_scale_effect_internal(struct obs_core_video *video)
+get_scale_effect_internal(struct obs_core_video *video, uint32_t width,
+			  uint32_t height)
 {
 	/* if the dimension is under half the size of the original image,
 	 * bicubic/lanczos can't sample enough pixels to create an accurate
 	 * image, so use the bilinear low resolution effect instead */
-	if (video->output_width < (video->base_width / 2) &&
-	    video->output_height < (video->base_height / 2)) {
+	if (width < (video->base_width / 2) &&
+	    height < (video->base_height / 2)) {
 		return video->bilinear_lowres_effect;
 	}
 
@@ -199,7 +255,8 @@ static inline gs_effect_t *get_scale_effect(struct obs_core_video *video,
 	} else {
 		/* if the scale method couldn't be loaded, use either bicubic
 		 * or bilinear by default */
-		gs_effect_t *effect = get_scale_effect_internal(video);
+		gs_effect_t *effect =
+			get_scale_effect_internal(video, width, height);
 		if (!effect)
 			effect = !!video->bicubic_effect
 					 ? video->bicubic_effect
@@ -208,30 +265,23 @@ static inline gs_effect_t *get_scale_effect(struct obs_core_video *video,
 	}
 }
 
-static const char *render_output_texture_name = "render_output_texture";
-static inline gs_texture_t *render_output_texture(struct obs_core_video *video)
+static inline gs_technique_t *
+get_output_technique(struct obs_core_video *video, gs_effect_t *effect)
+{
+	return gs_effect_get_technique(effect, video->ovi.output_format ==
+							       VIDEO_FORMAT_RGBA
+						       ? "DrawAlphaDivide"
+						       : "Draw");
+}
+
+static void render_scaled_texture(struct obs_core_video *video,
+				  gs_effect_t *effect, gs_technique_t *tech,
+				  gs_texture_t *target)
 {
 	gs_texture_t *texture = video->render_texture;
-	gs_texture_t *target = video->output_texture;
 	uint32_t width = gs_texture_get_width(target);
 	uint32_t height = gs_texture_get_height(target);
 
-	gs_effect_t *effect = get_scale_effect(video, width, height);
-	gs_technique_t *tech;
-
-	if (video->ovi.output_format == VIDEO_FORMAT_RGBA) {
-		tech = gs_effect_get_technique(effect, "DrawAlphaDivide");
-	} else {
-		if ((effect == video->default_effect) &&
-		    (width == video->base_width) &&
-		    (height == video->base_height))
-			return texture;
-
-		tech = gs_effect_get_technique(effect, "Draw");
-	}
-
-	profile_start(render_output_texture_name);
-
 	gs_eparam_t *image = gs_effect_get_param_by_name(effect, "image");
 	gs_eparam_t *bres =
 		gs_effect_get_param_by_name(effect, "base_dimension");
@@ -269,7 +319,26 @@ static inline gs_texture_t *render_output_texture(struct obs_core_video *video)
 	gs_technique_end(tech);
 	gs_enable_blending(true);
 	gs_enable_framebuffer_srgb(false);
+}
 
+static const char *render_output_texture_name = "render_output_texture";
+static inline gs_texture_t *render_output_texture(struct obs_core_video *video)
+{
+	gs_texture_t *texture = video->render_texture;
+	gs_texture_t *target = video->output_texture;
+	uint32_t width = gs_texture_get_width(target);
+	uint32_t height = gs_texture_get_height(target);
+
+	gs_effect_t *effect = get_scale_effect(video, width, height);
+
+	if (video->ovi.output_format != VIDEO_FORMAT_RGBA &&
+	    (effect == video->default_effect) &&
+	    (width == video->base_width) && (height == video->base_height))
+		return texture;
+
+	profile_start(render_output_texture_name);
+	render_scaled_texture(video, effect,
+			      get_output_technique(video, effect), target);
 	profile_end(render_output_texture_name);
 
 	return target;
@@ -295,12 +364,10 @@ static void render_convert_plane(gs_effect_t *effect, gs_texture_t *target,
 	gs_technique_end(tech);
 }
 
-static const char *render_convert_texture_name = "render_convert_texture";
-static void render_convert_texture(struct obs_core_video *video,
-				   gs_texture_t *texture)
+static void convert_texture(struct obs_core_video *video, gs_texture_t *texture,
+			    gs_texture_t *const targets[NUM_CHANNELS],
+			    float conversion_width_i)
 {
-	profile_start(render_convert_texture_name);
-
 	gs_effect_t *effect = video->conversion_effect;
 	gs_eparam_t *color_vec0 =
 		gs_effect_get_param_by_name(effect, "color_vec0");
@@ -321,35 +388,44 @@ static void render_convert_texture(struct obs_core_video *video,
 
 	gs_enable_blending(false);
 
-	if (video->convert_textures[0]) {
+	if (targets[0]) {
 		gs_effect_set_texture(image, texture);
 		gs_effect_set_vec4(color_vec0, &vec0);
-		render_convert_plane(effect, video->convert_textures[0],
+		render_convert_plane(effect, targets[0],
 				     video->conversion_techs[0]);
 
-		if (video->convert_textures[1]) {
+		if (targets[1]) {
 			gs_effect_set_texture(image, texture);
 			gs_effect_set_vec4(color_vec1, &vec1);
-			if (!video->convert_textures[2])
+			if (!targets[2])
 				gs_effect_set_vec4(color_vec2, &vec2);
-			gs_effect_set_float(width_i, video->conversion_width_i);
-			render_convert_plane(effect, video->convert_textures[1],
+			gs_effect_set_float(width_i, conversion_width_i);
+			render_convert_plane(effect, targets[1],
 					     video->conversion_techs[1]);
 
-			if (video->convert_textures[2]) {
+			if (targets[2]) {
 				gs_effect_set_texture(image, texture);
 				gs_effect_set_vec4(color_vec2, &vec2);
 				gs_effect_set_float(width_i,
-						    video->conversion_width_i);
+						    conversion_width_i);
 				render_convert_plane(
-					effect, video->convert_textures[2],
+					effect, targets[2],
 					video->conversion_techs[2]);
 			}
 		}
 	}
 
 	gs_enable_blending(true);
+}
+
+static const char *render_convert_texture_name = "render_convert_texture";
+static void render_convert_texture(struct obs_core_video *video,
+				   gs_texture_t *texture)
+{
+	profile_start(render_convert_texture_name);
 
+	convert_texture(video, texture, video->convert_textures,
+			video->conversion_width_i);
 	video->texture_converted = true;
 
 	profile_end(render_convert_texture_name);
@@ -384,6 +460,56 @@ static inline void stage_output_texture(struct obs_core_video *video,
 	profile_end(stage_output_texture_name);
 }
 
+static void stage_rung_texture(struct obs_video_rung *rung, int cur_texture)
+{
+	for (int c = 0; c < NUM_CHANNELS; c++) {
+		if (rung->mapped_surfaces[c]) {
+			gs_stagesurface_unmap(rung->mapped_surfaces[c]);
+			rung->mapped_surfaces[c] = NULL;
+		}
+	}
+
+	for (int c = 0; c < NUM_CHANNELS; c++) {
+		gs_stagesurf_t *copy = rung->copy_surfaces[cur_texture][c];
+		if (copy)
+			gs_stage_texture(copy, rung->convert_textures[c]);
+	}
+
+	rung->textures_copied[cur_texture] = true;
+}
+
+/* renders every active rung from the same base frame as the main output,
+ * so encoders at other sizes don't need their own scalers on the CPU */
+static const char *render_video_rungs_name = "render_video_rungs";
+static void render_video_rungs(struct obs_core_video *video, int cur_texture)
+{
+	profile_start(render_video_rungs_name);
+	pthread_mutex_lock(&video->rungs_mutex);
+
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		struct obs_video_rung *rung = video->rungs.array[i];
+		gs_effect_t *effect;
+
+		if (!video_output_active(rung->video)) {
+			memset(rung->textures_copied, 0,
+			       sizeof(rung->textures_copied));
+			continue;
+		}
+
+		effect = get_scale_effect(video, rung->width, rung->height);
+		render_scaled_texture(video, effect,
+				      get_output_technique(video, effect),
+				      rung->output_texture);
+		convert_texture(video, rung->output_texture,
+				rung->convert_textures,
+				rung->conversion_width_i);
+		stage_rung_texture(rung, cur_texture);
+	}
+
+	pthread_mutex_unlock(&video->rungs_mutex);
+	profile_end(render_video_rungs_name);
+}
+
 #ifdef _WIN32
 static inline bool queue_frame(struct obs_core_video *video, bool raw_active,
 			       struct obs_vframe_info *vframe_info)
@@ -505,8 +631,12 @@ static inline void render_video(struct obs_core_video *video, bool raw_active,
 		}
 #endif
 
-		if (raw_active)
+		if (raw_active) {
 			stage_output_texture(video, cur_texture);
+
+			if (video->gpu_conversion)
+				render_video_rungs(video, cur_texture);
+		}
 	}
 
 	gs_set_render_target(NULL, NULL);
@@ -535,6 +665,40 @@ static inline bool download_frame(struct obs_core_video *video,
 	return true;
 }
 
+static void download_rung_frames(struct obs_core_video *video,
+				 int prev_texture)
+{
+	pthread_mutex_lock(&video->rungs_mutex);
+
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		struct obs_video_rung *rung = video->rungs.array[i];
+
+		rung->frame_ready = false;
+		if (!rung->textures_copied[prev_texture])
+			continue;
+
+		memset(&rung->frame, 0, sizeof(rung->frame));
+		rung->frame_ready = true;
+
+		for (int c = 0; c < NUM_CHANNELS; c++) {
+			gs_stagesurf_t *surface =
+				rung->copy_surfaces[prev_texture][c];
+			if (!surface)
+				continue;
+
+			if (!gs_stagesurface_map(surface, &rung->frame.data[c],
+						 &rung->frame.linesize[c])) {
+				rung->frame_ready = false;
+				break;
+			}
+
+			rung->mapped_surfaces[c] = surface;
+		}
+	}
+
+	pthread_mutex_unlock(&video->rungs_mutex);
+}
+
 static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height,
 					      uint32_t linesize_input,
 					      uint32_t linesize_output,
@@ -555,12 +719,12 @@ static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height,
 	return in;
 }
 
-static void set_gpu_converted_data(struct obs_core_video *video,
+static void set_gpu_converted_data(bool using_nv12_tex,
 				   struct video_frame *output,
 				   const struct video_data *input,
 				   const struct video_output_info *info)
 {
-	if (video->using_nv12_tex) {
+	if (using_nv12_tex) {
 		const uint32_t width = info->width;
 		const uint32_t height = info->height;
 
@@ -686,29 +850,57 @@ static inline void copy_rgbx_frame(struct video_frame *output,
 	}
 }
 
-static inline void output_video_data(struct obs_core_video *video,
-				     struct video_data *input_frame, int count)
+static void output_video_frame(video_t *output, bool gpu_conversion,
+			       bool using_nv12_tex,
+			       struct video_data *input_frame, int count)
 {
 	const struct video_output_info *info;
 	struct video_frame output_frame;
 	bool locked;
 
-	info = video_output_get_info(video->video);
+	info = video_output_get_info(output);
 
-	locked = video_output_lock_frame(video->video, &output_frame, count,
+	locked = video_output_lock_frame(output, &output_frame, count,
 					 input_frame->timestamp);
 	if (locked) {
-		if (video->gpu_conversion) {
-			set_gpu_converted_data(video, &output_frame,
+		if (gpu_conversion) {
+			set_gpu_converted_data(using_nv12_tex, &output_frame,
 					       input_frame, info);
 		} else {
 			copy_rgbx_frame(&output_frame, input_frame, info);
 		}
 
-		video_output_unlock_frame(video->video);
+		video_output_unlock_frame(output);
 	}
 }
 
+static inline void output_video_data(struct obs_core_video *video,
+				     struct video_data *input_frame, int count)
+{
+	output_video_frame(video->video, video->gpu_conversion,
+			   video->using_nv12_tex, input_frame, count);
+}
+
+/* rungs are staged alongside the main output, so they share its timing */
+static void output_rung_data(struct obs_core_video *video,
+			     const struct obs_vframe_info *vframe_info)
+{
+	pthread_mutex_lock(&video->rungs_mutex);
+
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		struct obs_video_rung *rung = video->rungs.array[i];
+		if (!rung->frame_ready)
+			continue;
+
+		rung->frame.timestamp = vframe_info->timestamp;
+		output_video_frame(rung->video, true, false, &rung->frame,
+				   vframe_info->count);
+		rung->frame_ready = false;
+	}
+
+	pthread_mutex_unlock(&video->rungs_mutex);
+}
+
 static inline void video_sleep(struct obs_core_video *video, bool raw_active,
 			       const bool gpu_active, uint64_t *p_time,
 			       uint64_t interval_ns)
@@ -759,6 +951,8 @@ static inline void output_frame(bool raw_active, const bool gpu_active)
 	profile_start(output_frame_gs_context_name);
 	gs_enter_context(video->graphics);
 
+	upload_async_frames(video);
+
 	profile_start(output_frame_render_video_name);
 	GS_DEBUG_MARKER_BEGIN(GS_DEBUG_COLOR_RENDER_VIDEO,
 			      output_frame_render_video_name);
@@ -769,6 +963,8 @@ static inline void output_frame(bool raw_active, const bool gpu_active)
 	if (raw_active) {
 		profile_start(output_frame_download_frame_name);
 		frame_ready = download_frame(video, prev_texture, &frame);
+		if (video->gpu_conversion)
+			download_rung_frames(video, prev_texture);
 		profile_end(output_frame_download_frame_name);
 	}
 
@@ -787,6 +983,8 @@ static inline void output_frame(bool raw_active, const bool gpu_active)
 		frame.timestamp = vframe_info.timestamp;
 		profile_start(output_frame_output_video_data_name);
 		output_video_data(video, &frame, vframe_info.count);
+		if (video->gpu_conversion)
+			output_rung_data(video, &vframe_info);
 		profile_end(output_frame_output_video_data_name);
 	}
 
@@ -964,6 +1162,7 @@ bool obs_graphics_thread_loop(struct obs_graphics_context *context)
 	profile_end(tick_sources_name);
 
 	execute_graphics_tasks();
+	obs_free_released_video_rungs();
 
 #ifdef _WIN32
 	MSG msg;
@@ -1025,6 +1224,7 @@ void *obs_graphics_thread(void *param)
 	obs->video.video_frame_interval_ns = interval;
 
 	os_set_thread_name("libobs: graphics thread");
+	bmem_set_thread_tag(BMEM_TAG_GRAPHICS);
 
 	const char *video_thread_name = profile_store_name(
 		obs_get_profiler_name_store(),
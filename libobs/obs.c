@@ -19,6 +19,7 @@
 
 #include "graphics/matrix4.h"
 #include "callback/calldata.h"
+#include "util/str-hash.h"
 
 #include "obs.h"
 #include "obs-internal.h"
@@ -105,91 +106,90 @@ static bool obs_init_gpu_conversion(struct obs_video_info *ovi)
 				       &video->convert_textures[1],
 				       ovi->output_width, ovi->output_height,
 				       GS_RENDER_TARGET | GS_SHARED_KM_TEX);
-	} else {
-#endif
-		video->convert_textures[0] =
-			gs_texture_create(ovi->output_width, ovi->output_height,
-					  GS_R8, 1, NULL, GS_RENDER_TARGET);
-
-		const struct video_output_info *info =
-			video_output_get_info(video->video);
-		switch (info->format) {
-		case VIDEO_FORMAT_I420:
-			video->convert_textures[1] = gs_texture_create(
-				ovi->output_width / 2, ovi->output_height / 2,
-				GS_R8, 1, NULL, GS_RENDER_TARGET);
-			video->convert_textures[2] = gs_texture_create(
-				ovi->output_width / 2, ovi->output_height / 2,
-				GS_R8, 1, NULL, GS_RENDER_TARGET);
-			if (!video->convert_textures[2])
-				return false;
-			break;
-		case VIDEO_FORMAT_NV12:
-			video->convert_textures[1] = gs_texture_create(
-				ovi->output_width / 2, ovi->output_height / 2,
-				GS_R8G8, 1, NULL, GS_RENDER_TARGET);
-			break;
-		case VIDEO_FORMAT_I444:
-			video->convert_textures[1] = gs_texture_create(
-				ovi->output_width, ovi->output_height, GS_R8, 1,
-				NULL, GS_RENDER_TARGET);
-			video->convert_textures[2] = gs_texture_create(
-				ovi->output_width, ovi->output_height, GS_R8, 1,
-				NULL, GS_RENDER_TARGET);
-			if (!video->convert_textures[2])
-				return false;
-			break;
-		default:
-			break;
-		}
-#ifdef _WIN32
+		if (!video->convert_textures[0] || !video->convert_textures[1])
+			return false;
+		return true;
 	}
 #endif
 
-	if (!video->convert_textures[0])
+	return obs_create_convert_textures(video->convert_textures,
+					   ovi->output_format,
+					   ovi->output_width,
+					   ovi->output_height);
+}
+
+bool obs_create_convert_textures(gs_texture_t *textures[NUM_CHANNELS],
+				 enum video_format format, uint32_t width,
+				 uint32_t height)
+{
+	textures[0] = gs_texture_create(width, height, GS_R8, 1, NULL,
+					GS_RENDER_TARGET);
+
+	switch (format) {
+	case VIDEO_FORMAT_I420:
+		textures[1] = gs_texture_create(width / 2, height / 2, GS_R8, 1,
+						NULL, GS_RENDER_TARGET);
+		textures[2] = gs_texture_create(width / 2, height / 2, GS_R8, 1,
+						NULL, GS_RENDER_TARGET);
+		if (!textures[2])
+			return false;
+		break;
+	case VIDEO_FORMAT_NV12:
+		textures[1] = gs_texture_create(width / 2, height / 2,
+						GS_R8G8, 1, NULL,
+						GS_RENDER_TARGET);
+		break;
+	case VIDEO_FORMAT_I444:
+		textures[1] = gs_texture_create(width, height, GS_R8, 1, NULL,
+						GS_RENDER_TARGET);
+		textures[2] = gs_texture_create(width, height, GS_R8, 1, NULL,
+						GS_RENDER_TARGET);
+		if (!textures[2])
+			return false;
+		break;
+	default:
+		break;
+	}
+
+	if (!textures[0])
 		return false;
-	if (!video->convert_textures[1])
+	if (!textures[1])
 		return false;
 
 	return true;
 }
 
-static bool obs_init_gpu_copy_surfaces(struct obs_video_info *ovi, size_t i)
+bool obs_create_copy_surfaces(gs_stagesurf_t *surfaces[NUM_CHANNELS],
+			      enum video_format format, uint32_t width,
+			      uint32_t height)
 {
-	struct obs_core_video *video = &obs->video;
-
-	video->copy_surfaces[i][0] = gs_stagesurface_create(
-		ovi->output_width, ovi->output_height, GS_R8);
-	if (!video->copy_surfaces[i][0])
+	surfaces[0] = gs_stagesurface_create(width, height, GS_R8);
+	if (!surfaces[0])
 		return false;
 
-	const struct video_output_info *info =
-		video_output_get_info(video->video);
-	switch (info->format) {
+	switch (format) {
 	case VIDEO_FORMAT_I420:
-		video->copy_surfaces[i][1] = gs_stagesurface_create(
-			ovi->output_width / 2, ovi->output_height / 2, GS_R8);
-		if (!video->copy_surfaces[i][1])
+		surfaces[1] =
+			gs_stagesurface_create(width / 2, height / 2, GS_R8);
+		if (!surfaces[1])
 			return false;
-		video->copy_surfaces[i][2] = gs_stagesurface_create(
-			ovi->output_width / 2, ovi->output_height / 2, GS_R8);
-		if (!video->copy_surfaces[i][2])
+		surfaces[2] =
+			gs_stagesurface_create(width / 2, height / 2, GS_R8);
+		if (!surfaces[2])
 			return false;
 		break;
 	case VIDEO_FORMAT_NV12:
-		video->copy_surfaces[i][1] = gs_stagesurface_create(
-			ovi->output_width / 2, ovi->output_height / 2, GS_R8G8);
-		if (!video->copy_surfaces[i][1])
+		surfaces[1] =
+			gs_stagesurface_create(width / 2, height / 2, GS_R8G8);
+		if (!surfaces[1])
 			return false;
 		break;
 	case VIDEO_FORMAT_I444:
-		video->copy_surfaces[i][1] = gs_stagesurface_create(
-			ovi->output_width, ovi->output_height, GS_R8);
-		if (!video->copy_surfaces[i][1])
+		surfaces[1] = gs_stagesurface_create(width, height, GS_R8);
+		if (!surfaces[1])
 			return false;
-		video->copy_surfaces[i][2] = gs_stagesurface_create(
-			ovi->output_width, ovi->output_height, GS_R8);
-		if (!video->copy_surfaces[i][2])
+		surfaces[2] = gs_stagesurface_create(width, height, GS_R8);
+		if (!surfaces[2])
 			return false;
 		break;
 	default:
@@ -199,6 +199,15 @@ static bool obs_init_gpu_copy_surfaces(struct obs_video_info *ovi, size_t i)
 	return true;
 }
 
+static bool obs_init_gpu_copy_surfaces(struct obs_video_info *ovi, size_t i)
+{
+	struct obs_core_video *video = &obs->video;
+
+	return obs_create_copy_surfaces(video->copy_surfaces[i],
+					ovi->output_format, ovi->output_width,
+					ovi->output_height);
+}
+
 static bool obs_init_textures(struct obs_video_info *ovi)
 {
 	struct obs_core_video *video = &obs->video;
@@ -428,6 +437,8 @@ static int obs_init_video(struct obs_video_info *ovi)
 		return OBS_VIDEO_FAIL;
 	if (pthread_mutex_init(&video->task_mutex, NULL) < 0)
 		return OBS_VIDEO_FAIL;
+	if (pthread_mutex_init(&video->rungs_mutex, NULL) < 0)
+		return OBS_VIDEO_FAIL;
 
 #ifdef __APPLE__
 	errorcode = pthread_create(&video->video_thread, NULL,
@@ -458,6 +469,29 @@ static void stop_video(void)
 	}
 }
 
+/* must be called with the graphics context entered */
+static void free_video_rung(struct obs_video_rung *rung)
+{
+	if (!rung)
+		return;
+
+	video_output_close(rung->video);
+
+	for (size_t c = 0; c < NUM_CHANNELS; c++) {
+		if (rung->mapped_surfaces[c])
+			gs_stagesurface_unmap(rung->mapped_surfaces[c]);
+		gs_texture_destroy(rung->convert_textures[c]);
+	}
+
+	for (size_t i = 0; i < NUM_TEXTURES; i++) {
+		for (size_t c = 0; c < NUM_CHANNELS; c++)
+			gs_stagesurface_destroy(rung->copy_surfaces[i][c]);
+	}
+
+	gs_texture_destroy(rung->output_texture);
+	bfree(rung);
+}
+
 static void obs_free_video(void)
 {
 	struct obs_core_video *video = &obs->video;
@@ -471,6 +505,15 @@ static void obs_free_video(void)
 
 		gs_enter_context(video->graphics);
 
+		/* rungs hold no references once all encoders have stopped,
+		 * but free anything left over regardless */
+		for (size_t i = 0; i < video->rungs.num; i++)
+			free_video_rung(video->rungs.array[i]);
+		da_free(video->rungs);
+		for (size_t i = 0; i < video->released_rungs.num; i++)
+			free_video_rung(video->released_rungs.array[i]);
+		da_free(video->released_rungs);
+
 		for (size_t c = 0; c < NUM_CHANNELS; c++) {
 			if (video->mapped_surfaces[c]) {
 				gs_stagesurface_unmap(
@@ -530,6 +573,12 @@ static void obs_free_video(void)
 		pthread_mutex_init_value(&video->task_mutex);
 		circlebuf_free(&video->tasks);
 
+		pthread_mutex_destroy(&video->rungs_mutex);
+		pthread_mutex_init_value(&video->rungs_mutex);
+
+		da_free(video->tick_sources);
+		da_free(video->async_uploads);
+
 		video->gpu_encoder_active = 0;
 		video->cur_texture = 0;
 	}
@@ -615,6 +664,19 @@ static void obs_free_audio(void)
 	memset(audio, 0, sizeof(struct obs_core_audio));
 }
 
+static bool obs_context_index_init(struct obs_context_index *index)
+{
+	memset(index, 0, sizeof(*index));
+	return pthread_rwlock_init(&index->lock, NULL) == 0;
+}
+
+static void obs_context_index_free(struct obs_context_index *index)
+{
+	pthread_rwlock_destroy(&index->lock);
+	bfree(index->buckets);
+	memset(index, 0, sizeof(*index));
+}
+
 static bool obs_init_data(void)
 {
 	struct obs_core_data *data = &obs->data;
@@ -643,6 +705,14 @@ static bool obs_init_data(void)
 		goto fail;
 	if (pthread_mutex_init(&obs->data.draw_callbacks_mutex, &attr) != 0)
 		goto fail;
+	if (!obs_context_index_init(&data->sources_index))
+		goto fail;
+	if (!obs_context_index_init(&data->outputs_index))
+		goto fail;
+	if (!obs_context_index_init(&data->encoders_index))
+		goto fail;
+	if (!obs_context_index_init(&data->services_index))
+		goto fail;
 	if (!obs_view_init(&data->main_view))
 		goto fail;
 
@@ -701,6 +771,10 @@ static void obs_free_data(void)
 	pthread_mutex_destroy(&data->encoders_mutex);
 	pthread_mutex_destroy(&data->services_mutex);
 	pthread_mutex_destroy(&data->draw_callbacks_mutex);
+	obs_context_index_free(&data->sources_index);
+	obs_context_index_free(&data->outputs_index);
+	obs_context_index_free(&data->encoders_index);
+	obs_context_index_free(&data->services_index);
 	da_free(data->draw_callbacks);
 	da_free(data->tick_callbacks);
 	obs_data_release(data->private_data);
@@ -747,7 +821,12 @@ static inline bool obs_init_handlers(void)
 	if (!obs->procs)
 		return false;
 
-	return signal_handler_add_array(obs->signals, obs_signals);
+	if (!signal_handler_add_array(obs->signals, obs_signals))
+		return false;
+
+	obs->source_volume_signal =
+		signal_handler_get_handle(obs->signals, "source_volume");
+	return true;
 }
 
 static pthread_once_t obs_pthread_once_init_token = PTHREAD_ONCE_INIT;
@@ -852,6 +931,7 @@ static bool obs_init(const char *locale, const char *module_config_path,
 
 	pthread_mutex_init_value(&obs->audio.monitoring_mutex);
 	pthread_mutex_init_value(&obs->video.gpu_encoder_mutex);
+	pthread_mutex_init_value(&obs->video.rungs_mutex);
 	pthread_mutex_init_value(&obs->video.task_mutex);
 
 	obs->name_store_owned = !store;
@@ -1041,6 +1121,7 @@ void obs_shutdown(void)
 	obs_free_video();
 	obs_free_hotkeys();
 	obs_free_graphics();
+	obs_encoder_packet_pool_free();
 	proc_handler_destroy(obs->procs);
 	signal_handler_destroy(obs->signals);
 	obs->procs = NULL;
@@ -1185,7 +1266,24 @@ int obs_reset_video(struct obs_video_info *ovi)
 	return obs_init_video(ovi);
 }
 
-bool obs_reset_audio(const struct obs_audio_info *oai)
+static inline const char *
+get_resample_type_name(enum audio_resample_type type)
+{
+	switch (type) {
+	case AUDIO_RESAMPLE_FFMPEG:
+		return "FFmpeg";
+	case AUDIO_RESAMPLE_NATIVE_FAST:
+		return "Native (fast)";
+	case AUDIO_RESAMPLE_NATIVE_MEDIUM:
+		return "Native (medium)";
+	case AUDIO_RESAMPLE_NATIVE_HIGH:
+		return "Native (high)";
+	}
+
+	return "Unknown";
+}
+
+bool obs_reset_audio2(const struct obs_audio_info2 *oai)
 {
 	struct audio_output_info ai;
 
@@ -1201,18 +1299,34 @@ bool obs_reset_audio(const struct obs_audio_info *oai)
 	ai.samples_per_sec = oai->samples_per_sec;
 	ai.format = AUDIO_FORMAT_FLOAT_PLANAR;
 	ai.speakers = oai->speakers;
+	ai.resample_type = oai->resample_type;
 	ai.input_callback = audio_callback;
 
 	blog(LOG_INFO, "---------------------------------");
 	blog(LOG_INFO,
 	     "audio settings reset:\n"
 	     "\tsamples per sec: %d\n"
-	     "\tspeakers:        %d",
-	     (int)ai.samples_per_sec, (int)ai.speakers);
+	     "\tspeakers:        %d\n"
+	     "\tresampler:       %s",
+	     (int)ai.samples_per_sec, (int)ai.speakers,
+	     get_resample_type_name(ai.resample_type));
 
 	return obs_init_audio(&ai);
 }
 
+bool obs_reset_audio(const struct obs_audio_info *oai)
+{
+	struct obs_audio_info2 oai2;
+
+	if (!oai)
+		return obs_reset_audio2(NULL);
+
+	oai2.samples_per_sec = oai->samples_per_sec;
+	oai2.speakers = oai->speakers;
+	oai2.resample_type = AUDIO_RESAMPLE_FFMPEG;
+	return obs_reset_audio2(&oai2);
+}
+
 bool obs_get_video_info(struct obs_video_info *ovi)
 {
 	struct obs_core_video *video = &obs->video;
@@ -1239,6 +1353,22 @@ bool obs_get_audio_info(struct obs_audio_info *oai)
 	return true;
 }
 
+bool obs_get_audio_info2(struct obs_audio_info2 *oai)
+{
+	struct obs_core_audio *audio = &obs->audio;
+	const struct audio_output_info *info;
+
+	if (!oai || !audio->audio)
+		return false;
+
+	info = audio_output_get_info(audio->audio);
+
+	oai->samples_per_sec = info->samples_per_sec;
+	oai->speakers = info->speakers;
+	oai->resample_type = info->resample_type;
+	return true;
+}
+
 bool obs_enum_source_types(size_t idx, const char **id)
 {
 	if (idx >= obs->source_types.num)
@@ -1427,7 +1557,10 @@ void obs_set_output_source(uint32_t channel, obs_source_t *source)
 
 	struct obs_source *prev_source;
 	struct obs_view *view = &obs->data.main_view;
-	struct calldata params = {0};
+	struct calldata params;
+	uint8_t stack[128];
+
+	calldata_init_fixed(&params, stack, sizeof(stack));
 
 	pthread_mutex_lock(&view->channels_mutex);
 
@@ -1440,7 +1573,6 @@ void obs_set_output_source(uint32_t channel, obs_source_t *source)
 	calldata_set_ptr(&params, "source", source);
 	signal_handler_signal(obs->signals, "channel_change", &params);
 	calldata_get_ptr(&params, "source", &source);
-	calldata_free(&params);
 
 	view->channels[channel] = source;
 
@@ -1544,26 +1676,40 @@ void obs_enum_services(bool (*enum_proc)(void *, obs_service_t *), void *param)
 		 param);
 }
 
-static inline void *get_context_by_name(void *vfirst, const char *name,
-					pthread_mutex_t *mutex,
-					void *(*addref)(void *))
+static void *get_context_by_name(struct obs_context_index *index,
+				 const char *name, void *(*addref)(void *))
 {
-	struct obs_context_data **first = vfirst;
-	struct obs_context_data *context;
+	struct obs_context_data *context = NULL;
+	struct obs_context_data *found = NULL;
+	uint32_t hash;
 
-	pthread_mutex_lock(mutex);
+	if (!name)
+		return NULL;
+
+	hash = str_hash(name);
 
-	context = *first;
+	/* lookups only need the index lock, so they don't wait on whatever
+	 * else is holding the list mutex (ticking, rendering, enumerating) */
+	pthread_rwlock_rdlock(&index->lock);
+
+	if (index->num_buckets)
+		context = index->buckets[hash & (index->num_buckets - 1)];
+
+	/* the list walk this replaces found the newest object with the name,
+	 * so duplicate names resolve to the one added last */
 	while (context) {
-		if (!context->private && strcmp(context->name, name) == 0) {
-			context = addref(context);
-			break;
-		}
-		context = context->next;
+		if (context->name_hash == hash &&
+		    strcmp(context->name, name) == 0 &&
+		    (!found || context->index_order > found->index_order))
+			found = context;
+		context = context->hash_next;
 	}
 
-	pthread_mutex_unlock(mutex);
-	return context;
+	if (found)
+		found = addref(found);
+
+	pthread_rwlock_unlock(&index->lock);
+	return found;
 }
 
 static inline void *obs_source_addref_safe_(void *ref)
@@ -1593,29 +1739,25 @@ static inline void *obs_id_(void *data)
 
 obs_source_t *obs_get_source_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_source, name,
-				   &obs->data.sources_mutex,
+	return get_context_by_name(&obs->data.sources_index, name,
 				   obs_source_addref_safe_);
 }
 
 obs_output_t *obs_get_output_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_output, name,
-				   &obs->data.outputs_mutex,
+	return get_context_by_name(&obs->data.outputs_index, name,
 				   obs_output_addref_safe_);
 }
 
 obs_encoder_t *obs_get_encoder_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_encoder, name,
-				   &obs->data.encoders_mutex,
+	return get_context_by_name(&obs->data.encoders_index, name,
 				   obs_encoder_addref_safe_);
 }
 
 obs_service_t *obs_get_service_by_name(const char *name)
 {
-	return get_context_by_name(&obs->data.first_service, name,
-				   &obs->data.services_mutex,
+	return get_context_by_name(&obs->data.services_index, name,
 				   obs_service_addref_safe_);
 }
 
@@ -1722,12 +1864,13 @@ gs_texture_t *obs_get_main_texture(void)
 
 void obs_set_master_volume(float volume)
 {
-	struct calldata data = {0};
+	struct calldata data;
+	uint8_t stack[128];
 
+	calldata_init_fixed(&data, stack, sizeof(stack));
 	calldata_set_float(&data, "volume", volume);
 	signal_handler_signal(obs->signals, "master_volume", &data);
 	volume = (float)calldata_float(&data, "volume");
-	calldata_free(&data);
 
 	obs->audio.user_volume = volume;
 }
@@ -1737,15 +1880,43 @@ float obs_get_master_volume(void)
 	return obs->audio.user_volume;
 }
 
-static obs_source_t *obs_load_source_type(obs_data_t *source_data)
+static inline const char *get_source_data_id(obs_data_t *source_data)
+{
+	const char *v_id = obs_data_get_string(source_data, "versioned_id");
+	return *v_id ? v_id : obs_data_get_string(source_data, "id");
+}
+
+static obs_source_t *obs_create_source_from_data(obs_data_t *source_data,
+						 bool publish)
 {
-	obs_data_array_t *filters = obs_data_get_array(source_data, "filters");
 	obs_source_t *source;
 	const char *name = obs_data_get_string(source_data, "name");
 	const char *id = obs_data_get_string(source_data, "id");
-	const char *v_id = obs_data_get_string(source_data, "versioned_id");
 	obs_data_t *settings = obs_data_get_obj(source_data, "settings");
 	obs_data_t *hotkeys = obs_data_get_obj(source_data, "hotkeys");
+	uint32_t prev_ver;
+
+	prev_ver = (uint32_t)obs_data_get_int(source_data, "prev_ver");
+
+	source = obs_source_create_set_last_ver(get_source_data_id(source_data),
+						name, settings, hotkeys,
+						prev_ver, publish);
+	if (source && source->owns_info_id) {
+		bfree((void *)source->info.unversioned_id);
+		source->info.unversioned_id = bstrdup(id);
+	}
+
+	obs_data_release(hotkeys);
+	obs_data_release(settings);
+	return source;
+}
+
+static obs_source_t *obs_load_source_type(obs_data_t *source_data);
+
+static void obs_apply_source_data(obs_source_t *source,
+				  obs_data_t *source_data)
+{
+	obs_data_array_t *filters = obs_data_get_array(source_data, "filters");
 	double volume;
 	double balance;
 	int64_t sync;
@@ -1759,18 +1930,6 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data)
 
 	prev_ver = (uint32_t)obs_data_get_int(source_data, "prev_ver");
 
-	if (!*v_id)
-		v_id = id;
-
-	source = obs_source_create_set_last_ver(v_id, name, settings, hotkeys,
-						prev_ver);
-	if (source->owns_info_id) {
-		bfree((void *)source->info.unversioned_id);
-		source->info.unversioned_id = bstrdup(id);
-	}
-
-	obs_data_release(hotkeys);
-
 	caps = obs_source_get_output_flags(source);
 
 	obs_data_set_default_double(source_data, "volume", 1.0);
@@ -1862,9 +2021,14 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data)
 
 		obs_data_array_release(filters);
 	}
+}
 
-	obs_data_release(settings);
+static obs_source_t *obs_load_source_type(obs_data_t *source_data)
+{
+	obs_source_t *source = obs_create_source_from_data(source_data, true);
 
+	if (source)
+		obs_apply_source_data(source, source_data);
 	return source;
 }
 
@@ -1873,50 +2037,156 @@ obs_source_t *obs_load_source(obs_data_t *source_data)
 	return obs_load_source_type(source_data);
 }
 
+#define MAX_LOAD_POOL_THREADS 8
+#define SLOW_SOURCE_LOAD_NS 100000000ULL
+
+struct source_load_task {
+	obs_data_t *source_data;
+	obs_source_t *source;
+	uint64_t load_ns;
+};
+
+static inline bool can_create_in_parallel(obs_data_t *source_data)
+{
+	uint32_t flags =
+		obs_get_source_output_flags(get_source_data_id(source_data));
+	return (flags & OBS_SOURCE_PARALLEL_CREATE) != 0;
+}
+
+static size_t get_load_pool_threads(size_t num_tasks)
+{
+	/* the loading thread works through the queue as well */
+	int threads = os_get_logical_cores() - 1;
+
+	if (threads > MAX_LOAD_POOL_THREADS)
+		threads = MAX_LOAD_POOL_THREADS;
+	if (threads > (int)num_tasks - 1)
+		threads = (int)num_tasks - 1;
+	return threads > 0 ? (size_t)threads : 0;
+}
+
+static void create_source_task(void *param)
+{
+	struct source_load_task *task = param;
+	uint64_t start = os_gettime_ns();
+
+	task->source = obs_create_source_from_data(task->source_data, false);
+	task->load_ns += os_gettime_ns() - start;
+}
+
+static void log_source_load_times(const struct source_load_task *tasks,
+				  size_t count, size_t parallel,
+				  uint64_t total_ns)
+{
+	for (size_t i = 0; i < count; i++) {
+		const struct source_load_task *task = &tasks[i];
+		int log_level = task->load_ns >= SLOW_SOURCE_LOAD_NS
+					? LOG_INFO
+					: LOG_DEBUG;
+
+		if (!task->source)
+			continue;
+
+		blog(log_level, "Source '%s' (%s) took %.1f ms to load",
+		     obs_source_get_name(task->source),
+		     obs_source_get_id(task->source),
+		     (double)task->load_ns / 1000000.0);
+	}
+
+	blog(LOG_INFO, "Loaded %d source(s) in %.1f ms, %d created in parallel",
+	     (int)count, (double)total_ns / 1000000.0, (int)parallel);
+}
+
 void obs_load_sources(obs_data_array_t *array, obs_load_source_cb cb,
 		      void *private_data)
 {
 	struct obs_core_data *data = &obs->data;
-	DARRAY(obs_source_t *) sources;
+	DARRAY(struct source_load_task) tasks;
+	uint64_t start_time = os_gettime_ns();
+	size_t parallel = 0;
 	size_t count;
 	size_t i;
 
-	da_init(sources);
+	da_init(tasks);
 
 	count = obs_data_array_count(array);
-	da_reserve(sources, count);
+	da_resize(tasks, count);
+
+	for (i = 0; i < count; i++) {
+		struct source_load_task *task = &tasks.array[i];
+
+		task->source_data = obs_data_array_item(array, i);
+		if (can_create_in_parallel(task->source_data))
+			parallel++;
+	}
+
+	/* sources with a thread-safe create callback are created up front on
+	 * a pool.  no source is added to the source list or signaled until
+	 * its saved data has been applied below, which keeps both of those
+	 * on this thread and in collection order */
+	if (parallel > 1) {
+		os_task_pool_t *pool = os_task_pool_create(
+			"source load", get_load_pool_threads(parallel));
+
+		for (i = 0; i < count; i++) {
+			struct source_load_task *task = &tasks.array[i];
+
+			if (can_create_in_parallel(task->source_data))
+				os_task_pool_queue(pool, create_source_task,
+						   task);
+		}
+
+		os_task_pool_wait(pool);
+		os_task_pool_destroy(pool);
+	} else {
+		parallel = 0;
+	}
 
 	pthread_mutex_lock(&data->sources_mutex);
 
 	for (i = 0; i < count; i++) {
-		obs_data_t *source_data = obs_data_array_item(array, i);
-		obs_source_t *source = obs_load_source(source_data);
-
-		da_push_back(sources, &source);
+		struct source_load_task *task = &tasks.array[i];
+		uint64_t start = os_gettime_ns();
+
+		if (!task->source)
+			task->source = obs_create_source_from_data(
+				task->source_data, false);
+		if (task->source) {
+			obs_apply_source_data(task->source, task->source_data);
+			obs_source_publish(task->source);
+		}
 
-		obs_data_release(source_data);
+		task->load_ns += os_gettime_ns() - start;
 	}
 
 	/* tell sources that we want to load */
-	for (i = 0; i < sources.num; i++) {
-		obs_source_t *source = sources.array[i];
-		obs_data_t *source_data = obs_data_array_item(array, i);
+	for (i = 0; i < count; i++) {
+		struct source_load_task *task = &tasks.array[i];
+		obs_source_t *source = task->source;
+		uint64_t start = os_gettime_ns();
+
 		if (source) {
 			if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
-				obs_transition_load(source, source_data);
+				obs_transition_load(source, task->source_data);
 			obs_source_load2(source);
 			if (cb)
 				cb(private_data, source);
 		}
-		obs_data_release(source_data);
+
+		task->load_ns += os_gettime_ns() - start;
 	}
 
-	for (i = 0; i < sources.num; i++)
-		obs_source_release(sources.array[i]);
+	log_source_load_times(tasks.array, count, parallel,
+			      os_gettime_ns() - start_time);
+
+	for (i = 0; i < count; i++) {
+		obs_source_release(tasks.array[i].source);
+		obs_data_release(tasks.array[i].source_data);
+	}
 
 	pthread_mutex_unlock(&data->sources_mutex);
 
-	da_free(sources);
+	da_free(tasks);
 }
 
 obs_data_t *obs_save_source(obs_source_t *source)
@@ -2045,6 +2315,115 @@ obs_data_array_t *obs_save_sources(void)
 	return obs_save_sources_filtered(save_source_filter, NULL);
 }
 
+/* ------------------------------------------------------------------------- */
+/* context name index */
+
+#define CONTEXT_INDEX_MIN_BUCKETS 64
+
+static struct obs_context_index *get_context_index(enum obs_obj_type type)
+{
+	switch (type) {
+	case OBS_OBJ_TYPE_SOURCE:
+		return &obs->data.sources_index;
+	case OBS_OBJ_TYPE_OUTPUT:
+		return &obs->data.outputs_index;
+	case OBS_OBJ_TYPE_ENCODER:
+		return &obs->data.encoders_index;
+	case OBS_OBJ_TYPE_SERVICE:
+		return &obs->data.services_index;
+	case OBS_OBJ_TYPE_INVALID:
+		break;
+	}
+
+	return NULL;
+}
+
+static inline void context_index_link(struct obs_context_index *index,
+				      struct obs_context_data *context)
+{
+	size_t idx = context->name_hash & (index->num_buckets - 1);
+
+	context->hash_next = index->buckets[idx];
+	index->buckets[idx] = context;
+}
+
+static void context_index_unlink(struct obs_context_index *index,
+				 struct obs_context_data *context)
+{
+	size_t idx = context->name_hash & (index->num_buckets - 1);
+	struct obs_context_data **p_next = &index->buckets[idx];
+
+	while (*p_next) {
+		if (*p_next == context) {
+			*p_next = context->hash_next;
+			break;
+		}
+		p_next = &(*p_next)->hash_next;
+	}
+
+	context->hash_next = NULL;
+}
+
+static void context_index_grow(struct obs_context_index *index)
+{
+	struct obs_context_data **old_buckets = index->buckets;
+	size_t old_size = index->num_buckets;
+
+	index->num_buckets = old_size ? old_size * 2
+				       : CONTEXT_INDEX_MIN_BUCKETS;
+	index->buckets =
+		bzalloc(sizeof(struct obs_context_data *) * index->num_buckets);
+
+	for (size_t i = 0; i < old_size; i++) {
+		struct obs_context_data *context = old_buckets[i];
+
+		while (context) {
+			struct obs_context_data *next = context->hash_next;
+			context_index_link(index, context);
+			context = next;
+		}
+	}
+
+	bfree(old_buckets);
+}
+
+/* context->index is only read or changed with rename_cache_mutex held, which
+ * is taken before the index lock, so a rename can't race an add or remove */
+
+static void context_index_add(struct obs_context_data *context)
+{
+	struct obs_context_index *index = get_context_index(context->type);
+
+	if (!index || context->private || !context->name)
+		return;
+
+	pthread_mutex_lock(&context->rename_cache_mutex);
+	pthread_rwlock_wrlock(&index->lock);
+	if (++index->count > index->num_buckets)
+		context_index_grow(index);
+	context->index_order = ++index->next_order;
+	context_index_link(index, context);
+	context->index = index;
+	pthread_rwlock_unlock(&index->lock);
+	pthread_mutex_unlock(&context->rename_cache_mutex);
+}
+
+static void context_index_remove(struct obs_context_data *context)
+{
+	struct obs_context_index *index;
+
+	pthread_mutex_lock(&context->rename_cache_mutex);
+	index = context->index;
+	if (index) {
+		pthread_rwlock_wrlock(&index->lock);
+		context_index_unlink(index, context);
+		index->count--;
+		context->index = NULL;
+		pthread_rwlock_unlock(&index->lock);
+	}
+	pthread_mutex_unlock(&context->rename_cache_mutex);
+}
+
 /* ensures that names are never blank */
 static inline char *dup_name(const char *name, bool private)
 {
@@ -2087,6 +2466,8 @@ static inline bool obs_context_data_init_wrap(struct obs_context_data *context,
 		return false;
 
 	context->name = dup_name(name, private);
+	if (context->name)
+		context->name_hash = str_hash(context->name);
 	context->settings = obs_data_newref(settings);
 	context->hotkey_data = obs_data_newref(hotkey_data);
 	return true;
@@ -2141,10 +2522,15 @@ void obs_context_data_insert(struct obs_context_data *context,
 	if (context->next)
 		context->next->prev_next = &context->next;
 	pthread_mutex_unlock(mutex);
+
+	context_index_add(context);
 }
 
 void obs_context_data_remove(struct obs_context_data *context)
 {
+	if (context)
+		context_index_remove(context);
+
 	if (context && context->mutex) {
 		pthread_mutex_lock(context->mutex);
 		if (context->prev_next)
@@ -2160,11 +2546,26 @@ void obs_context_data_remove(struct obs_context_data *context)
 void obs_context_data_setname(struct obs_context_data *context,
 			      const char *name)
 {
+	struct obs_context_index *index;
+
 	pthread_mutex_lock(&context->rename_cache_mutex);
 
+	index = context->index;
+	if (index) {
+		pthread_rwlock_wrlock(&index->lock);
+		context_index_unlink(index, context);
+	}
+
 	if (context->name)
 		da_push_back(context->rename_cache, &context->name);
 	context->name = dup_name(name, context->private);
+	context->name_hash =
+		context->name ? str_hash(context->name) : 0;
+
+	if (index) {
+		context_index_link(index, context);
+		pthread_rwlock_unlock(&index->lock);
+	}
 
 	pthread_mutex_unlock(&context->rename_cache_mutex);
 }
@@ -2194,6 +2595,20 @@ uint64_t obs_get_frame_interval_ns(void)
 	return obs->video.video_frame_interval_ns;
 }
 
+uint64_t obs_get_audio_buffering_ns(void)
+{
+	struct obs_core_audio *audio = &obs->audio;
+	uint32_t sample_rate;
+
+	if (!audio->audio)
+		return 0;
+
+	sample_rate = audio_output_get_sample_rate(audio->audio);
+	return audio_frames_to_ns(sample_rate,
+				  (uint64_t)audio->total_buffering_ticks *
+					  AUDIO_OUTPUT_FRAMES);
+}
+
 enum obs_obj_type obs_obj_get_type(void *obj)
 {
 	struct obs_context_data *context = obj;
@@ -2357,6 +2772,157 @@ void stop_raw_video(video_t *v,
 	video_output_disconnect(v, callback, param);
 }
 
+static struct obs_video_rung *create_video_rung(uint32_t width,
+					       uint32_t height)
+{
+	struct obs_core_video *video = &obs->video;
+	const struct video_output_info *voi = video_output_get_info(video->video);
+	struct obs_video_rung *rung = bzalloc(sizeof(struct obs_video_rung));
+	struct video_output_info vi = *voi;
+	bool success = true;
+
+	rung->width = width;
+	rung->height = height;
+	rung->refs = 1;
+
+	if (voi->format == VIDEO_FORMAT_I420 || voi->format == VIDEO_FORMAT_NV12)
+		rung->conversion_width_i = 1.f / (float)width;
+
+	vi.name = "video rung";
+	vi.width = width;
+	vi.height = height;
+	if (video_output_open(&rung->video, &vi) != VIDEO_OUTPUT_SUCCESS) {
+		bfree(rung);
+		return NULL;
+	}
+
+	gs_enter_context(video->graphics);
+
+	rung->output_texture = gs_texture_create(width, height, GS_RGBA, 1,
+						 NULL, GS_RENDER_TARGET);
+	if (!rung->output_texture)
+		success = false;
+	if (success)
+		success = obs_create_convert_textures(rung->convert_textures,
+						      voi->format, width,
+						      height);
+	for (size_t i = 0; success && i < NUM_TEXTURES; i++)
+		success = obs_create_copy_surfaces(rung->copy_surfaces[i],
+						   voi->format, width, height);
+
+	if (!success) {
+		free_video_rung(rung);
+		rung = NULL;
+	}
+
+	gs_leave_context();
+	return rung;
+}
+
+/* Returns a GPU scaled output of the given size, shared between everything
+ * that asks for the same size.  Only available with GPU conversion, returns
+ * NULL otherwise so that callers can fall back to scaling on the CPU. */
+struct obs_video_rung *obs_video_rung_acquire(uint32_t width, uint32_t height)
+{
+	struct obs_core_video *video = &obs->video;
+	struct obs_video_rung *rung = NULL;
+	struct obs_video_rung *new_rung;
+
+	if (!video->video || !video->gpu_conversion || !width || !height)
+		return NULL;
+
+	pthread_mutex_lock(&video->rungs_mutex);
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		struct obs_video_rung *cur = video->rungs.array[i];
+		if (cur->width == width && cur->height == height) {
+			rung = cur;
+			rung->refs++;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&video->rungs_mutex);
+
+	if (rung)
+		return rung;
+
+	/* the graphics thread holds the graphics context while it locks
+	 * rungs_mutex, so create the rung without holding the mutex */
+	new_rung = create_video_rung(width, height);
+	if (!new_rung)
+		return NULL;
+
+	pthread_mutex_lock(&video->rungs_mutex);
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		struct obs_video_rung *cur = video->rungs.array[i];
+		if (cur->width == width && cur->height == height) {
+			rung = cur;
+			rung->refs++;
+			break;
+		}
+	}
+	if (!rung) {
+		rung = new_rung;
+		new_rung = NULL;
+		da_push_back(video->rungs, &rung);
+	}
+	pthread_mutex_unlock(&video->rungs_mutex);
+
+	if (new_rung) {
+		gs_enter_context(video->graphics);
+		free_video_rung(new_rung);
+		gs_leave_context();
+	} else {
+		blog(LOG_INFO, "Created GPU scaled video output: %ux%u", width,
+		     height);
+	}
+
+	return rung;
+}
+
+void obs_video_rung_release(struct obs_video_rung *rung)
+{
+	struct obs_core_video *video = &obs->video;
+	bool destroy;
+
+	if (!rung)
+		return;
+
+	/* an encoder that fails stops itself from receive_video, which runs
+	 * on the rung's own video thread, and closing the rung's video_t from
+	 * there would join that thread and free it while it's still in use.
+	 * the graphics thread frees the rung on its next tick instead. */
+	pthread_mutex_lock(&video->rungs_mutex);
+	destroy = --rung->refs == 0;
+	if (destroy) {
+		da_erase_item(video->rungs, &rung);
+		da_push_back(video->released_rungs, &rung);
+	}
+	pthread_mutex_unlock(&video->rungs_mutex);
+}
+
+/* called from the graphics thread */
+void obs_free_released_video_rungs(void)
+{
+	struct obs_core_video *video = &obs->video;
+	DARRAY(struct obs_video_rung *) released;
+
+	da_init(released);
+
+	pthread_mutex_lock(&video->rungs_mutex);
+	da_move(released, video->released_rungs);
+	pthread_mutex_unlock(&video->rungs_mutex);
+
+	if (!released.num)
+		return;
+
+	gs_enter_context(video->graphics);
+	for (size_t i = 0; i < released.num; i++)
+		free_video_rung(released.array[i]);
+	gs_leave_context();
+
+	da_free(released);
+}
+
 void obs_add_raw_video_callback(const struct video_scale_info *conversion,
 				void (*callback)(void *param,
 						 struct video_data *frame),
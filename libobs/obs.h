@@ -188,6 +188,14 @@ struct obs_audio_info {
 	enum speaker_layout speakers;
 };
 
+struct obs_audio_info2 {
+	uint32_t samples_per_sec;
+	enum speaker_layout speakers;
+
+	/** Resampler used to convert source audio and encoder input */
+	enum audio_resample_type resample_type;
+};
+
 /**
  * Sent to source filters via the filter_audio callback to allow filtering of
  * audio data
@@ -390,12 +398,24 @@ EXPORT int obs_reset_video(struct obs_video_info *ovi);
  */
 EXPORT bool obs_reset_audio(const struct obs_audio_info *oai);
 
+/**
+ * Sets base audio output format/channels/samples/etc along with the
+ * resampler to use.  obs_reset_audio always uses AUDIO_RESAMPLE_FFMPEG.
+ *
+ * @note Cannot reset base audio if an output is currently active.
+ */
+EXPORT bool obs_reset_audio2(const struct obs_audio_info2 *oai);
+
 /** Gets the current video settings, returns false if no video */
 EXPORT bool obs_get_video_info(struct obs_video_info *ovi);
 
 /** Gets the current audio settings, returns false if no audio */
 EXPORT bool obs_get_audio_info(struct obs_audio_info *oai);
 
+/** Gets the current audio settings including the resampler, returns false
+ * if no audio */
+EXPORT bool obs_get_audio_info2(struct obs_audio_info2 *oai);
+
 /**
  * Opens a plugin module directly from a specific path.
  *
@@ -761,6 +781,9 @@ EXPORT double obs_get_active_fps(void);
 EXPORT uint64_t obs_get_average_frame_time_ns(void);
 EXPORT uint64_t obs_get_frame_interval_ns(void);
 
+/** Gets how far the audio mix currently lags behind to wait for sources */
+EXPORT uint64_t obs_get_audio_buffering_ns(void);
+
 EXPORT uint32_t obs_get_total_frames(void);
 EXPORT uint32_t obs_get_lagged_frames(void);
 
@@ -945,6 +968,12 @@ EXPORT void obs_source_update(obs_source_t *source, obs_data_t *settings);
 EXPORT void obs_source_reset_settings(obs_source_t *source,
 				      obs_data_t *settings);
 
+/**
+ * Signals that the video of a source with OBS_SOURCE_STATIC_VIDEO has changed
+ * outside of a settings update, invalidating any cached renders of it.
+ */
+EXPORT void obs_source_content_changed(obs_source_t *source);
+
 /** Renders a video source. */
 EXPORT void obs_source_video_render(obs_source_t *source);
 
@@ -88,56 +88,507 @@ static void a_free(void *ptr)
 }
 
 static struct base_allocator alloc = {a_malloc, a_realloc, a_free};
-static long num_allocs = 0;
 
 void base_set_allocator(struct base_allocator *defs)
 {
 	memcpy(&alloc, defs, sizeof(struct base_allocator));
 }
 
-void *bmalloc(size_t size)
+/* ------------------------------------------------------------------------- */
+/* allocation accounting                                                     */
+
+/*
+ * Counters are kept per thread and only summed when read, so allocating never
+ * touches a cache line shared with other threads.  A block freed on another
+ * thread is taken off that thread's counters, so a single thread's numbers
+ * can go negative, but the sums are always right.  The counters of threads
+ * that exit are folded into retired_stats.
+ *
+ * These are statistics only, so no ordering with other memory is needed,
+ * and only the owning thread ever writes its counters.
+ */
+
+#ifdef _MSC_VER
+static inline long long load_ll(volatile long long *val)
+{
+	return *val;
+}
+
+static inline void add_ll(volatile long long *val, long long add)
+{
+	*val += add;
+}
+#else
+static inline long long load_ll(volatile long long *val)
+{
+	return __atomic_load_n(val, __ATOMIC_RELAXED);
+}
+
+static inline void add_ll(volatile long long *val, long long add)
+{
+	__atomic_store_n(val, __atomic_load_n(val, __ATOMIC_RELAXED) + add,
+			 __ATOMIC_RELAXED);
+}
+#endif
+
+struct thread_stats {
+	volatile long long bytes[BMEM_TAG_COUNT];
+	volatile long long allocs[BMEM_TAG_COUNT];
+	volatile long long frees[BMEM_TAG_COUNT];
+
+	struct thread_stats *next;
+	struct thread_stats **prev_next;
+};
+
+static struct thread_stats retired_stats = {0};
+static struct thread_stats *first_thread_stats = NULL;
+static long long peak_bytes[BMEM_TAG_COUNT] = {0};
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static THREAD_LOCAL struct thread_stats *thread_stats = NULL;
+static pthread_key_t thread_stats_key;
+static pthread_once_t thread_stats_once = PTHREAD_ONCE_INIT;
+static bool thread_stats_key_valid = false;
+
+static THREAD_LOCAL enum bmem_tag thread_tag = BMEM_TAG_GENERAL;
+
+static const char *tag_names[BMEM_TAG_COUNT] = {
+	"general", "video", "audio", "encoder", "output", "data", "graphics",
+};
+
+static void thread_stats_destroy(void *param)
+{
+	struct thread_stats *ts = param;
+
+	pthread_mutex_lock(&stats_mutex);
+	for (size_t i = 0; i < BMEM_TAG_COUNT; i++) {
+		retired_stats.bytes[i] += ts->bytes[i];
+		retired_stats.allocs[i] += ts->allocs[i];
+		retired_stats.frees[i] += ts->frees[i];
+	}
+
+	*ts->prev_next = ts->next;
+	if (ts->next)
+		ts->next->prev_next = ts->prev_next;
+	pthread_mutex_unlock(&stats_mutex);
+
+	alloc.free(ts);
+	thread_stats = NULL;
+}
+
+static void thread_stats_key_init(void)
+{
+	thread_stats_key_valid = pthread_key_create(&thread_stats_key,
+						    thread_stats_destroy) == 0;
+}
+
+static struct thread_stats *create_thread_stats(void)
+{
+	struct thread_stats *ts;
+
+	pthread_once(&thread_stats_once, thread_stats_key_init);
+	if (!thread_stats_key_valid)
+		return &retired_stats;
+
+	ts = alloc.malloc(sizeof(struct thread_stats));
+	if (!ts)
+		return &retired_stats;
+
+	memset(ts, 0, sizeof(struct thread_stats));
+
+	pthread_mutex_lock(&stats_mutex);
+	ts->next = first_thread_stats;
+	ts->prev_next = &first_thread_stats;
+	if (first_thread_stats)
+		first_thread_stats->prev_next = &ts->next;
+	first_thread_stats = ts;
+	pthread_mutex_unlock(&stats_mutex);
+
+	pthread_setspecific(thread_stats_key, ts);
+	thread_stats = ts;
+	return ts;
+}
+
+static inline struct thread_stats *get_thread_stats(void)
+{
+	return thread_stats ? thread_stats : create_thread_stats();
+}
+
+/* if a thread can't get its own counters it shares retired_stats, which is
+ * only safe to update under the mutex */
+static inline void update_stats(enum bmem_tag tag, long long bytes,
+				long long allocs, long long frees)
+{
+	struct thread_stats *ts = get_thread_stats();
+
+	if (ts == &retired_stats) {
+		pthread_mutex_lock(&stats_mutex);
+		ts->bytes[tag] += bytes;
+		ts->allocs[tag] += allocs;
+		ts->frees[tag] += frees;
+		pthread_mutex_unlock(&stats_mutex);
+		return;
+	}
+
+	add_ll(&ts->bytes[tag], bytes);
+	if (allocs)
+		add_ll(&ts->allocs[tag], allocs);
+	if (frees)
+		add_ll(&ts->frees[tag], frees);
+}
+
+static inline void account_alloc(enum bmem_tag tag, size_t size)
+{
+	update_stats(tag, (long long)size, 1, 0);
+}
+
+static inline void account_free(enum bmem_tag tag, size_t size)
+{
+	update_stats(tag, -(long long)size, 0, 1);
+}
+
+static inline void account_resize(enum bmem_tag tag, size_t old_size,
+				  size_t new_size)
+{
+	update_stats(tag, (long long)new_size - (long long)old_size, 0, 0);
+}
+
+/* sums the counters of every thread, stats_mutex must be held */
+static void sum_stats(enum bmem_tag tag, long long *bytes, long long *allocs,
+		      long long *frees)
+{
+	*bytes = retired_stats.bytes[tag];
+	*allocs = retired_stats.allocs[tag];
+	*frees = retired_stats.frees[tag];
+
+	for (struct thread_stats *ts = first_thread_stats; ts; ts = ts->next) {
+		*bytes += load_ll(&ts->bytes[tag]);
+		*allocs += load_ll(&ts->allocs[tag]);
+		*frees += load_ll(&ts->frees[tag]);
+	}
+}
+
+/*
+ * Every block carries a small header in front of the returned pointer so
+ * bfree knows which tag to charge and whether the block belongs to a pool.
+ * The header is padded to the full alignment so the returned pointer stays
+ * aligned.
+ */
+
+struct block_header {
+	size_t size;
+	uint8_t tag;
+	uint8_t pool_class; /* 0 if not pooled, otherwise class index + 1 */
+};
+
+#define HEADER_SIZE ALIGNMENT
+
+static inline struct block_header *get_header(void *ptr)
+{
+	return (struct block_header *)((uint8_t *)ptr - HEADER_SIZE);
+}
+
+static inline void *get_block(struct block_header *header)
+{
+	return (uint8_t *)header + HEADER_SIZE;
+}
+
+static void *alloc_block(size_t size, enum bmem_tag tag, uint8_t pool_class)
 {
-	void *ptr = alloc.malloc(size);
-	if (!ptr && !size)
-		ptr = alloc.malloc(1);
-	if (!ptr) {
+	struct block_header *header = alloc.malloc(size + HEADER_SIZE);
+	if (!header) {
 		os_breakpoint();
 		bcrash("Out of memory while trying to allocate %lu bytes",
 		       (unsigned long)size);
 	}
 
-	os_atomic_inc_long(&num_allocs);
+	header->size = size;
+	header->tag = (uint8_t)tag;
+	header->pool_class = pool_class;
+	return get_block(header);
+}
+
+static inline enum bmem_tag valid_tag(enum bmem_tag tag)
+{
+	return ((int)tag >= 0 && tag < BMEM_TAG_COUNT) ? tag
+						       : BMEM_TAG_GENERAL;
+}
+
+enum bmem_tag bmem_set_thread_tag(enum bmem_tag tag)
+{
+	enum bmem_tag prev = thread_tag;
+	thread_tag = valid_tag(tag);
+	return prev;
+}
+
+enum bmem_tag bmem_get_thread_tag(void)
+{
+	return thread_tag;
+}
+
+const char *bmem_get_tag_name(enum bmem_tag tag)
+{
+	return ((int)tag >= 0 && tag < BMEM_TAG_COUNT) ? tag_names[tag]
+						       : NULL;
+}
+
+bool bmem_get_tag_stats(enum bmem_tag tag, struct bmem_tag_stats *stats)
+{
+	long long frees;
+
+	if ((int)tag < 0 || tag >= BMEM_TAG_COUNT || !stats)
+		return false;
+
+	pthread_mutex_lock(&stats_mutex);
+	sum_stats(tag, &stats->bytes, &stats->total_allocs, &frees);
+
+	/* the counters are split between threads, so the peak is only
+	 * known when they're summed */
+	if (stats->bytes > peak_bytes[tag])
+		peak_bytes[tag] = stats->bytes;
+	stats->peak_bytes = peak_bytes[tag];
+	pthread_mutex_unlock(&stats_mutex);
+
+	stats->count = stats->total_allocs - frees;
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* size-classed pools                                                        */
+
+/*
+ * Pooled blocks are rounded up to a power of two between 64 bytes and 32 KB.
+ * When freed they go back to a small per-thread cache instead of the system
+ * allocator, so subsystems that allocate and free the same sizes over and
+ * over mostly just pop and push a free list.  A block may be freed from any
+ * thread; it simply ends up in that thread's cache.
+ */
+
+#define POOL_MIN_SHIFT 6
+#define POOL_NUM_CLASSES 10
+#define POOL_MAX_CACHED_BYTES (64 * 1024)
+
+struct pool_cache {
+	struct block_header *free_list[POOL_NUM_CLASSES];
+	size_t num_free[POOL_NUM_CLASSES];
+};
+
+static THREAD_LOCAL struct pool_cache *thread_cache = NULL;
+static pthread_key_t pool_cache_key;
+static pthread_once_t pool_cache_once = PTHREAD_ONCE_INIT;
+static bool pool_cache_key_valid = false;
+
+static inline size_t pool_class_size(size_t pool_class)
+{
+	return (size_t)1 << (pool_class + POOL_MIN_SHIFT);
+}
+
+static inline size_t pool_max_cached(size_t pool_class)
+{
+	size_t count = POOL_MAX_CACHED_BYTES / pool_class_size(pool_class);
+	return count < 2 ? 2 : count;
+}
+
+static inline bool get_pool_class(size_t size, size_t *pool_class)
+{
+	for (size_t i = 0; i < POOL_NUM_CLASSES; i++) {
+		if (size <= pool_class_size(i)) {
+			*pool_class = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void pool_cache_destroy(void *param)
+{
+	struct pool_cache *cache = param;
+
+	for (size_t i = 0; i < POOL_NUM_CLASSES; i++) {
+		struct block_header *header = cache->free_list[i];
+
+		while (header) {
+			struct block_header *next;
+			memcpy(&next, get_block(header), sizeof(next));
+			alloc.free(header);
+			header = next;
+		}
+	}
+
+	alloc.free(cache);
+	thread_cache = NULL;
+}
+
+static void pool_cache_key_init(void)
+{
+	pool_cache_key_valid =
+		pthread_key_create(&pool_cache_key, pool_cache_destroy) == 0;
+}
+
+static struct pool_cache *get_thread_cache(void)
+{
+	if (thread_cache)
+		return thread_cache;
+
+	pthread_once(&pool_cache_once, pool_cache_key_init);
+	if (!pool_cache_key_valid)
+		return NULL;
+
+	thread_cache = alloc.malloc(sizeof(struct pool_cache));
+	if (!thread_cache)
+		return NULL;
+
+	memset(thread_cache, 0, sizeof(struct pool_cache));
+	pthread_setspecific(pool_cache_key, thread_cache);
+	return thread_cache;
+}
+
+static void *pool_alloc(size_t pool_class, enum bmem_tag tag)
+{
+	struct pool_cache *cache = get_thread_cache();
+	struct block_header *header = cache ? cache->free_list[pool_class]
+					    : NULL;
+
+	if (!header)
+		return alloc_block(pool_class_size(pool_class), tag,
+				   (uint8_t)(pool_class + 1));
+
+	memcpy(&cache->free_list[pool_class], get_block(header),
+	       sizeof(struct block_header *));
+	cache->num_free[pool_class]--;
+
+	header->tag = (uint8_t)tag;
+	return get_block(header);
+}
+
+static void pool_free(struct block_header *header)
+{
+	size_t pool_class = (size_t)header->pool_class - 1;
+	struct pool_cache *cache = get_thread_cache();
+
+	if (!cache ||
+	    cache->num_free[pool_class] >= pool_max_cached(pool_class)) {
+		alloc.free(header);
+		return;
+	}
+
+	memcpy(get_block(header), &cache->free_list[pool_class],
+	       sizeof(struct block_header *));
+	cache->free_list[pool_class] = header;
+	cache->num_free[pool_class]++;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void *bmalloc_tagged(size_t size, enum bmem_tag tag)
+{
+	void *ptr;
+
+	tag = valid_tag(tag);
+	ptr = alloc_block(size, tag, 0);
+	account_alloc(tag, size);
+
+	return ptr;
+}
+
+void *bmalloc_pooled(size_t size, enum bmem_tag tag)
+{
+	size_t pool_class;
+	void *ptr;
+
+	if (!get_pool_class(size, &pool_class))
+		return bmalloc_tagged(size, tag);
+
+	tag = valid_tag(tag);
+	ptr = pool_alloc(pool_class, tag);
+	account_alloc(tag, pool_class_size(pool_class));
+
 	return ptr;
 }
 
+void *bmalloc(size_t size)
+{
+	return bmalloc_tagged(size, thread_tag);
+}
+
+static void *realloc_pooled(void *ptr, size_t size)
+{
+	struct block_header *header = get_header(ptr);
+	size_t cur_size = pool_class_size((size_t)header->pool_class - 1);
+	enum bmem_tag tag = (enum bmem_tag)header->tag;
+	void *new_ptr;
+
+	if (size <= cur_size)
+		return ptr;
+
+	new_ptr = bmalloc_pooled(size, tag);
+	memcpy(new_ptr, ptr, cur_size);
+	bfree(ptr);
+	return new_ptr;
+}
+
 void *brealloc(void *ptr, size_t size)
 {
+	struct block_header *header;
+	size_t old_size;
+	enum bmem_tag tag;
+
 	if (!ptr)
-		os_atomic_inc_long(&num_allocs);
+		return bmalloc(size);
 
-	ptr = alloc.realloc(ptr, size);
-	if (!ptr && !size)
-		ptr = alloc.realloc(ptr, 1);
-	if (!ptr) {
+	header = get_header(ptr);
+	if (header->pool_class)
+		return realloc_pooled(ptr, size);
+
+	old_size = header->size;
+	tag = (enum bmem_tag)header->tag;
+
+	header = alloc.realloc(header, size + HEADER_SIZE);
+	if (!header) {
 		os_breakpoint();
 		bcrash("Out of memory while trying to allocate %lu bytes",
 		       (unsigned long)size);
 	}
 
-	return ptr;
+	header->size = size;
+	account_resize(tag, old_size, size);
+	return get_block(header);
 }
 
 void bfree(void *ptr)
 {
-	if (ptr) {
-		os_atomic_dec_long(&num_allocs);
-		alloc.free(ptr);
+	struct block_header *header;
+
+	if (!ptr)
+		return;
+
+	header = get_header(ptr);
+
+	if (header->pool_class) {
+		size_t pool_class = (size_t)header->pool_class - 1;
+		account_free((enum bmem_tag)header->tag,
+			     pool_class_size(pool_class));
+		pool_free(header);
+	} else {
+		account_free((enum bmem_tag)header->tag, header->size);
+		alloc.free(header);
 	}
 }
 
 long bnum_allocs(void)
 {
-	return num_allocs;
+	long long count = 0;
+
+	pthread_mutex_lock(&stats_mutex);
+	for (size_t i = 0; i < BMEM_TAG_COUNT; i++) {
+		long long bytes, allocs, frees;
+		sum_stats((enum bmem_tag)i, &bytes, &allocs, &frees);
+		count += allocs - frees;
+	}
+	pthread_mutex_unlock(&stats_mutex);
+
+	return (long)count;
 }
 
 int base_get_alignment(void)
@@ -33,6 +33,36 @@ struct base_allocator {
 
 EXPORT void base_set_allocator(struct base_allocator *defs);
 
+/*
+ * Allocation tags
+ *
+ *   Every allocation is charged to a tag so memory use can be broken down by
+ * subsystem.  bmalloc uses the calling thread's tag, which subsystem threads
+ * set with bmem_set_thread_tag; bmalloc_tagged charges a specific tag.
+ *
+ *   bmalloc_pooled allocates from size-classed per-thread pools, for
+ * subsystems that allocate and free similar sizes at a high rate.  Pooled
+ * memory is freed with bfree like any other allocation.
+ */
+
+enum bmem_tag {
+	BMEM_TAG_GENERAL,
+	BMEM_TAG_VIDEO,
+	BMEM_TAG_AUDIO,
+	BMEM_TAG_ENCODER,
+	BMEM_TAG_OUTPUT,
+	BMEM_TAG_DATA,
+	BMEM_TAG_GRAPHICS,
+	BMEM_TAG_COUNT,
+};
+
+struct bmem_tag_stats {
+	long long bytes;        /* bytes currently allocated */
+	long long peak_bytes;   /* highest value bytes had when read */
+	long long count;        /* allocations currently alive */
+	long long total_allocs; /* allocations made in total */
+};
+
 EXPORT void *bmalloc(size_t size);
 EXPORT void *brealloc(void *ptr, size_t size);
 EXPORT void bfree(void *ptr);
@@ -41,6 +71,15 @@ EXPORT int base_get_alignment(void);
 
 EXPORT long bnum_allocs(void);
 
+EXPORT void *bmalloc_tagged(size_t size, enum bmem_tag tag);
+EXPORT void *bmalloc_pooled(size_t size, enum bmem_tag tag);
+
+EXPORT enum bmem_tag bmem_set_thread_tag(enum bmem_tag tag);
+EXPORT enum bmem_tag bmem_get_thread_tag(void);
+EXPORT const char *bmem_get_tag_name(enum bmem_tag tag);
+EXPORT bool bmem_get_tag_stats(enum bmem_tag tag,
+			       struct bmem_tag_stats *stats);
+
 EXPORT void *bmemdup(const void *ptr, size_t size);
 
 static inline void *bzalloc(size_t size)
@@ -25,6 +25,7 @@
 #include "darray.h"
 #include "lexer.h"
 #include "dstr.h"
+#include "str-hash.h"
 
 struct config_item {
 	char *name;
@@ -54,13 +55,220 @@ static inline void config_section_free(struct config_section *section)
 	bfree(section->name);
 }
 
+/* ------------------------------------------------------------------------- */
+/* Hashed lookup.  The darrays still hold everything in file order for
+ * saving; the index maps names to darray indices and is rebuilt whenever
+ * those indices shift.  Like the linear search it replaces, the first
+ * match in file order wins if a name is repeated. */
+
+#define CONFIG_NONE UINT32_MAX
+
+struct config_slot {
+	uint32_t hash;
+	uint32_t section;
+	uint32_t item;
+};
+
+struct config_table {
+	struct config_slot *slots;
+	size_t num_slots;
+	size_t num_used;
+};
+
+struct config_index {
+	struct config_table sections;
+	struct config_table items;
+	bool valid;
+};
+
 struct config_data {
 	char *file;
 	struct darray sections; /* struct config_section */
 	struct darray defaults; /* struct config_section */
+	struct config_index sections_index;
+	struct config_index defaults_index;
 	pthread_mutex_t mutex;
 };
 
+static inline uint32_t hash_section(const char *section)
+{
+	return str_hash(section);
+}
+
+static inline uint32_t hash_item(const char *section, const char *name)
+{
+	/* separator, so "ab"+"c" and "a"+"bc" don't collide */
+	uint32_t hash = (hash_section(section) ^ 0xFF) * STR_HASH_PRIME;
+	return str_hash_continue(hash, name);
+}
+
+static inline struct config_section *
+get_section(const struct darray *sections, size_t idx)
+{
+	return darray_item(sizeof(struct config_section), sections, idx);
+}
+
+static inline struct config_item *get_item(struct config_section *section,
+					   size_t idx)
+{
+	return darray_item(sizeof(struct config_item), &section->items, idx);
+}
+
+static void config_table_free(struct config_table *table)
+{
+	bfree(table->slots);
+	memset(table, 0, sizeof(*table));
+}
+
+static void config_table_reset(struct config_table *table, size_t count)
+{
+	size_t size = 16;
+
+	while (size < count * 2)
+		size *= 2;
+
+	if (size != table->num_slots) {
+		bfree(table->slots);
+		table->slots = bmalloc(sizeof(struct config_slot) * size);
+		table->num_slots = size;
+	}
+
+	memset(table->slots, 0xFF, sizeof(struct config_slot) * size);
+	table->num_used = 0;
+}
+
+static void config_table_insert(struct config_table *table,
+				const struct config_slot *entry)
+{
+	size_t mask;
+	size_t idx;
+
+	if ((table->num_used + 1) * 2 > table->num_slots) {
+		struct config_table old = *table;
+
+		memset(table, 0, sizeof(*table));
+		config_table_reset(table, old.num_used + 1);
+
+		for (size_t i = 0; i < old.num_slots; i++) {
+			if (old.slots[i].section != CONFIG_NONE)
+				config_table_insert(table, &old.slots[i]);
+		}
+
+		bfree(old.slots);
+	}
+
+	mask = table->num_slots - 1;
+	idx = entry->hash & mask;
+
+	while (table->slots[idx].section != CONFIG_NONE)
+		idx = (idx + 1) & mask;
+
+	table->slots[idx] = *entry;
+	table->num_used++;
+}
+
+static const struct config_slot *
+config_table_find(const struct config_table *table,
+		  const struct darray *sections, uint32_t hash,
+		  const char *section, const char *name)
+{
+	size_t mask;
+	size_t idx;
+
+	if (!table->num_slots)
+		return NULL;
+
+	mask = table->num_slots - 1;
+	idx = hash & mask;
+
+	while (table->slots[idx].section != CONFIG_NONE) {
+		const struct config_slot *slot = &table->slots[idx];
+
+		if (slot->hash == hash) {
+			struct config_section *sec =
+				get_section(sections, slot->section);
+
+			if (astrcmpi(sec->name, section) == 0 &&
+			    (slot->item == CONFIG_NONE ||
+			     astrcmpi(get_item(sec, slot->item)->name,
+				      name) == 0))
+				return slot;
+		}
+
+		idx = (idx + 1) & mask;
+	}
+
+	return NULL;
+}
+
+static void config_index_add_section(struct config_index *index,
+				     const struct darray *sections,
+				     size_t sec_idx)
+{
+	struct config_section *sec = get_section(sections, sec_idx);
+	struct config_slot entry = {hash_section(sec->name), (uint32_t)sec_idx,
+				    CONFIG_NONE};
+
+	if (!config_table_find(&index->sections, sections, entry.hash,
+			       sec->name, NULL))
+		config_table_insert(&index->sections, &entry);
+}
+
+static void config_index_add_item(struct config_index *index,
+				  const struct darray *sections,
+				  size_t sec_idx, size_t item_idx)
+{
+	struct config_section *sec = get_section(sections, sec_idx);
+	struct config_item *item = get_item(sec, item_idx);
+	struct config_slot entry = {hash_item(sec->name, item->name),
+				    (uint32_t)sec_idx, (uint32_t)item_idx};
+
+	if (!config_table_find(&index->items, sections, entry.hash, sec->name,
+			       item->name))
+		config_table_insert(&index->items, &entry);
+}
+
+static void config_index_rebuild(struct config_index *index,
+				 const struct darray *sections)
+{
+	size_t num_items = 0;
+
+	for (size_t i = 0; i < sections->num; i++)
+		num_items += get_section(sections, i)->items.num;
+
+	config_table_reset(&index->sections, sections->num);
+	config_table_reset(&index->items, num_items);
+
+	for (size_t i = 0; i < sections->num; i++) {
+		struct config_section *sec = get_section(sections, i);
+
+		config_index_add_section(index, sections, i);
+		for (size_t j = 0; j < sec->items.num; j++)
+			config_index_add_item(index, sections, i, j);
+	}
+
+	index->valid = true;
+}
+
+static inline void config_index_free(struct config_index *index)
+{
+	config_table_free(&index->sections);
+	config_table_free(&index->items);
+	index->valid = false;
+}
+
+static inline struct config_index *get_index(config_t *config,
+					     const struct darray *sections)
+{
+	struct config_index *index = sections == &config->defaults
+					     ? &config->defaults_index
+					     : &config->sections_index;
+
+	if (!index->valid)
+		config_index_rebuild(index, sections);
+	return index;
+}
+
 static inline bool init_mutex(config_t *config)
 {
 	pthread_mutexattr_t attr;
@@ -350,6 +558,7 @@ int config_open_defaults(config_t *config, const char *file)
 	if (!config)
 		return CONFIG_ERROR;
 
+	config->defaults_index.valid = false;
 	return config_parse_file(&config->defaults, file, false);
 }
 
@@ -491,6 +700,8 @@ void config_close(config_t *config)
 
 	darray_free(&config->defaults);
 	darray_free(&config->sections);
+	config_index_free(&config->defaults_index);
+	config_index_free(&config->sections_index);
 	bfree(config->file);
 	pthread_mutex_destroy(&config->mutex);
 	bfree(config);
@@ -520,70 +731,62 @@ unlock:
 	return name;
 }
 
-static const struct config_item *config_find_item(const struct darray *sections,
+static const struct config_item *config_find_item(config_t *config,
+						  const struct darray *sections,
 						  const char *section,
 						  const char *name)
 {
-	size_t i, j;
-
-	for (i = 0; i < sections->num; i++) {
-		const struct config_section *sec =
-			darray_item(sizeof(struct config_section), sections, i);
-
-		if (astrcmpi(sec->name, section) == 0) {
-			for (j = 0; j < sec->items.num; j++) {
-				struct config_item *item =
-					darray_item(sizeof(struct config_item),
-						    &sec->items, j);
+	struct config_index *index = get_index(config, sections);
+	const struct config_slot *slot;
 
-				if (astrcmpi(item->name, name) == 0)
-					return item;
-			}
-		}
-	}
+	slot = config_table_find(&index->items, sections,
+				 hash_item(section, name), section, name);
+	if (!slot)
+		return NULL;
 
-	return NULL;
+	return get_item(get_section(sections, slot->section), slot->item);
 }
 
 static void config_set_item(config_t *config, struct darray *sections,
 			    const char *section, const char *name, char *value)
 {
-	struct config_section *sec = NULL;
-	struct config_section *array = sections->array;
+	struct config_index *index;
+	const struct config_slot *slot;
 	struct config_item *item;
-	size_t i, j;
+	size_t sec_idx;
 
 	pthread_mutex_lock(&config->mutex);
 
-	for (i = 0; i < sections->num; i++) {
-		struct config_section *cur_sec = array + i;
-		struct config_item *items = cur_sec->items.array;
+	index = get_index(config, sections);
 
-		if (astrcmpi(cur_sec->name, section) == 0) {
-			for (j = 0; j < cur_sec->items.num; j++) {
-				item = items + j;
-
-				if (astrcmpi(item->name, name) == 0) {
-					bfree(item->value);
-					item->value = value;
-					goto unlock;
-				}
-			}
-
-			sec = cur_sec;
-			break;
-		}
+	slot = config_table_find(&index->items, sections,
+				 hash_item(section, name), section, name);
+	if (slot) {
+		item = get_item(get_section(sections, slot->section),
+				slot->item);
+		bfree(item->value);
+		item->value = value;
+		goto unlock;
 	}
 
-	if (!sec) {
-		sec = darray_push_back_new(sizeof(struct config_section),
-					   sections);
+	slot = config_table_find(&index->sections, sections,
+				 hash_section(section), section, NULL);
+	if (slot) {
+		sec_idx = slot->section;
+	} else {
+		struct config_section *sec = darray_push_back_new(
+			sizeof(struct config_section), sections);
 		sec->name = bstrdup(section);
+		sec_idx = sections->num - 1;
+		config_index_add_section(index, sections, sec_idx);
 	}
 
-	item = darray_push_back_new(sizeof(struct config_item), &sec->items);
+	item = darray_push_back_new(sizeof(struct config_item),
+				    &get_section(sections, sec_idx)->items);
 	item->name = bstrdup(name);
 	item->value = value;
+	config_index_add_item(index, sections, sec_idx,
+			      get_section(sections, sec_idx)->items.num - 1);
 
 unlock:
 	pthread_mutex_unlock(&config->mutex);
@@ -682,9 +885,9 @@ const char *config_get_string(config_t *config, const char *section,
 
 	pthread_mutex_lock(&config->mutex);
 
-	item = config_find_item(&config->sections, section, name);
+	item = config_find_item(config, &config->sections, section, name);
 	if (!item)
-		item = config_find_item(&config->defaults, section, name);
+		item = config_find_item(config, &config->defaults, section, name);
 	if (item)
 		value = item->value;
 
@@ -775,6 +978,7 @@ bool config_remove_value(config_t *config, const char *section,
 				config_item_free(item);
 				darray_erase(sizeof(struct config_item),
 					     &sec->items, j);
+				config->sections_index.valid = false;
 				success = true;
 				goto unlock;
 			}
@@ -794,7 +998,7 @@ const char *config_get_default_string(config_t *config, const char *section,
 
 	pthread_mutex_lock(&config->mutex);
 
-	item = config_find_item(&config->defaults, section, name);
+	item = config_find_item(config, &config->defaults, section, name);
 	if (item)
 		value = item->value;
 
@@ -847,7 +1051,8 @@ bool config_has_user_value(config_t *config, const char *section,
 {
 	bool success;
 	pthread_mutex_lock(&config->mutex);
-	success = config_find_item(&config->sections, section, name) != NULL;
+	success = config_find_item(config, &config->sections, section,
+				   name) != NULL;
 	pthread_mutex_unlock(&config->mutex);
 	return success;
 }
@@ -857,7 +1062,8 @@ bool config_has_default_value(config_t *config, const char *section,
 {
 	bool success;
 	pthread_mutex_lock(&config->mutex);
-	success = config_find_item(&config->defaults, section, name) != NULL;
+	success = config_find_item(config, &config->defaults, section,
+				   name) != NULL;
 	pthread_mutex_unlock(&config->mutex);
 	return success;
 }
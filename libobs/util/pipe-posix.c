@@ -14,15 +14,22 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <errno.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
 #include <sys/wait.h>
 
 #include "bmem.h"
 #include "pipe.h"
 
+extern char **environ;
+
 struct os_process_pipe {
 	bool read_pipe;
 	FILE *file;
+	pid_t pid;
 };
 
 os_process_pipe_t *os_process_pipe_create(const char *cmd_line,
@@ -47,12 +54,91 @@ os_process_pipe_t *os_process_pipe_create(const char *cmd_line,
 	return out;
 }
 
+os_process_pipe_t *os_process_pipe_create_fd(const char *cmd_line,
+					     const char *type, int fd)
+{
+	struct os_process_pipe pp = {0};
+	struct os_process_pipe *out;
+	posix_spawn_file_actions_t actions;
+	char *argv[] = {"sh", "-c", (char *)cmd_line, NULL};
+	bool read_pipe;
+	int fds[2];
+	int child_end;
+	int dup_fd;
+	int err;
+
+	if (!cmd_line || !type) {
+		return NULL;
+	}
+
+	read_pipe = *type == 'r';
+
+	if (pipe(fds) == -1) {
+		return NULL;
+	}
+
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+
+	/* dup2 onto the descriptor's own number is a no-op that would leave
+	 * close-on-exec set, so go through a temporary copy */
+	dup_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+	if (dup_fd == -1) {
+		close(fds[0]);
+		close(fds[1]);
+		return NULL;
+	}
+
+	child_end = read_pipe ? fds[1] : fds[0];
+
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, child_end,
+					 read_pipe ? STDOUT_FILENO
+						   : STDIN_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, dup_fd, fd);
+
+	err = posix_spawn(&pp.pid, "/bin/sh", &actions, NULL, argv, environ);
+
+	posix_spawn_file_actions_destroy(&actions);
+	close(dup_fd);
+	close(child_end);
+
+	if (err != 0) {
+		close(read_pipe ? fds[0] : fds[1]);
+		return NULL;
+	}
+
+	pp.file = fdopen(read_pipe ? fds[0] : fds[1], type);
+	pp.read_pipe = read_pipe;
+
+	if (!pp.file) {
+		close(read_pipe ? fds[0] : fds[1]);
+		waitpid(pp.pid, NULL, 0);
+		return NULL;
+	}
+
+	out = bmalloc(sizeof(pp));
+	*out = pp;
+	return out;
+}
+
+static int close_spawned(os_process_pipe_t *pp)
+{
+	int status = -1;
+
+	fclose(pp->file);
+	while (waitpid(pp->pid, &status, 0) == -1 && errno == EINTR)
+		;
+
+	return status;
+}
+
 int os_process_pipe_destroy(os_process_pipe_t *pp)
 {
 	int ret = 0;
 
 	if (pp) {
-		int status = pclose(pp->file);
+		int status = pp->pid ? close_spawned(pp) : pclose(pp->file);
 		if (WIFEXITED(status))
 			ret = (int)(char)WEXITSTATUS(status);
 		bfree(pp);
@@ -61,6 +147,25 @@ int os_process_pipe_destroy(os_process_pipe_t *pp)
 	return ret;
 }
 
+bool os_process_pipe_running(os_process_pipe_t *pp)
+{
+	if (!pp) {
+		return false;
+	}
+
+	/* popen doesn't expose the child, so only a spawned one can be
+	 * checked; WNOWAIT leaves it for os_process_pipe_destroy to reap */
+	if (pp->pid) {
+		siginfo_t info = {0};
+		if (waitid(P_PID, (id_t)pp->pid, &info,
+			   WEXITED | WNOHANG | WNOWAIT) == -1)
+			return false;
+		return info.si_pid == 0;
+	}
+
+	return true;
+}
+
 size_t os_process_pipe_read(os_process_pipe_t *pp, uint8_t *data, size_t len)
 {
 	if (!pp) {
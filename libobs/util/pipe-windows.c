@@ -161,6 +161,15 @@ int os_process_pipe_destroy(os_process_pipe_t *pp)
 	return ret;
 }
 
+bool os_process_pipe_running(os_process_pipe_t *pp)
+{
+	if (!pp) {
+		return false;
+	}
+
+	return WaitForSingleObject(pp->process, 0) == WAIT_TIMEOUT;
+}
+
 size_t os_process_pipe_read(os_process_pipe_t *pp, uint8_t *data, size_t len)
 {
 	DWORD bytes_read;
@@ -23,7 +23,14 @@ typedef struct os_process_pipe os_process_pipe_t;
 
 EXPORT os_process_pipe_t *os_process_pipe_create(const char *cmd_line,
 						 const char *type);
+#ifndef _WIN32
+/* same as os_process_pipe_create, except that fd is passed on to the child
+ * even when it's close-on-exec, so no other child process inherits it */
+EXPORT os_process_pipe_t *os_process_pipe_create_fd(const char *cmd_line,
+						    const char *type, int fd);
+#endif
 EXPORT int os_process_pipe_destroy(os_process_pipe_t *pp);
+EXPORT bool os_process_pipe_running(os_process_pipe_t *pp);
 
 EXPORT size_t os_process_pipe_read(os_process_pipe_t *pp, uint8_t *data,
 				   size_t len);
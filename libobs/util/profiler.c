@@ -5,6 +5,7 @@
 #include "dstr.h"
 #include "platform.h"
 #include "threading.h"
+#include "spsc-ring.h"
 
 #include <math.h>
 
@@ -365,8 +366,317 @@ static void merge_context(profile_call *context)
 	free_call_context(prev_call);
 }
 
+/* ------------------------------------------------------------------------- */
+/* Tracing */
+
+/* Each thread that calls profile_start/profile_end while tracing is enabled
+ * gets its own event ring, which only that thread writes to.  The rings are
+ * drained by profiler_trace_dump_json, which runs under trace_mutex, so each
+ * ring has exactly one producer and one consumer and recording an event
+ * never takes a lock.
+ *
+ * When a thread exits, its ring is released right away if it has been
+ * drained, otherwise the next dump releases it once it has been drained, so
+ * short-lived threads don't keep their rings for the rest of the session. */
+
+struct trace_event {
+	const char *name;
+	uint64_t time;
+	bool begin;
+};
+
+struct trace_thread {
+	struct trace_thread *next;
+	long tid;
+	const char *name;
+	struct spsc_ring events;
+	volatile long dropped;
+	bool exited;
+};
+
+#define DEFAULT_TRACE_EVENTS 65536
+
+static volatile bool trace_enabled = false;
+static volatile long trace_writers = 0;
+static volatile long trace_capacity = DEFAULT_TRACE_EVENTS;
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct trace_thread *trace_threads = NULL;
+static long trace_next_tid = 0;
+static uint64_t trace_start_time = 0;
+
+/* bumped when the rings are freed so threads don't keep using stale ones */
+static volatile long trace_generation = 1;
+
+static THREAD_LOCAL struct trace_thread *thread_trace = NULL;
+static THREAD_LOCAL long thread_trace_generation = 0;
+static pthread_key_t trace_key;
+static pthread_once_t trace_key_once = PTHREAD_ONCE_INIT;
+static bool trace_key_valid = false;
+
+static void free_trace_thread(struct trace_thread *trace)
+{
+	spsc_ring_free(&trace->events);
+	bfree(trace);
+}
+
+/* must be called with trace_mutex held */
+static void unlink_trace_thread(struct trace_thread *trace)
+{
+	struct trace_thread **p_trace = &trace_threads;
+
+	while (*p_trace && *p_trace != trace)
+		p_trace = &(*p_trace)->next;
+	if (*p_trace)
+		*p_trace = trace->next;
+}
+
+static void trace_thread_exit(void *param)
+{
+	struct trace_thread *trace = NULL;
+
+	pthread_mutex_lock(&trace_mutex);
+
+	/* the ring is already gone if the profiler was freed since */
+	if (thread_trace == param &&
+	    thread_trace_generation == os_atomic_load_long(&trace_generation)) {
+		trace = thread_trace;
+
+		if (spsc_ring_size(&trace->events)) {
+			trace->exited = true;
+			trace = NULL;
+		} else {
+			unlink_trace_thread(trace);
+		}
+	}
+
+	pthread_mutex_unlock(&trace_mutex);
+
+	thread_trace = NULL;
+	if (trace)
+		free_trace_thread(trace);
+}
+
+static void trace_key_init(void)
+{
+	trace_key_valid = pthread_key_create(&trace_key, trace_thread_exit) ==
+			  0;
+}
+
+static struct trace_thread *get_thread_trace(void)
+{
+	long generation = os_atomic_load_long(&trace_generation);
+	struct trace_thread *trace;
+
+	if (thread_trace && thread_trace_generation == generation)
+		return thread_trace;
+
+	pthread_once(&trace_key_once, trace_key_init);
+
+	trace = bzalloc(sizeof(struct trace_thread));
+	spsc_ring_init(&trace->events,
+		       sizeof(struct trace_event) *
+			       (size_t)os_atomic_load_long(&trace_capacity));
+
+	pthread_mutex_lock(&trace_mutex);
+	trace->tid = ++trace_next_tid;
+	trace->next = trace_threads;
+	trace_threads = trace;
+	pthread_mutex_unlock(&trace_mutex);
+
+	thread_trace = trace;
+	thread_trace_generation = generation;
+	if (trace_key_valid)
+		pthread_setspecific(trace_key, trace);
+	return trace;
+}
+
+static void trace_event(const char *name, bool begin)
+{
+	struct trace_thread *trace = get_thread_trace();
+	struct trace_event event = {name, os_gettime_ns(), begin};
+
+	/* the first top level scope of a thread names it in the trace */
+	if (begin && !trace->name && !thread_context)
+		trace->name = name;
+
+	if (!spsc_ring_write(&trace->events, &event, sizeof(event)))
+		os_atomic_inc_long(&trace->dropped);
+}
+
+/* trace_writers counts threads that may be inside trace_event, so that
+ * free_trace_threads can wait for them before freeing the rings.  the
+ * count is raised before trace_enabled is checked again, and
+ * free_trace_threads clears trace_enabled before reading the count, so
+ * either a thread sees tracing disabled or it's counted. */
+static inline void record_trace_event(const char *name, bool begin)
+{
+	if (!os_atomic_load_bool(&trace_enabled))
+		return;
+
+	os_atomic_inc_long(&trace_writers);
+	if (os_atomic_load_bool(&trace_enabled))
+		trace_event(name, begin);
+	os_atomic_dec_long(&trace_writers);
+}
+
+void profiler_trace_start(size_t events_per_thread)
+{
+	pthread_mutex_lock(&trace_mutex);
+	if (!trace_start_time)
+		trace_start_time = os_gettime_ns();
+	pthread_mutex_unlock(&trace_mutex);
+
+	if (events_per_thread)
+		os_atomic_set_long(&trace_capacity, (long)events_per_thread);
+	os_atomic_set_bool(&trace_enabled, true);
+}
+
+void profiler_trace_stop(void)
+{
+	os_atomic_set_bool(&trace_enabled, false);
+}
+
+bool profiler_trace_active(void)
+{
+	return os_atomic_load_bool(&trace_enabled);
+}
+
+static void trace_json_cat_string(struct dstr *buffer, const char *str)
+{
+	dstr_cat_ch(buffer, '"');
+	for (; *str; str++) {
+		unsigned char ch = (unsigned char)*str;
+
+		if (ch == '"' || ch == '\\') {
+			dstr_cat_ch(buffer, '\\');
+			dstr_cat_ch(buffer, (char)ch);
+		} else if (ch < 0x20) {
+			dstr_catf(buffer, "\\u%04x", ch);
+		} else {
+			dstr_cat_ch(buffer, (char)ch);
+		}
+	}
+	dstr_cat_ch(buffer, '"');
+}
+
+static void trace_json_separator(struct dstr *buffer, bool *first)
+{
+	dstr_cat(buffer, *first ? "\n" : ",\n");
+	*first = false;
+}
+
+static void trace_dump_thread(struct trace_thread *trace, FILE *f,
+			      struct dstr *buffer, bool *first)
+{
+	struct trace_event event;
+	long dropped = os_atomic_set_long(&trace->dropped, 0);
+
+	if (trace->name) {
+		trace_json_separator(buffer, first);
+		dstr_catf(buffer,
+			  "{\"name\":\"thread_name\",\"ph\":\"M\","
+			  "\"pid\":1,\"tid\":%ld,\"args\":{\"name\":",
+			  trace->tid);
+		trace_json_cat_string(buffer, trace->name);
+		dstr_cat(buffer, "}}");
+	}
+
+	if (dropped) {
+		blog(LOG_WARNING,
+		     "profiler trace: thread %ld dropped %ld events, "
+		     "ring buffer full",
+		     trace->tid, dropped);
+	}
+
+	while (spsc_ring_read(&trace->events, &event, sizeof(event))) {
+		uint64_t ns = event.time > trace_start_time
+				      ? event.time - trace_start_time
+				      : 0;
+
+		trace_json_separator(buffer, first);
+		dstr_cat(buffer, "{\"name\":");
+		trace_json_cat_string(buffer, event.name);
+		dstr_catf(buffer,
+			  ",\"ph\":\"%c\",\"ts\":%" PRIu64 ".%03" PRIu64
+			  ",\"pid\":1,\"tid\":%ld}",
+			  event.begin ? 'B' : 'E', ns / 1000, ns % 1000,
+			  trace->tid);
+
+		if (buffer->len >= 65536) {
+			fwrite(buffer->array, 1, buffer->len, f);
+			dstr_resize(buffer, 0);
+		}
+	}
+}
+
+bool profiler_trace_dump_json(const char *filename)
+{
+	struct dstr buffer = {0};
+	bool first = true;
+	FILE *f;
+
+	f = os_fopen(filename, "wb");
+	if (!f)
+		return false;
+
+	dstr_copy(&buffer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	/* only drains what has been recorded so far, threads keep writing
+	 * into their rings while this runs */
+	pthread_mutex_lock(&trace_mutex);
+	struct trace_thread **p_trace = &trace_threads;
+	while (*p_trace) {
+		struct trace_thread *trace = *p_trace;
+
+		trace_dump_thread(trace, f, &buffer, &first);
+
+		/* nothing writes to the ring of an exited thread anymore */
+		if (trace->exited) {
+			*p_trace = trace->next;
+			free_trace_thread(trace);
+		} else {
+			p_trace = &trace->next;
+		}
+	}
+	pthread_mutex_unlock(&trace_mutex);
+
+	dstr_cat(&buffer, "\n]}\n");
+	fwrite(buffer.array, 1, buffer.len, f);
+	dstr_free(&buffer);
+
+	fclose(f);
+	return true;
+}
+
+static void free_trace_threads(void)
+{
+	struct trace_thread *trace;
+
+	os_atomic_set_bool(&trace_enabled, false);
+	while (os_atomic_load_long(&trace_writers))
+		os_sleep_ms(0);
+
+	pthread_mutex_lock(&trace_mutex);
+	trace = trace_threads;
+	trace_threads = NULL;
+	trace_start_time = 0;
+	os_atomic_inc_long(&trace_generation);
+	pthread_mutex_unlock(&trace_mutex);
+
+	while (trace) {
+		struct trace_thread *next = trace->next;
+		free_trace_thread(trace);
+		trace = next;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* Profiling */
+
 void profile_start(const char *name)
 {
+	record_trace_event(name, true);
+
 	if (!thread_enabled)
 		return;
 
@@ -395,6 +705,9 @@ void profile_start(const char *name)
 void profile_end(const char *name)
 {
 	uint64_t end = os_gettime_ns();
+
+	record_trace_event(name, false);
+
 	if (!thread_enabled)
 		return;
 
@@ -825,6 +1138,8 @@ void profiler_free(void)
 	}
 
 	da_free(old_root_entries);
+
+	free_trace_threads();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -33,6 +33,24 @@ EXPORT void profiler_print_time_between_calls(profiler_snapshot_t *snap);
 
 EXPORT void profiler_free(void);
 
+/* ------------------------------------------------------------------------- */
+/* Tracing
+ *
+ *   While tracing is active, every profile_start/profile_end also records a
+ * timestamped begin/end event into a per-thread ring buffer (events that
+ * don't fit are dropped and counted).  profiler_trace_dump_json drains
+ * everything recorded since the last dump into a Chrome trace event /
+ * Perfetto compatible JSON file, and can be called at any time while the
+ * program keeps running.  Tracing works independently of profiler_start.
+ * events_per_thread sizes rings created from then on, 0 keeps the last size.
+ */
+
+EXPORT void profiler_trace_start(size_t events_per_thread);
+EXPORT void profiler_trace_stop(void);
+EXPORT bool profiler_trace_active(void);
+
+EXPORT bool profiler_trace_dump_json(const char *filename);
+
 /* ------------------------------------------------------------------------- */
 /* Profiler name storage */
 
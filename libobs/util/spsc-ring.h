@@ -0,0 +1,171 @@
+#pragma once
+
+#include "c99defs.h"
+#include <string.h>
+
+#include "bmem.h"
+#include "threading.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Bounded lock-free single-producer/single-consumer byte ring.
+ *
+ * Unlike circlebuf, the ring never grows: writes that don't fit fail as a
+ * whole.  Exactly one thread may write and exactly one thread may read at a
+ * time; spsc_ring_size is for the reader and spsc_ring_space is for the
+ * writer.  The read and write positions live on separate cache lines so the
+ * two threads don't false-share.
+ */
+
+#define SPSC_RING_CACHE_LINE 64
+
+struct spsc_ring {
+	uint8_t *data;
+	long buf_size;
+
+	char pad0[SPSC_RING_CACHE_LINE];
+	volatile long write_pos;
+	char pad1[SPSC_RING_CACHE_LINE - sizeof(long)];
+	volatile long read_pos;
+	char pad2[SPSC_RING_CACHE_LINE - sizeof(long)];
+};
+
+static inline void spsc_ring_init(struct spsc_ring *ring, size_t capacity)
+{
+	memset(ring, 0, sizeof(struct spsc_ring));
+
+	/* one byte is always kept empty so that full and empty differ */
+	ring->buf_size = (long)capacity + 1;
+	ring->data = bmalloc((size_t)ring->buf_size);
+}
+
+static inline void spsc_ring_free(struct spsc_ring *ring)
+{
+	bfree(ring->data);
+	memset(ring, 0, sizeof(struct spsc_ring));
+}
+
+static inline size_t spsc_ring_capacity(const struct spsc_ring *ring)
+{
+	return ring->buf_size ? (size_t)(ring->buf_size - 1) : 0;
+}
+
+static inline size_t spsc_ring_used(const struct spsc_ring *ring, long w,
+				    long r)
+{
+	return (size_t)(w >= r ? w - r : ring->buf_size - r + w);
+}
+
+/* number of bytes available to the reader */
+static inline size_t spsc_ring_size(struct spsc_ring *ring)
+{
+	long w = os_atomic_load_long(&ring->write_pos);
+	long r = os_atomic_load_long(&ring->read_pos);
+
+	return spsc_ring_used(ring, w, r);
+}
+
+/* number of bytes the writer can push without failing */
+static inline size_t spsc_ring_space(struct spsc_ring *ring)
+{
+	long w = os_atomic_load_long(&ring->write_pos);
+	long r = os_atomic_load_long(&ring->read_pos);
+
+	return spsc_ring_capacity(ring) - spsc_ring_used(ring, w, r);
+}
+
+static inline bool spsc_ring_write_internal(struct spsc_ring *ring,
+					    const void *data, size_t size,
+					    bool zero)
+{
+	long w = os_atomic_load_long(&ring->write_pos);
+	long r = os_atomic_load_long(&ring->read_pos);
+	size_t first;
+
+	if (!ring->data ||
+	    size > spsc_ring_capacity(ring) - spsc_ring_used(ring, w, r))
+		return false;
+
+	first = (size_t)(ring->buf_size - w);
+	if (first > size)
+		first = size;
+
+	if (zero) {
+		memset(ring->data + w, 0, first);
+		memset(ring->data, 0, size - first);
+	} else {
+		memcpy(ring->data + w, data, first);
+		memcpy(ring->data, (const uint8_t *)data + first,
+		       size - first);
+	}
+
+	w += (long)size;
+	if (w >= ring->buf_size)
+		w -= ring->buf_size;
+
+	/* publish only after the data has been copied in */
+	os_atomic_store_long(&ring->write_pos, w);
+	return true;
+}
+
+static inline bool spsc_ring_write(struct spsc_ring *ring, const void *data,
+				   size_t size)
+{
+	return spsc_ring_write_internal(ring, data, size, false);
+}
+
+static inline bool spsc_ring_write_zero(struct spsc_ring *ring, size_t size)
+{
+	return spsc_ring_write_internal(ring, NULL, size, true);
+}
+
+static inline bool spsc_ring_read_internal(struct spsc_ring *ring, void *data,
+					   size_t size, bool consume)
+{
+	long w = os_atomic_load_long(&ring->write_pos);
+	long r = os_atomic_load_long(&ring->read_pos);
+	size_t first;
+
+	if (!ring->data || size > spsc_ring_used(ring, w, r))
+		return false;
+
+	if (data) {
+		first = (size_t)(ring->buf_size - r);
+		if (first > size)
+			first = size;
+
+		memcpy(data, ring->data + r, first);
+		memcpy((uint8_t *)data + first, ring->data, size - first);
+	}
+
+	if (consume) {
+		r += (long)size;
+		if (r >= ring->buf_size)
+			r -= ring->buf_size;
+
+		/* hand the space back only after the data has been read */
+		os_atomic_store_long(&ring->read_pos, r);
+	}
+
+	return true;
+}
+
+/* reads and removes size bytes.  data can be NULL to just discard them */
+static inline bool spsc_ring_read(struct spsc_ring *ring, void *data,
+				  size_t size)
+{
+	return spsc_ring_read_internal(ring, data, size, true);
+}
+
+static inline bool spsc_ring_peek(struct spsc_ring *ring, void *data,
+				  size_t size)
+{
+	return spsc_ring_read_internal(ring, data, size, false);
+}
+
+#ifdef __cplusplus
+}
+#endif
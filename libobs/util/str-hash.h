@@ -0,0 +1,45 @@
+#pragma once
+
+#include "c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Case-insensitive (ASCII only) 32-bit FNV-1a string hash, shared by the
+ * name lookup tables.  Lookups that are case sensitive can use it too, as
+ * equal strings always hash the same and they compare the strings anyway.
+ *
+ * str_hash_continue extends a hash with more characters, which lets a key
+ * made of several strings be hashed without joining them first.
+ */
+
+#define STR_HASH_INIT 2166136261u
+#define STR_HASH_PRIME 16777619u
+
+static inline uint32_t str_hash_continue(uint32_t hash, const char *str)
+{
+	if (!str)
+		return hash;
+
+	while (*str) {
+		uint8_t ch = (uint8_t) * (str++);
+		if (ch >= 'A' && ch <= 'Z')
+			ch += 'a' - 'A';
+
+		hash ^= ch;
+		hash *= STR_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+static inline uint32_t str_hash(const char *str)
+{
+	return str_hash_continue(STR_HASH_INIT, str);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2026 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "task-pool.h"
+#include "threading.h"
+#include "circlebuf.h"
+#include "bmem.h"
+#include "dstr.h"
+
+struct task_info {
+	os_task_t task;
+	void *param;
+};
+
+struct task_queue {
+	pthread_mutex_t mutex;
+	struct circlebuf tasks;
+};
+
+struct task_worker {
+	os_task_pool_t *pool;
+	size_t idx;
+	pthread_t thread;
+	bool initialized;
+};
+
+struct os_task_pool {
+	char *name;
+
+	struct task_queue *queues;
+	size_t num_queues;
+
+	struct task_worker *workers;
+	size_t num_threads;
+
+	os_sem_t *work_sem;
+	os_event_t *done_event;
+
+	volatile long pending;
+	volatile long next_queue;
+	volatile bool stop;
+};
+
+static bool pop_task(struct task_queue *queue, struct task_info *info,
+		     bool steal)
+{
+	bool found = false;
+
+	pthread_mutex_lock(&queue->mutex);
+	if (queue->tasks.size) {
+		/* the owner takes from the front, thieves take from the back
+		 * so that they don't fight over the same end of the queue */
+		if (steal)
+			circlebuf_pop_back(&queue->tasks, info, sizeof(*info));
+		else
+			circlebuf_pop_front(&queue->tasks, info, sizeof(*info));
+		found = true;
+	}
+	pthread_mutex_unlock(&queue->mutex);
+
+	return found;
+}
+
+static bool run_next_task(os_task_pool_t *pool, size_t queue_idx)
+{
+	struct task_info info;
+
+	for (size_t i = 0; i < pool->num_queues; i++) {
+		size_t idx = (queue_idx + i) % pool->num_queues;
+
+		if (pop_task(&pool->queues[idx], &info, i != 0)) {
+			info.task(info.param);
+
+			if (os_atomic_dec_long(&pool->pending) == 0)
+				os_event_signal(pool->done_event);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void *worker_thread(void *param)
+{
+	struct task_worker *worker = param;
+	os_task_pool_t *pool = worker->pool;
+	struct dstr name = {0};
+
+	dstr_printf(&name, "%s: worker %d", pool->name, (int)worker->idx);
+	os_set_thread_name(name.array);
+	dstr_free(&name);
+
+	while (os_sem_wait(pool->work_sem) == 0) {
+		if (os_atomic_load_bool(&pool->stop))
+			break;
+
+		run_next_task(pool, worker->idx);
+	}
+
+	return NULL;
+}
+
+os_task_pool_t *os_task_pool_create(const char *name, size_t num_threads)
+{
+	struct os_task_pool *pool = bzalloc(sizeof(struct os_task_pool));
+
+	pool->name = bstrdup(name ? name : "task pool");
+	pool->num_threads = num_threads;
+	pool->num_queues = num_threads ? num_threads : 1;
+
+	if (os_sem_init(&pool->work_sem, 0) != 0)
+		goto fail;
+	if (os_event_init(&pool->done_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail;
+
+	pool->queues = bzalloc(sizeof(struct task_queue) * pool->num_queues);
+	for (size_t i = 0; i < pool->num_queues; i++)
+		pthread_mutex_init(&pool->queues[i].mutex, NULL);
+
+	if (!num_threads)
+		return pool;
+
+	pool->workers = bzalloc(sizeof(struct task_worker) * num_threads);
+	for (size_t i = 0; i < num_threads; i++) {
+		struct task_worker *worker = &pool->workers[i];
+
+		worker->pool = pool;
+		worker->idx = i;
+		if (pthread_create(&worker->thread, NULL, worker_thread,
+				   worker) != 0)
+			goto fail;
+		worker->initialized = true;
+	}
+
+	return pool;
+
+fail:
+	os_task_pool_destroy(pool);
+	return NULL;
+}
+
+void os_task_pool_destroy(os_task_pool_t *pool)
+{
+	if (!pool)
+		return;
+
+	if (pool->queues)
+		os_task_pool_wait(pool);
+
+	os_atomic_set_bool(&pool->stop, true);
+
+	for (size_t i = 0; i < pool->num_threads; i++)
+		os_sem_post(pool->work_sem);
+
+	for (size_t i = 0; i < pool->num_threads; i++) {
+		if (pool->workers && pool->workers[i].initialized)
+			pthread_join(pool->workers[i].thread, NULL);
+	}
+
+	if (pool->queues) {
+		for (size_t i = 0; i < pool->num_queues; i++) {
+			pthread_mutex_destroy(&pool->queues[i].mutex);
+			circlebuf_free(&pool->queues[i].tasks);
+		}
+	}
+
+	os_event_destroy(pool->done_event);
+	os_sem_destroy(pool->work_sem);
+	bfree(pool->workers);
+	bfree(pool->queues);
+	bfree(pool->name);
+	bfree(pool);
+}
+
+size_t os_task_pool_num_threads(const os_task_pool_t *pool)
+{
+	return pool ? pool->num_threads : 0;
+}
+
+void os_task_pool_queue(os_task_pool_t *pool, os_task_t task, void *param)
+{
+	struct task_info info = {task, param};
+	struct task_queue *queue;
+	size_t idx;
+
+	if (!pool || !task)
+		return;
+
+	idx = (size_t)(unsigned long)os_atomic_inc_long(&pool->next_queue) %
+	      pool->num_queues;
+	queue = &pool->queues[idx];
+
+	os_atomic_inc_long(&pool->pending);
+
+	pthread_mutex_lock(&queue->mutex);
+	circlebuf_push_back(&queue->tasks, &info, sizeof(info));
+	pthread_mutex_unlock(&queue->mutex);
+
+	if (pool->num_threads)
+		os_sem_post(pool->work_sem);
+}
+
+void os_task_pool_wait(os_task_pool_t *pool)
+{
+	if (!pool)
+		return;
+
+	/* help out with the remaining work rather than just sleeping, and
+	 * only block once everything left is already running on a worker */
+	while (os_atomic_load_long(&pool->pending) > 0) {
+		if (!run_next_task(pool, 0))
+			os_event_wait(pool->done_event);
+	}
+}
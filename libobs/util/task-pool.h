@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2026 Hugh Bailey <obs.jim@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include "c99defs.h"
+
+/*
+ *   Fixed-size worker thread pool.  Each worker owns a task queue, and
+ * workers that run out of work steal from the other queues.
+ *
+ *   A pool is meant to be driven by a single thread that queues a batch of
+ * independent tasks and then calls os_task_pool_wait, which also executes
+ * queued tasks on the calling thread until the batch is finished.  A pool
+ * created with zero threads simply runs everything inside
+ * os_task_pool_wait.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_task_pool;
+typedef struct os_task_pool os_task_pool_t;
+
+typedef void (*os_task_t)(void *param);
+
+EXPORT os_task_pool_t *os_task_pool_create(const char *name,
+					   size_t num_threads);
+EXPORT void os_task_pool_destroy(os_task_pool_t *pool);
+
+EXPORT size_t os_task_pool_num_threads(const os_task_pool_t *pool);
+
+EXPORT void os_task_pool_queue(os_task_pool_t *pool, os_task_t task,
+			       void *param);
+EXPORT void os_task_pool_wait(os_task_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
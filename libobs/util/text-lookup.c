@@ -18,165 +18,100 @@
 #include "text-lookup.h"
 #include "lexer.h"
 #include "platform.h"
+#include "str-hash.h"
 
 /* ------------------------------------------------------------------------- */
 
+/*
+ * Strings are kept in a flat open-addressed hash table rather than a tree, so
+ * a lookup is one hash of the name plus (almost always) a single probe, and
+ * the full string comparison only happens once the stored hash matches.
+ * Names are compared case-insensitively, so the hash ignores case as well.
+ */
+
 struct text_leaf {
+	uint32_t hash;
 	char *lookup, *value;
 };
 
-static inline void text_leaf_destroy(struct text_leaf *leaf)
-{
-	if (leaf) {
-		bfree(leaf->lookup);
-		bfree(leaf->value);
-		bfree(leaf);
-	}
-}
-
-/* ------------------------------------------------------------------------- */
-
-struct text_node {
-	struct dstr str;
-	struct text_node *first_subnode;
-	struct text_leaf *leaf;
-
-	struct text_node *next;
+struct text_lookup {
+	struct dstr language;
+	struct text_leaf *leaves;
+	size_t num_leaves;
+	size_t count;
 };
 
-static void text_node_destroy(struct text_node *node)
+#define LOOKUP_MIN_LEAVES 64
+
+static inline struct text_leaf *lookup_findleaf(struct text_leaf *leaves,
+						size_t num_leaves,
+						const char *lookup_val,
+						uint32_t hash)
 {
-	struct text_node *subnode;
+	size_t mask = num_leaves - 1;
+	size_t idx = hash & mask;
 
-	if (!node)
-		return;
+	for (;;) {
+		struct text_leaf *leaf = &leaves[idx];
 
-	subnode = node->first_subnode;
-	while (subnode) {
-		struct text_node *destroy_node = subnode;
+		if (!leaf->lookup)
+			return leaf;
+		if (leaf->hash == hash && astrcmpi(leaf->lookup, lookup_val) == 0)
+			return leaf;
 
-		subnode = subnode->next;
-		text_node_destroy(destroy_node);
+		idx = (idx + 1) & mask;
 	}
-
-	dstr_free(&node->str);
-	if (node->leaf)
-		text_leaf_destroy(node->leaf);
-	bfree(node);
 }
 
-static struct text_node *text_node_bychar(struct text_node *node, char ch)
+static void lookup_grow(struct text_lookup *lookup)
 {
-	struct text_node *subnode = node->first_subnode;
-
-	while (subnode) {
-		if (!dstr_is_empty(&subnode->str) &&
-		    subnode->str.array[0] == ch)
-			return subnode;
-
-		subnode = subnode->next;
-	}
+	struct text_leaf *old_leaves = lookup->leaves;
+	size_t old_num = lookup->num_leaves;
+	size_t num_leaves = old_num ? old_num * 2 : LOOKUP_MIN_LEAVES;
 
-	return NULL;
-}
+	lookup->leaves = bzalloc(sizeof(struct text_leaf) * num_leaves);
+	lookup->num_leaves = num_leaves;
 
-static struct text_node *text_node_byname(struct text_node *node,
-					  const char *name)
-{
-	struct text_node *subnode = node->first_subnode;
+	for (size_t i = 0; i < old_num; i++) {
+		struct text_leaf *old = &old_leaves[i];
+		struct text_leaf *leaf;
 
-	while (subnode) {
-		if (astrcmpi_n(subnode->str.array, name, subnode->str.len) == 0)
-			return subnode;
+		if (!old->lookup)
+			continue;
 
-		subnode = subnode->next;
+		leaf = lookup_findleaf(lookup->leaves, num_leaves, old->lookup,
+				       old->hash);
+		*leaf = *old;
 	}
 
-	return NULL;
-}
-
-/* ------------------------------------------------------------------------- */
-
-struct text_lookup {
-	struct dstr language;
-	struct text_node *top;
-};
-
-static void lookup_createsubnode(const char *lookup_val, struct text_leaf *leaf,
-				 struct text_node *node)
-{
-	struct text_node *new = bzalloc(sizeof(struct text_node));
-	new->leaf = leaf;
-	new->next = node->first_subnode;
-	dstr_copy(&new->str, lookup_val);
-
-	node->first_subnode = new;
+	bfree(old_leaves);
 }
 
-static void lookup_splitnode(const char *lookup_val, size_t len,
-			     struct text_leaf *leaf, struct text_node *node)
+static void lookup_addstring(struct text_lookup *lookup, char *lookup_val,
+			     char *value)
 {
-	struct text_node *split = bzalloc(sizeof(struct text_node));
-
-	dstr_copy(&split->str, node->str.array + len);
-	split->leaf = node->leaf;
-	split->first_subnode = node->first_subnode;
-	node->first_subnode = split;
-
-	dstr_resize(&node->str, len);
-
-	if (lookup_val[len] != 0) {
-		node->leaf = NULL;
-		lookup_createsubnode(lookup_val + len, leaf, node);
-	} else {
-		node->leaf = leaf;
-	}
-}
+	uint32_t hash = str_hash(lookup_val);
+	struct text_leaf *leaf;
 
-static inline void lookup_replaceleaf(struct text_node *node,
-				      struct text_leaf *leaf)
-{
-	text_leaf_destroy(node->leaf);
-	node->leaf = leaf;
-}
+	/* keep the table at most half full so probe chains stay short */
+	if ((lookup->count + 1) * 2 > lookup->num_leaves)
+		lookup_grow(lookup);
 
-static void lookup_addstring(const char *lookup_val, struct text_leaf *leaf,
-			     struct text_node *node)
-{
-	struct text_node *child;
+	leaf = lookup_findleaf(lookup->leaves, lookup->num_leaves, lookup_val,
+			       hash);
 
 	/* value already exists, so replace */
-	if (!lookup_val || !*lookup_val) {
-		lookup_replaceleaf(node, leaf);
+	if (leaf->lookup) {
+		bfree(lookup_val);
+		bfree(leaf->value);
+		leaf->value = value;
 		return;
 	}
 
-	child = text_node_bychar(node, *lookup_val);
-	if (child) {
-		size_t len;
-
-		for (len = 0; len < child->str.len; len++) {
-			char val1 = child->str.array[len],
-			     val2 = lookup_val[len];
-
-			if (val1 >= 'A' && val1 <= 'Z')
-				val1 += 0x20;
-			if (val2 >= 'A' && val2 <= 'Z')
-				val2 += 0x20;
-
-			if (val1 != val2)
-				break;
-		}
-
-		if (len == child->str.len) {
-			lookup_addstring(lookup_val + len, leaf, child);
-			return;
-		} else {
-			lookup_splitnode(lookup_val, len, leaf, child);
-		}
-	} else {
-		lookup_createsubnode(lookup_val, leaf, node);
-	}
+	leaf->hash = hash;
+	leaf->lookup = lookup_val;
+	leaf->value = value;
+	lookup->count++;
 }
 
 static void lookup_getstringtoken(struct lexer *lex, struct strref *token)
@@ -304,7 +239,6 @@ static void lookup_addfiledata(struct text_lookup *lookup,
 	strref_clear(&value);
 
 	while (lookup_gettoken(&lex, &name)) {
-		struct text_leaf *leaf;
 		bool got_eq = false;
 
 		if (*name.array == '\n')
@@ -319,11 +253,8 @@ static void lookup_addfiledata(struct text_lookup *lookup,
 			goto getval;
 		}
 
-		leaf = bmalloc(sizeof(struct text_leaf));
-		leaf->lookup = bstrdup_n(name.array, name.len);
-		leaf->value = convert_string(value.array, value.len);
-
-		lookup_addstring(leaf->lookup, leaf, lookup->top);
+		lookup_addstring(lookup, bstrdup_n(name.array, name.len),
+				 convert_string(value.array, value.len));
 
 		if (!lookup_goto_nextline(&lex))
 			break;
@@ -332,28 +263,20 @@ static void lookup_addfiledata(struct text_lookup *lookup,
 	lexer_free(&lex);
 }
 
-static inline bool lookup_getstring(const char *lookup_val, const char **out,
-				    struct text_node *node)
+static inline bool lookup_getstring(struct text_lookup *lookup,
+				    const char *lookup_val, const char **out)
 {
-	struct text_node *child;
-	char ch;
-
-	if (!node)
-		return false;
+	struct text_leaf *leaf;
 
-	child = text_node_byname(node, lookup_val);
-	if (!child)
+	if (!lookup->count || !lookup_val)
 		return false;
 
-	lookup_val += child->str.len;
-	ch = *lookup_val;
-	if (ch)
-		return lookup_getstring(lookup_val, out, child);
-
-	if (!child->leaf)
+	leaf = lookup_findleaf(lookup->leaves, lookup->num_leaves, lookup_val,
+			       str_hash(lookup_val));
+	if (!leaf->lookup)
 		return false;
 
-	*out = child->leaf->value;
+	*out = leaf->value;
 	return true;
 }
 
@@ -388,9 +311,6 @@ bool text_lookup_add(lookup_t *lookup, const char *path)
 	if (!file_str.array)
 		return false;
 
-	if (!lookup->top)
-		lookup->top = bzalloc(sizeof(struct text_node));
-
 	dstr_replace(&file_str, "\r", " ");
 	lookup_addfiledata(lookup, file_str.array);
 	dstr_free(&file_str);
@@ -402,7 +322,12 @@ void text_lookup_destroy(lookup_t *lookup)
 {
 	if (lookup) {
 		dstr_free(&lookup->language);
-		text_node_destroy(lookup->top);
+
+		for (size_t i = 0; i < lookup->num_leaves; i++) {
+			bfree(lookup->leaves[i].lookup);
+			bfree(lookup->leaves[i].value);
+		}
+		bfree(lookup->leaves);
 
 		bfree(lookup);
 	}
@@ -412,6 +337,6 @@ bool text_lookup_getstr(lookup_t *lookup, const char *lookup_val,
 			const char **out)
 {
 	if (lookup)
-		return lookup_getstring(lookup_val, out, lookup->top);
+		return lookup_getstring(lookup, lookup_val, out);
 	return false;
 }
@@ -93,6 +93,8 @@ struct main_params {
 	int color_range;
 	char *acodec;
 	char *muxer_settings;
+	int shm_fd;
+	int shm_size;
 };
 
 struct audio_params {
@@ -124,6 +126,12 @@ struct ffmpeg_mux {
 	int num_audio_streams;
 	bool initialized;
 	char error[4096];
+
+	/* packet data is taken from shared memory instead of stdin */
+	bool use_shm;
+#ifdef FFM_SHM_SUPPORTED
+	struct ffm_shm shm;
+#endif
 };
 
 static void header_free(struct header *header)
@@ -182,6 +190,11 @@ static void ffmpeg_mux_free(struct ffmpeg_mux *ffm)
 
 	dstr_free(&ffm->params.printable_file);
 
+#ifdef FFM_SHM_SUPPORTED
+	if (ffm->use_shm)
+		ffm_shm_unmap(&ffm->shm);
+#endif
+
 	memset(ffm, 0, sizeof(*ffm));
 }
 
@@ -349,6 +362,13 @@ static bool init_params(int *argc, char ***argv, struct main_params *params,
 
 	get_opt_str(argc, argv, &params->muxer_settings, "muxer settings");
 
+	/* only passed when packet data is sent through shared memory */
+	if (*argc >= 2) {
+		get_opt_int(argc, argv, &params->shm_fd, "shared memory fd");
+		get_opt_int(argc, argv, &params->shm_size,
+			    "shared memory size");
+	}
+
 	return true;
 }
 
@@ -534,21 +554,61 @@ static size_t safe_read(void *vdata, size_t size)
 	return total;
 }
 
+/* gets the data of a packet whose info was just read from stdin, either
+ * straight from shared memory or by reading it from stdin into rb */
+static bool ffmpeg_mux_read_data(struct ffmpeg_mux *ffm, struct resize_buf *rb,
+				 struct ffm_packet_info *info, uint8_t **data)
+{
+#ifdef FFM_SHM_SUPPORTED
+	if (ffm->use_shm) {
+		struct ffm_shm_header *header = ffm->shm.header;
+		uint64_t read_pos = ffm_shm_load(&header->read_pos);
+		uint64_t write_pos = ffm_shm_load(&header->write_pos);
+
+		if (write_pos - read_pos < info->size)
+			return false;
+
+		*data = ffm->shm.data + read_pos % ffm->shm.capacity;
+		return true;
+	}
+#endif
+
+	resize_buf_resize(rb, info->size);
+	*data = rb->buf;
+	return safe_read(rb->buf, info->size) == info->size;
+}
+
+/* hands the space used by a packet back to obs once it has been muxed */
+static void ffmpeg_mux_release_data(struct ffmpeg_mux *ffm,
+				    struct ffm_packet_info *info)
+{
+#ifdef FFM_SHM_SUPPORTED
+	if (ffm->use_shm) {
+		uint64_t *read_pos = &ffm->shm.header->read_pos;
+		ffm_shm_store(read_pos, ffm_shm_load(read_pos) + info->size);
+	}
+#else
+	UNUSED_PARAMETER(ffm);
+	UNUSED_PARAMETER(info);
+#endif
+}
+
 static bool ffmpeg_mux_get_header(struct ffmpeg_mux *ffm)
 {
 	struct ffm_packet_info info = {0};
+	struct resize_buf rb = {0};
+	uint8_t *data;
 
 	bool success = safe_read(&info, sizeof(info)) == sizeof(info);
 	if (success) {
-		uint8_t *data = malloc(info.size);
-
-		if (safe_read(data, info.size) == info.size) {
+		if (ffmpeg_mux_read_data(ffm, &rb, &info, &data)) {
 			ffmpeg_mux_header(ffm, data, &info);
+			ffmpeg_mux_release_data(ffm, &info);
 		} else {
 			success = false;
 		}
 
-		free(data);
+		resize_buf_free(&rb);
 	}
 
 	return success;
@@ -705,6 +765,23 @@ static int ffmpeg_mux_init_internal(struct ffmpeg_mux *ffm, int argc,
 			calloc(ffm->params.tracks, sizeof(*ffm->audio_header));
 	}
 
+	if (ffm->params.shm_size > 0) {
+#ifdef FFM_SHM_SUPPORTED
+		if (!ffm_shm_map(&ffm->shm, ffm->params.shm_fd,
+				 (size_t)ffm->params.shm_size)) {
+			fprintf(stderr, "Couldn't map shared memory\n");
+			return FFM_ERROR;
+		}
+
+		/* the mapping keeps the memory alive */
+		close(ffm->params.shm_fd);
+		ffm->use_shm = true;
+#else
+		fprintf(stderr, "Shared memory is not supported\n");
+		return FFM_ERROR;
+#endif
+	}
+
 #if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(58, 9, 100)
 	av_register_all();
 #endif
@@ -828,6 +905,7 @@ int main(int argc, char *argv[])
 	struct ffm_packet_info info = {0};
 	struct ffmpeg_mux ffm = {0};
 	struct resize_buf rb = {0};
+	uint8_t *data;
 	bool fail = false;
 	int ret;
 
@@ -860,10 +938,9 @@ int main(int argc, char *argv[])
 	}
 
 	while (!fail && safe_read(&info, sizeof(info)) == sizeof(info)) {
-		resize_buf_resize(&rb, info.size);
-
-		if (safe_read(rb.buf, info.size) == info.size) {
-			fail = !ffmpeg_mux_packet(&ffm, rb.buf, &info);
+		if (ffmpeg_mux_read_data(&ffm, &rb, &info, &data)) {
+			fail = !ffmpeg_mux_packet(&ffm, data, &info);
+			ffmpeg_mux_release_data(&ffm, &info);
 		} else {
 			fail = true;
 		}
@@ -36,3 +36,133 @@ struct ffm_packet_info {
 	enum ffm_packet_type type;
 	bool keyframe;
 };
+
+/* ------------------------------------------------------------------------- */
+/* Shared memory packet transport
+ *
+ * When enabled, packet data is written straight into a memfd-backed ring
+ * shared with the muxer process instead of being pushed through the pipe.
+ * The pipe still carries the ffm_packet_info of each packet, which tells
+ * the muxer how much data to take from the ring.  The data area is mapped
+ * twice back to back, so a packet that wraps around the end of the ring is
+ * still contiguous in memory and never has to be copied out. */
+
+#ifdef __linux__
+#define FFM_SHM_SUPPORTED
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+#define FFM_SHM_HEADER_SIZE 4096
+
+struct ffm_shm_header {
+	/* total bytes ever written/read, the ring offset is pos % capacity */
+	uint64_t write_pos;
+	uint8_t pad0[64 - sizeof(uint64_t)];
+	uint64_t read_pos;
+	uint8_t pad1[64 - sizeof(uint64_t)];
+};
+
+struct ffm_shm {
+	int fd;
+	size_t capacity;
+	struct ffm_shm_header *header;
+	uint8_t *data;
+};
+
+static inline uint64_t ffm_shm_load(const uint64_t *pos)
+{
+	return __atomic_load_n(pos, __ATOMIC_ACQUIRE);
+}
+
+static inline void ffm_shm_store(uint64_t *pos, uint64_t val)
+{
+	__atomic_store_n(pos, val, __ATOMIC_RELEASE);
+}
+
+static inline void ffm_shm_unmap(struct ffm_shm *shm)
+{
+	if (shm->header)
+		munmap(shm->header, FFM_SHM_HEADER_SIZE);
+	if (shm->data)
+		munmap(shm->data, shm->capacity * 2);
+
+	shm->header = NULL;
+	shm->data = NULL;
+}
+
+/* capacity must be a multiple of the page size */
+static inline bool ffm_shm_map(struct ffm_shm *shm, int fd, size_t capacity)
+{
+	uint8_t *data;
+	void *mirror;
+
+	shm->fd = fd;
+	shm->capacity = capacity;
+
+	shm->header = mmap(NULL, FFM_SHM_HEADER_SIZE, PROT_READ | PROT_WRITE,
+			   MAP_SHARED, fd, 0);
+	if (shm->header == MAP_FAILED) {
+		shm->header = NULL;
+		return false;
+	}
+
+	/* reserve twice the address space, then map the ring into both
+	 * halves of it */
+	data = mmap(NULL, capacity * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+		    -1, 0);
+	if (data == MAP_FAILED) {
+		ffm_shm_unmap(shm);
+		return false;
+	}
+
+	shm->data = data;
+
+	if (mmap(data, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+		 fd, FFM_SHM_HEADER_SIZE) == MAP_FAILED) {
+		ffm_shm_unmap(shm);
+		return false;
+	}
+
+	mirror = mmap(data + capacity, capacity, PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_FIXED, fd, FFM_SHM_HEADER_SIZE);
+	if (mirror == MAP_FAILED) {
+		ffm_shm_unmap(shm);
+		return false;
+	}
+
+	return true;
+}
+
+/* creates the memfd on the obs side.  the descriptor is close-on-exec so
+ * that only the muxer process, which gets it through
+ * os_process_pipe_create_fd, can see the ring */
+static inline bool ffm_shm_create(struct ffm_shm *shm, size_t capacity)
+{
+	int fd = (int)syscall(SYS_memfd_create, "obs-ffmpeg-mux", MFD_CLOEXEC);
+	if (fd == -1)
+		return false;
+
+	if (ftruncate(fd, (off_t)(FFM_SHM_HEADER_SIZE + capacity)) == -1 ||
+	    !ffm_shm_map(shm, fd, capacity)) {
+		close(fd);
+		shm->fd = -1;
+		return false;
+	}
+
+	return true;
+}
+
+static inline void ffm_shm_close(struct ffm_shm *shm)
+{
+	ffm_shm_unmap(shm);
+	if (shm->fd != -1)
+		close(shm->fd);
+	shm->fd = -1;
+}
+#endif
@@ -18,6 +18,7 @@
 #include "obs-ffmpeg-mux.h"
 
 #ifdef _WIN32
+#include <windows.h>
 #include "util/windows/win-version.h"
 #endif
 
@@ -42,6 +43,8 @@ static const char *ffmpeg_mpegts_mux_getname(void *type)
 	return obs_module_text("FFmpegMpegtsMuxer");
 }
 
+static void replay_segment_release(struct replay_segment *segment);
+
 static inline void replay_buffer_clear(struct ffmpeg_muxer *stream)
 {
 	while (stream->packets.size > 0) {
@@ -50,7 +53,15 @@ static inline void replay_buffer_clear(struct ffmpeg_muxer *stream)
 		obs_encoder_packet_release(&pkt);
 	}
 
+	while (stream->segments.size > 0) {
+		struct replay_segment *segment;
+		circlebuf_pop_front(&stream->segments, &segment,
+				    sizeof(segment));
+		replay_segment_release(segment);
+	}
+
 	circlebuf_free(&stream->packets);
+	circlebuf_free(&stream->segments);
 	stream->cur_size = 0;
 	stream->cur_time = 0;
 	stream->max_size = 0;
@@ -66,10 +77,11 @@ static void ffmpeg_mux_destroy(void *data)
 	replay_buffer_clear(stream);
 	if (stream->mux_thread_joinable)
 		pthread_join(stream->mux_thread, NULL);
-	da_free(stream->mux_packets);
+	da_free(stream->mux_segments);
 	circlebuf_free(&stream->packets);
 
-	os_process_pipe_destroy(stream->pipe);
+	stop_pipe(stream);
+	dstr_free(&stream->spill_dir);
 	dstr_free(&stream->path);
 	dstr_free(&stream->printable_path);
 	dstr_free(&stream->stream_key);
@@ -274,12 +286,153 @@ static void build_command_line(struct ffmpeg_muxer *stream, struct dstr *cmd,
 	add_muxer_params(cmd, stream);
 }
 
+#ifdef FFM_SHM_SUPPORTED
+/* the ring holds this many seconds of data at the encoders' bitrates, and
+ * outputs without a bitrate (CQP, CRF, lossless) get the maximum */
+#define SHM_BUFFER_SEC 4
+#define SHM_MIN_CAPACITY (8 * 1024 * 1024)
+#define SHM_MAX_CAPACITY (256 * 1024 * 1024)
+#define SHM_WAIT_TIMEOUT_MS 100
+
+static int get_encoder_bitrate(obs_encoder_t *encoder)
+{
+	obs_data_t *settings = obs_encoder_get_settings(encoder);
+	int bitrate = (int)obs_data_get_int(settings, "bitrate");
+	obs_data_release(settings);
+	return bitrate;
+}
+
+static size_t get_shm_capacity(struct ffmpeg_muxer *stream)
+{
+	obs_encoder_t *vencoder = obs_output_get_video_encoder(stream->output);
+	size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	int video_bitrate = vencoder ? get_encoder_bitrate(vencoder) : 0;
+	uint64_t kbps = (uint64_t)video_bitrate;
+	uint64_t capacity;
+
+	if (vencoder && video_bitrate <= 0)
+		return SHM_MAX_CAPACITY;
+
+	for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+		obs_encoder_t *aencoder =
+			obs_output_get_audio_encoder(stream->output, i);
+		if (!aencoder)
+			break;
+
+		kbps += (uint64_t)get_encoder_bitrate(aencoder);
+	}
+
+	capacity = kbps * 1000 / 8 * SHM_BUFFER_SEC;
+	if (capacity < SHM_MIN_CAPACITY)
+		capacity = SHM_MIN_CAPACITY;
+	else if (capacity > SHM_MAX_CAPACITY)
+		capacity = SHM_MAX_CAPACITY;
+
+	/* the second mapping of the data area has to start on a page */
+	return ((size_t)capacity + page_size - 1) & ~(page_size - 1);
+}
+
+static void start_shm(struct ffmpeg_muxer *stream, struct dstr *cmd)
+{
+	obs_data_t *settings = obs_output_get_settings(stream->output);
+	stream->use_shm = obs_data_get_bool(settings, "shared_memory");
+	obs_data_release(settings);
+
+	if (!stream->use_shm)
+		return;
+
+	size_t capacity = get_shm_capacity(stream);
+
+	if (!ffm_shm_create(&stream->shm, capacity)) {
+		warn("Failed to create shared memory, falling back to pipe");
+		stream->use_shm = false;
+		return;
+	}
+
+	info("Using %zu bytes of shared memory", capacity);
+	dstr_catf(cmd, "%d %d", stream->shm.fd, (int)capacity);
+}
+
+static bool write_shm(struct ffmpeg_muxer *stream, const uint8_t *data,
+		      size_t size)
+{
+	struct ffm_shm *shm = &stream->shm;
+	uint64_t write_pos = ffm_shm_load(&shm->header->write_pos);
+	int wait_ms = 0;
+
+	if (size > shm->capacity) {
+		warn("Packet of %zu bytes does not fit in shared memory",
+		     size);
+		return false;
+	}
+
+	/* a full pipe would block here too, but the muxer only gets a short
+	 * grace period before the output is failed, so a stalled or dead
+	 * muxer can't hold up the encoder thread */
+	while (write_pos + size - ffm_shm_load(&shm->header->read_pos) >
+	       shm->capacity) {
+		if (!os_process_pipe_running(stream->pipe)) {
+			warn("Muxer process exited");
+			return false;
+		}
+		if (wait_ms++ == SHM_WAIT_TIMEOUT_MS) {
+			warn("Muxer is not keeping up, shared memory is full");
+			return false;
+		}
+
+		os_sleep_ms(1);
+	}
+
+	/* the data area is mirrored, so this never needs to be split */
+	memcpy(shm->data + write_pos % shm->capacity, data, size);
+	ffm_shm_store(&shm->header->write_pos, write_pos + size);
+	return true;
+}
+#endif
+
 void start_pipe(struct ffmpeg_muxer *stream, const char *path)
 {
 	struct dstr cmd;
 	build_command_line(stream, &cmd, path);
-	stream->pipe = os_process_pipe_create(cmd.array, "w");
+#ifdef FFM_SHM_SUPPORTED
+	start_shm(stream, &cmd);
+#endif
+#ifdef FFM_SHM_SUPPORTED
+	if (stream->use_shm)
+		stream->pipe = os_process_pipe_create_fd(cmd.array, "w",
+							 stream->shm.fd);
+	else
+#endif
+		stream->pipe = os_process_pipe_create(cmd.array, "w");
 	dstr_free(&cmd);
+
+#ifdef FFM_SHM_SUPPORTED
+	/* the muxer process has its own copy of the descriptor now, the
+	 * mapping stays valid after closing ours */
+	if (stream->use_shm) {
+		close(stream->shm.fd);
+		stream->shm.fd = -1;
+
+		if (!stream->pipe) {
+			ffm_shm_close(&stream->shm);
+			stream->use_shm = false;
+		}
+	}
+#endif
+}
+
+int stop_pipe(struct ffmpeg_muxer *stream)
+{
+	int ret = os_process_pipe_destroy(stream->pipe);
+	stream->pipe = NULL;
+
+#ifdef FFM_SHM_SUPPORTED
+	if (stream->use_shm) {
+		ffm_shm_close(&stream->shm);
+		stream->use_shm = false;
+	}
+#endif
+	return ret;
 }
 
 static void set_file_not_readable_error(struct ffmpeg_muxer *stream,
@@ -375,8 +528,7 @@ int deactivate(struct ffmpeg_muxer *stream, int code)
 	}
 
 	if (active(stream)) {
-		ret = os_process_pipe_destroy(stream->pipe);
-		stream->pipe = NULL;
+		ret = stop_pipe(stream);
 
 		os_atomic_set_bool(&stream->active, false);
 		os_atomic_set_bool(&stream->sent_headers, false);
@@ -469,6 +621,16 @@ bool write_packet(struct ffmpeg_muxer *stream, struct encoder_packet *packet)
 							: FFM_PACKET_AUDIO,
 				       .keyframe = packet->keyframe};
 
+#ifdef FFM_SHM_SUPPORTED
+	/* the data has to be in place before the muxer sees the info */
+	if (stream->use_shm) {
+		if (!write_shm(stream, packet->data, packet->size)) {
+			signal_failure(stream);
+			return false;
+		}
+	}
+#endif
+
 	ret = os_process_pipe_write(stream->pipe, (const uint8_t *)&info,
 				    sizeof(info));
 	if (ret != sizeof(info)) {
@@ -477,11 +639,14 @@ bool write_packet(struct ffmpeg_muxer *stream, struct encoder_packet *packet)
 		return false;
 	}
 
-	ret = os_process_pipe_write(stream->pipe, packet->data, packet->size);
-	if (ret != packet->size) {
-		warn("os_process_pipe_write for packet data failed");
-		signal_failure(stream);
-		return false;
+	if (!stream->use_shm) {
+		ret = os_process_pipe_write(stream->pipe, packet->data,
+					    packet->size);
+		if (ret != packet->size) {
+			warn("os_process_pipe_write for packet data failed");
+			signal_failure(stream);
+			return false;
+		}
 	}
 
 	stream->total_bytes += packet->size;
@@ -568,9 +733,18 @@ static obs_properties_t *ffmpeg_mux_properties(void *unused)
 
 	obs_properties_add_text(props, "path", obs_module_text("FilePath"),
 				OBS_TEXT_DEFAULT);
+#ifdef FFM_SHM_SUPPORTED
+	obs_properties_add_bool(props, "shared_memory",
+				obs_module_text("SharedMemory"));
+#endif
 	return props;
 }
 
+static void ffmpeg_mux_defaults(obs_data_t *s)
+{
+	obs_data_set_default_bool(s, "shared_memory", false);
+}
+
 uint64_t ffmpeg_mux_total_bytes(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -588,6 +762,7 @@ struct obs_output_info ffmpeg_muxer = {
 	.stop = ffmpeg_mux_stop,
 	.encoded_packet = ffmpeg_mux_data,
 	.get_total_bytes = ffmpeg_mux_total_bytes,
+	.get_defaults = ffmpeg_mux_defaults,
 	.get_properties = ffmpeg_mux_properties,
 };
 
@@ -618,6 +793,7 @@ struct obs_output_info ffmpeg_mpegts_muxer = {
 	.stop = ffmpeg_mux_stop,
 	.encoded_packet = ffmpeg_mux_data,
 	.get_total_bytes = ffmpeg_mux_total_bytes,
+	.get_defaults = ffmpeg_mux_defaults,
 	.get_properties = ffmpeg_mux_properties,
 	.get_connect_time_ms = ffmpeg_mpegts_mux_connect_time,
 };
@@ -667,12 +843,45 @@ static void get_last_replay(void *data, calldata_t *cd)
 		calldata_set_string(cd, "path", stream->path.array);
 }
 
+static void get_spill_dir(struct dstr *dir)
+{
+#ifdef _WIN32
+	wchar_t path_utf16[MAX_PATH];
+	DWORD len = GetTempPathW(MAX_PATH, path_utf16);
+	char *path = NULL;
+
+	if (len && len < MAX_PATH)
+		os_wcs_to_utf8_ptr(path_utf16, 0, &path);
+	dstr_copy(dir, path ? path : ".");
+	bfree(path);
+#else
+	const char *tmp = getenv("TMPDIR");
+	dstr_copy(dir, tmp && *tmp ? tmp : "/tmp");
+#endif
+
+	dstr_replace(dir, "\\", "/");
+	if (dstr_end(dir) != '/')
+		dstr_cat_ch(dir, '/');
+	dstr_cat(dir, "obs-replay-cache");
+}
+
 static void *replay_buffer_create(obs_data_t *settings, obs_output_t *output)
 {
 	UNUSED_PARAMETER(settings);
 	struct ffmpeg_muxer *stream = bzalloc(sizeof(*stream));
 	stream->output = output;
 
+	pthread_mutex_init_value(&stream->spill_mutex);
+	if (pthread_mutex_init(&stream->spill_mutex, NULL) != 0 ||
+	    os_sem_init(&stream->spill_sem, 0) != 0) {
+		pthread_mutex_destroy(&stream->spill_mutex);
+		bfree(stream);
+		return NULL;
+	}
+
+	get_spill_dir(&stream->spill_dir);
+	stream->spill_id = os_gettime_ns();
+
 	stream->hotkey =
 		obs_hotkey_register_output(output, "ReplayBuffer.Save",
 					   obs_module_text("ReplayBuffer.Save"),
@@ -694,9 +903,78 @@ static void replay_buffer_destroy(void *data)
 	struct ffmpeg_muxer *stream = data;
 	if (stream->hotkey)
 		obs_hotkey_unregister(stream->hotkey);
+
+	if (stream->spill_thread_active) {
+		os_atomic_set_bool(&stream->spill_exit, true);
+		os_sem_post(stream->spill_sem);
+		pthread_join(stream->spill_thread, NULL);
+	}
+
+	while (stream->spill_queue.size) {
+		struct replay_segment *segment;
+		circlebuf_pop_front(&stream->spill_queue, &segment,
+				    sizeof(segment));
+		replay_segment_release(segment);
+	}
+
+	circlebuf_free(&stream->spill_queue);
+	os_sem_destroy(stream->spill_sem);
+	pthread_mutex_destroy(&stream->spill_mutex);
+
 	ffmpeg_mux_destroy(data);
 }
 
+static void *replay_buffer_spill_thread(void *data);
+
+/* cache files of a previous session that didn't shut down cleanly, nothing
+ * refers to them anymore */
+static void clear_stale_spill_files(struct ffmpeg_muxer *stream)
+{
+	static volatile bool cleared = false;
+	struct dstr pattern = {0};
+	os_glob_t *glob;
+
+	if (os_atomic_set_bool(&cleared, true))
+		return;
+
+	dstr_printf(&pattern, "%s/*.tmp", stream->spill_dir.array);
+
+	if (os_glob(pattern.array, 0, &glob) == 0) {
+		for (size_t i = 0; i < glob->gl_pathc; i++) {
+			if (!glob->gl_pathv[i].directory)
+				os_unlink(glob->gl_pathv[i].path);
+		}
+		os_globfree(glob);
+	}
+
+	dstr_free(&pattern);
+}
+
+static bool start_spilling(struct ffmpeg_muxer *stream)
+{
+	if (os_mkdirs(stream->spill_dir.array) == MKDIR_ERROR) {
+		warn("Failed to create replay buffer cache directory '%s', "
+		     "keeping the buffer in memory",
+		     stream->spill_dir.array);
+		return false;
+	}
+
+	clear_stale_spill_files(stream);
+
+	if (!stream->spill_thread_active) {
+		if (pthread_create(&stream->spill_thread, NULL,
+				   replay_buffer_spill_thread, stream) != 0) {
+			warn("Failed to create replay buffer cache thread, "
+			     "keeping the buffer in memory");
+			return false;
+		}
+
+		stream->spill_thread_active = true;
+	}
+
+	return true;
+}
+
 static bool replay_buffer_start(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -709,8 +987,12 @@ static bool replay_buffer_start(void *data)
 	obs_data_t *s = obs_output_get_settings(stream->output);
 	stream->max_time = obs_data_get_int(s, "max_time_sec") * 1000000LL;
 	stream->max_size = obs_data_get_int(s, "max_size_mb") * (1024 * 1024);
+	stream->spill = obs_data_get_bool(s, "spill_to_disk");
 	obs_data_release(s);
 
+	if (stream->spill && !start_spilling(stream))
+		stream->spill = false;
+
 	os_atomic_set_bool(&stream->active, true);
 	os_atomic_set_bool(&stream->capturing, true);
 	stream->total_bytes = 0;
@@ -719,45 +1001,250 @@ static bool replay_buffer_start(void *data)
 	return true;
 }
 
-static bool purge_front(struct ffmpeg_muxer *stream)
-{
-	struct encoder_packet pkt;
+/* ------------------------------------------------------------------------ */
+/* replay buffer segments
+ *
+ * Buffered packets are grouped into segments that each start at a video
+ * keyframe, so the segment list doubles as a keyframe index: purging drops
+ * whole segments from the front, and saving just takes a reference to every
+ * segment instead of copying the packets.  A segment is sealed once it is
+ * handed to the mux thread, packets that arrive afterwards go into a new
+ * "continuation" segment that doesn't start with a keyframe.
+ *
+ * With spilling enabled, sealed segments are handed to the spill thread,
+ * which writes them out to a temporary file and then drops the packet data
+ * so that only the packet headers stay in memory. */
+
+struct replay_segment {
+	volatile long refs;
+	DARRAY(struct encoder_packet) packets;
+	int64_t size;
 	bool keyframe;
+	bool sealed;
+
+	/* set when the packet data has been written out to disk, the data
+	 * pointers of the packets are NULL in that case.  the mutex guards the
+	 * switch from memory to file against the mux thread reading packets */
+	pthread_mutex_t mutex;
+	char *spill_path;
+	DARRAY(int64_t) offsets;
+};
 
-	circlebuf_pop_front(&stream->packets, &pkt, sizeof(pkt));
+static struct replay_segment *replay_segment_create(bool keyframe)
+{
+	struct replay_segment *segment = bzalloc(sizeof(*segment));
+	segment->refs = 1;
+	segment->keyframe = keyframe;
+	pthread_mutex_init(&segment->mutex, NULL);
+	return segment;
+}
 
-	keyframe = pkt.type == OBS_ENCODER_VIDEO && pkt.keyframe;
+static inline void replay_segment_addref(struct replay_segment *segment)
+{
+	os_atomic_inc_long(&segment->refs);
+}
 
-	if (keyframe)
-		stream->keyframes--;
+static void replay_segment_release(struct replay_segment *segment)
+{
+	if (!segment || os_atomic_dec_long(&segment->refs) != 0)
+		return;
 
-	if (!stream->packets.size) {
-		stream->cur_size = 0;
-		stream->cur_time = 0;
-	} else {
-		struct encoder_packet first;
-		circlebuf_peek_front(&stream->packets, &first, sizeof(first));
-		stream->cur_time = first.dts_usec;
-		stream->cur_size -= (int64_t)pkt.size;
+	for (size_t i = 0; i < segment->packets.num; i++)
+		obs_encoder_packet_release(&segment->packets.array[i]);
+	da_free(segment->packets);
+
+	if (segment->spill_path) {
+		os_unlink(segment->spill_path);
+		bfree(segment->spill_path);
 	}
 
-	obs_encoder_packet_release(&pkt);
-	return keyframe;
+	da_free(segment->offsets);
+	pthread_mutex_destroy(&segment->mutex);
+	bfree(segment);
 }
 
-static inline void purge(struct ffmpeg_muxer *stream)
+static inline struct replay_segment *
+get_segment(struct ffmpeg_muxer *stream, size_t idx)
 {
-	if (purge_front(stream)) {
-		struct encoder_packet pkt;
+	struct replay_segment **p_segment = circlebuf_data(
+		&stream->segments, idx * sizeof(struct replay_segment *));
+	return *p_segment;
+}
 
-		for (;;) {
-			circlebuf_peek_front(&stream->packets, &pkt,
-					     sizeof(pkt));
-			if (pkt.type == OBS_ENCODER_VIDEO && pkt.keyframe)
-				return;
+static inline size_t num_segments(struct ffmpeg_muxer *stream)
+{
+	return stream->segments.size / sizeof(struct replay_segment *);
+}
 
-			purge_front(stream);
+static void spill_segment(struct ffmpeg_muxer *stream,
+			  struct replay_segment *segment)
+{
+	struct dstr path = {0};
+	FILE *file;
+	bool success = true;
+
+	dstr_printf(&path, "%s/%llx-%p-%llu.tmp", stream->spill_dir.array,
+		    (unsigned long long)stream->spill_id, (void *)stream,
+		    (unsigned long long)stream->spill_idx++);
+
+	file = os_fopen(path.array, "wb");
+	if (!file) {
+		warn("Failed to open replay buffer cache file '%s'",
+		     path.array);
+		dstr_free(&path);
+		return;
+	}
+
+	da_reserve(segment->offsets, segment->packets.num);
+
+	for (size_t i = 0; i < segment->packets.num; i++) {
+		struct encoder_packet *pkt = &segment->packets.array[i];
+		int64_t offset = os_ftelli64(file);
+
+		if (fwrite(pkt->data, 1, pkt->size, file) != pkt->size) {
+			success = false;
+			break;
 		}
+
+		da_push_back(segment->offsets, &offset);
+	}
+
+	fclose(file);
+
+	if (!success) {
+		warn("Failed to write replay buffer cache file '%s'",
+		     path.array);
+		os_unlink(path.array);
+		da_free(segment->offsets);
+		dstr_free(&path);
+		return;
+	}
+
+	/* the data lives in the file now, only keep the packet info */
+	pthread_mutex_lock(&segment->mutex);
+
+	for (size_t i = 0; i < segment->packets.num; i++) {
+		struct encoder_packet *pkt = &segment->packets.array[i];
+		struct encoder_packet tmp = *pkt;
+
+		obs_encoder_packet_release(&tmp);
+		pkt->data = NULL;
+	}
+
+	segment->spill_path = path.array;
+
+	pthread_mutex_unlock(&segment->mutex);
+}
+
+static void *replay_buffer_spill_thread(void *data)
+{
+	struct ffmpeg_muxer *stream = data;
+
+	os_set_thread_name("replay buffer cache");
+
+	while (os_sem_wait(stream->spill_sem) == 0) {
+		struct replay_segment *segment = NULL;
+
+		if (os_atomic_load_bool(&stream->spill_exit))
+			break;
+
+		pthread_mutex_lock(&stream->spill_mutex);
+		if (stream->spill_queue.size)
+			circlebuf_pop_front(&stream->spill_queue, &segment,
+					    sizeof(segment));
+		pthread_mutex_unlock(&stream->spill_mutex);
+
+		if (!segment)
+			continue;
+
+		/* if the queue holds the last reference, the segment has
+		 * already been purged and there's no point writing it */
+		if (os_atomic_load_long(&segment->refs) > 1)
+			spill_segment(stream, segment);
+
+		replay_segment_release(segment);
+	}
+
+	return NULL;
+}
+
+/* seals a segment, and with spilling enabled queues it to be written out.
+ * this runs on the encoder thread, so it must never wait on the disk */
+static void seal_segment(struct ffmpeg_muxer *stream,
+			 struct replay_segment *segment)
+{
+	segment->sealed = true;
+
+	if (!stream->spill)
+		return;
+
+	replay_segment_addref(segment);
+
+	pthread_mutex_lock(&stream->spill_mutex);
+	circlebuf_push_back(&stream->spill_queue, &segment, sizeof(segment));
+	pthread_mutex_unlock(&stream->spill_mutex);
+
+	os_sem_post(stream->spill_sem);
+}
+
+static void replay_buffer_push(struct ffmpeg_muxer *stream,
+			       struct encoder_packet *packet)
+{
+	bool keyframe = packet->type == OBS_ENCODER_VIDEO && packet->keyframe;
+	struct replay_segment *segment = NULL;
+	size_t num = num_segments(stream);
+
+	if (num)
+		segment = get_segment(stream, num - 1);
+
+	if (!segment || segment->sealed || keyframe) {
+		/* segments that are already sealed have been handed to the
+		 * mux thread and must not be touched anymore */
+		if (segment && !segment->sealed)
+			seal_segment(stream, segment);
+
+		segment = replay_segment_create(keyframe);
+		circlebuf_push_back(&stream->segments, &segment,
+				    sizeof(segment));
+		if (keyframe)
+			stream->keyframes++;
+	}
+
+	if (!num)
+		stream->cur_time = packet->dts_usec;
+
+	da_push_back(segment->packets, packet);
+	segment->size += (int64_t)packet->size;
+	stream->cur_size += (int64_t)packet->size;
+}
+
+static void purge_front(struct ffmpeg_muxer *stream)
+{
+	struct replay_segment *segment;
+
+	circlebuf_pop_front(&stream->segments, &segment, sizeof(segment));
+
+	if (segment->keyframe)
+		stream->keyframes--;
+	stream->cur_size -= segment->size;
+
+	replay_segment_release(segment);
+}
+
+static inline void purge(struct ffmpeg_muxer *stream)
+{
+	purge_front(stream);
+
+	/* continuation segments belong to the keyframe before them */
+	while (num_segments(stream) && !get_segment(stream, 0)->keyframe)
+		purge_front(stream);
+
+	if (num_segments(stream)) {
+		struct replay_segment *first = get_segment(stream, 0);
+		stream->cur_time = first->packets.array[0].dts_usec;
+	} else {
+		stream->cur_size = 0;
+		stream->cur_time = 0;
 	}
 }
 
@@ -765,57 +1252,158 @@ static inline void replay_buffer_purge(struct ffmpeg_muxer *stream,
 				       struct encoder_packet *pkt)
 {
 	if (stream->max_size) {
-		if (!stream->packets.size || stream->keyframes <= 2)
+		if (!num_segments(stream) || stream->keyframes <= 2)
 			return;
 
-		while ((stream->cur_size + (int64_t)pkt->size) >
-		       stream->max_size)
+		while (num_segments(stream) &&
+		       (stream->cur_size + (int64_t)pkt->size) >
+			       stream->max_size)
 			purge(stream);
 	}
 
-	if (!stream->packets.size || stream->keyframes <= 2)
+	if (!num_segments(stream) || stream->keyframes <= 2)
 		return;
 
-	while ((pkt->dts_usec - stream->cur_time) > stream->max_time)
+	while (num_segments(stream) &&
+	       (pkt->dts_usec - stream->cur_time) > stream->max_time)
 		purge(stream);
 }
 
-static void insert_packet(struct darray *array, struct encoder_packet *packet,
+struct mux_packet {
+	struct encoder_packet packet;
+	struct replay_segment *segment;
+	size_t idx;
+};
+
+static void insert_packet(struct darray *array, struct mux_packet *mux_pkt,
 			  int64_t video_offset, int64_t *audio_offsets,
 			  int64_t video_dts_offset, int64_t *audio_dts_offsets)
 {
-	struct encoder_packet pkt;
-	DARRAY(struct encoder_packet) packets;
+	struct encoder_packet *pkt = &mux_pkt->packet;
+	DARRAY(struct mux_packet) packets;
 	packets.da = *array;
 	size_t idx;
 
-	obs_encoder_packet_ref(&pkt, packet);
-
-	if (pkt.type == OBS_ENCODER_VIDEO) {
-		pkt.dts_usec -= video_offset;
-		pkt.dts -= video_dts_offset;
-		pkt.pts -= video_dts_offset;
+	if (pkt->type == OBS_ENCODER_VIDEO) {
+		pkt->dts_usec -= video_offset;
+		pkt->dts -= video_dts_offset;
+		pkt->pts -= video_dts_offset;
 	} else {
-		pkt.dts_usec -= audio_offsets[pkt.track_idx];
-		pkt.dts -= audio_dts_offsets[pkt.track_idx];
-		pkt.pts -= audio_dts_offsets[pkt.track_idx];
+		pkt->dts_usec -= audio_offsets[pkt->track_idx];
+		pkt->dts -= audio_dts_offsets[pkt->track_idx];
+		pkt->pts -= audio_dts_offsets[pkt->track_idx];
 	}
 
 	for (idx = packets.num; idx > 0; idx--) {
-		struct encoder_packet *p = packets.array + (idx - 1);
-		if (p->dts_usec < pkt.dts_usec)
+		struct mux_packet *p = packets.array + (idx - 1);
+		if (p->packet.dts_usec < pkt->dts_usec)
 			break;
 	}
 
-	da_insert(packets, idx, &pkt);
+	da_insert(packets, idx, mux_pkt);
 	*array = packets.da;
 }
 
+/* packets are referenced by the segments they came from, so only the
+ * packet info is copied here, never the data */
+static void reorder_packets(struct ffmpeg_muxer *stream, struct darray *array)
+{
+	bool found_video = false;
+	bool found_audio[MAX_AUDIO_MIXES] = {0};
+	int64_t video_offset = 0;
+	int64_t video_dts_offset = 0;
+	int64_t audio_offsets[MAX_AUDIO_MIXES] = {0};
+	int64_t audio_dts_offsets[MAX_AUDIO_MIXES] = {0};
+
+	for (size_t i = 0; i < stream->mux_segments.num; i++) {
+		struct replay_segment *segment = stream->mux_segments.array[i];
+
+		for (size_t j = 0; j < segment->packets.num; j++) {
+			struct mux_packet mux_pkt = {
+				.packet = segment->packets.array[j],
+				.segment = segment,
+				.idx = j,
+			};
+			struct encoder_packet *pkt = &mux_pkt.packet;
+
+			if (pkt->type == OBS_ENCODER_VIDEO) {
+				if (!found_video) {
+					video_offset = pkt->dts_usec;
+					video_dts_offset = pkt->dts;
+					found_video = true;
+				}
+			} else {
+				if (!found_audio[pkt->track_idx]) {
+					found_audio[pkt->track_idx] = true;
+					audio_offsets[pkt->track_idx] =
+						pkt->dts_usec;
+					audio_dts_offsets[pkt->track_idx] =
+						pkt->dts;
+				}
+			}
+
+			insert_packet(array, &mux_pkt, video_offset,
+				      audio_offsets, video_dts_offset,
+				      audio_dts_offsets);
+		}
+	}
+}
+
+static bool load_spilled_packet(struct ffmpeg_muxer *stream,
+				struct mux_packet *mux_pkt, FILE **file,
+				struct replay_segment **file_segment,
+				struct darray *buf)
+{
+	struct replay_segment *segment = mux_pkt->segment;
+	struct encoder_packet *pkt = &mux_pkt->packet;
+	DARRAY(uint8_t) data;
+	data.da = *buf;
+
+	if (*file_segment != segment) {
+		if (*file)
+			fclose(*file);
+
+		*file = os_fopen(segment->spill_path, "rb");
+		*file_segment = segment;
+		if (!*file) {
+			warn("Failed to open replay buffer cache file '%s'",
+			     segment->spill_path);
+			return false;
+		}
+	}
+
+	if (!*file)
+		return false;
+
+	da_resize(data, pkt->size);
+	*buf = data.da;
+
+	if (os_fseeki64(*file, segment->offsets.array[mux_pkt->idx],
+			SEEK_SET) != 0 ||
+	    fread(data.array, 1, pkt->size, *file) != pkt->size) {
+		warn("Failed to read replay buffer cache file '%s'",
+		     segment->spill_path);
+		return false;
+	}
+
+	pkt->data = data.array;
+	return true;
+}
+
 static void *replay_buffer_mux_thread(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
+	DARRAY(struct mux_packet) packets;
+	DARRAY(uint8_t) buf;
+	struct replay_segment *file_segment = NULL;
+	FILE *file = NULL;
 	bool error = false;
 
+	da_init(packets);
+	da_init(buf);
+
+	reorder_packets(stream, &packets.da);
+
 	start_pipe(stream, stream->path.array);
 
 	if (!stream->pipe) {
@@ -831,18 +1419,47 @@ static void *replay_buffer_mux_thread(void *data)
 		goto error;
 	}
 
-	for (size_t i = 0; i < stream->mux_packets.num; i++) {
-		struct encoder_packet *pkt = &stream->mux_packets.array[i];
-		write_packet(stream, pkt);
-		obs_encoder_packet_release(pkt);
+	for (size_t i = 0; i < packets.num; i++) {
+		struct mux_packet *mux_pkt = &packets.array[i];
+		struct replay_segment *segment = mux_pkt->segment;
+		bool loaded = true;
+
+		/* the segment may have been written out since the packet info
+		 * was copied, so the data pointer is only valid under lock */
+		pthread_mutex_lock(&segment->mutex);
+
+		if (segment->spill_path)
+			loaded = load_spilled_packet(stream, mux_pkt, &file,
+						     &file_segment, &buf.da);
+		else
+			mux_pkt->packet.data =
+				segment->packets.array[mux_pkt->idx].data;
+
+		if (loaded)
+			write_packet(stream, &mux_pkt->packet);
+
+		pthread_mutex_unlock(&segment->mutex);
+
+		if (!loaded) {
+			error = true;
+			goto error;
+		}
 	}
 
 	info("Wrote replay buffer to '%s'", stream->path.array);
 
 error:
-	os_process_pipe_destroy(stream->pipe);
-	stream->pipe = NULL;
-	da_free(stream->mux_packets);
+	stop_pipe(stream);
+
+	if (file)
+		fclose(file);
+	da_free(buf);
+	da_free(packets);
+
+	for (size_t i = 0; i < stream->mux_segments.num; i++)
+		replay_segment_release(stream->mux_segments.array[i]);
+	da_free(stream->mux_segments);
+
 	os_atomic_set_bool(&stream->muxing, false);
 
 	if (!error) {
@@ -857,42 +1474,20 @@ error:
 
 static void replay_buffer_save(struct ffmpeg_muxer *stream)
 {
-	const size_t size = sizeof(struct encoder_packet);
-	size_t num_packets = stream->packets.size / size;
-
-	da_reserve(stream->mux_packets, num_packets);
+	size_t num = num_segments(stream);
 
 	/* ---------------------------- */
-	/* reorder packets */
-
-	bool found_video = false;
-	bool found_audio[MAX_AUDIO_MIXES] = {0};
-	int64_t video_offset = 0;
-	int64_t video_dts_offset = 0;
-	int64_t audio_offsets[MAX_AUDIO_MIXES] = {0};
-	int64_t audio_dts_offsets[MAX_AUDIO_MIXES] = {0};
+	/* snapshot segments */
 
-	for (size_t i = 0; i < num_packets; i++) {
-		struct encoder_packet *pkt;
-		pkt = circlebuf_data(&stream->packets, i * size);
+	da_reserve(stream->mux_segments, num);
 
-		if (pkt->type == OBS_ENCODER_VIDEO) {
-			if (!found_video) {
-				video_offset = pkt->dts_usec;
-				video_dts_offset = pkt->dts;
-				found_video = true;
-			}
-		} else {
-			if (!found_audio[pkt->track_idx]) {
-				found_audio[pkt->track_idx] = true;
-				audio_offsets[pkt->track_idx] = pkt->dts_usec;
-				audio_dts_offsets[pkt->track_idx] = pkt->dts;
-			}
-		}
+	for (size_t i = 0; i < num; i++) {
+		struct replay_segment *segment = get_segment(stream, i);
 
-		insert_packet(&stream->mux_packets.da, pkt, video_offset,
-			      audio_offsets, video_dts_offset,
-			      audio_dts_offsets);
+		if (!segment->sealed)
+			seal_segment(stream, segment);
+		replay_segment_addref(segment);
+		da_push_back(stream->mux_segments, &segment);
 	}
 
 	/* ---------------------------- */
@@ -967,15 +1562,7 @@ static void replay_buffer_data(void *data, struct encoder_packet *packet)
 
 	obs_encoder_packet_ref(&pkt, packet);
 	replay_buffer_purge(stream, &pkt);
-
-	if (!stream->packets.size)
-		stream->cur_time = pkt.dts_usec;
-	stream->cur_size += pkt.size;
-
-	circlebuf_push_back(&stream->packets, packet, sizeof(*packet));
-
-	if (packet->type == OBS_ENCODER_VIDEO && packet->keyframe)
-		stream->keyframes++;
+	replay_buffer_push(stream, &pkt);
 
 	if (stream->save_ts && packet->sys_dts_usec >= stream->save_ts) {
 		if (os_atomic_load_bool(&stream->muxing))
@@ -998,6 +1585,24 @@ static void replay_buffer_defaults(obs_data_t *s)
 	obs_data_set_default_string(s, "format", "%CCYY-%MM-%DD %hh-%mm-%ss");
 	obs_data_set_default_string(s, "extension", "mp4");
 	obs_data_set_default_bool(s, "allow_spaces", true);
+	obs_data_set_default_bool(s, "spill_to_disk", false);
+}
+
+static obs_properties_t *replay_buffer_properties(void *unused)
+{
+	UNUSED_PARAMETER(unused);
+
+	obs_properties_t *props = obs_properties_create();
+
+	obs_properties_add_int(props, "max_time_sec",
+			       obs_module_text("ReplayBuffer.MaxTime"), 5,
+			       21600, 1);
+	obs_properties_add_int(props, "max_size_mb",
+			       obs_module_text("ReplayBuffer.MaxSize"), 0,
+			       1024 * 1024, 1);
+	obs_properties_add_bool(props, "spill_to_disk",
+				obs_module_text("ReplayBuffer.SpillToDisk"));
+	return props;
 }
 
 struct obs_output_info replay_buffer = {
@@ -1012,4 +1617,5 @@ struct obs_output_info replay_buffer = {
 	.encoded_packet = replay_buffer_data,
 	.get_total_bytes = ffmpeg_mux_total_bytes,
 	.get_defaults = replay_buffer_defaults,
+	.get_properties = replay_buffer_properties,
 };
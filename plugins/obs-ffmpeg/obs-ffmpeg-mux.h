@@ -10,6 +10,10 @@
 #include <util/platform.h>
 #include <util/threading.h>
 
+#include "ffmpeg-mux/ffmpeg-mux.h"
+
+struct replay_segment;
+
 struct ffmpeg_muxer {
 	obs_output_t *output;
 	os_process_pipe_t *pipe;
@@ -33,7 +37,18 @@ struct ffmpeg_muxer {
 	int keyframes;
 	obs_hotkey_id hotkey;
 	volatile bool muxing;
-	DARRAY(struct encoder_packet) mux_packets;
+	struct circlebuf segments;
+	DARRAY(struct replay_segment *) mux_segments;
+	bool spill;
+	struct dstr spill_dir;
+	uint64_t spill_id;
+	uint64_t spill_idx;
+	pthread_t spill_thread;
+	bool spill_thread_active;
+	pthread_mutex_t spill_mutex;
+	os_sem_t *spill_sem;
+	struct circlebuf spill_queue;
+	volatile bool spill_exit;
 
 	/* these are accessed both by replay buffer and by HLS */
 	pthread_t mux_thread;
@@ -51,11 +66,18 @@ struct ffmpeg_muxer {
 	int64_t last_dts_usec;
 
 	bool is_network;
+
+	/* packet data goes through shared memory instead of the pipe */
+	bool use_shm;
+#ifdef FFM_SHM_SUPPORTED
+	struct ffm_shm shm;
+#endif
 };
 
 bool stopping(struct ffmpeg_muxer *stream);
 bool active(struct ffmpeg_muxer *stream);
 void start_pipe(struct ffmpeg_muxer *stream, const char *path);
+int stop_pipe(struct ffmpeg_muxer *stream);
 bool write_packet(struct ffmpeg_muxer *stream, struct encoder_packet *packet);
 bool send_headers(struct ffmpeg_muxer *stream);
 int deactivate(struct ffmpeg_muxer *stream, int code);
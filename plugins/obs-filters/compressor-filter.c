@@ -5,9 +5,11 @@
 #include <obs-module.h>
 #include <media-io/audio-math.h>
 #include <util/platform.h>
-#include <util/circlebuf.h>
+#include <util/spsc-ring.h>
 #include <util/threading.h>
 
+#include "dynamics.h"
+
 /* -------------------------------------------------------- */
 
 #define do_log(level, format, ...)                \
@@ -52,6 +54,7 @@
 #define MAX_RLS_MS                      1000
 #define MAX_ATK_MS                      500
 #define DEFAULT_AUDIO_BUF_MS            10
+#define SIDECHAIN_BUF_MS                500
 
 #define MS_IN_S                         1000
 #define MS_IN_S_F                       ((float)MS_IN_S)
@@ -81,10 +84,10 @@ struct compressor_data {
 	obs_weak_source_t *weak_sidechain;
 	char *sidechain_name;
 
-	pthread_mutex_t sidechain_mutex;
-	struct circlebuf sidechain_data[MAX_AUDIO_CHANNELS];
+	/* written by the sidechain source's audio, read by the filter */
+	struct spsc_ring sidechain_data[MAX_AUDIO_CHANNELS];
 	float *sidechain_buf[MAX_AUDIO_CHANNELS];
-	size_t max_sidechain_frames;
+	volatile long max_sidechain_frames;
 };
 
 /* -------------------------------------------------------- */
@@ -96,27 +99,49 @@ static inline obs_source_t *get_sidechain(struct compressor_data *cd)
 	return NULL;
 }
 
+static inline size_t update_max_sidechain_frames(struct compressor_data *cd,
+						 size_t frames)
+{
+	long max_frames = os_atomic_load_long(&cd->max_sidechain_frames);
+
+	while (max_frames < (long)frames) {
+		if (os_atomic_compare_exchange_long(&cd->max_sidechain_frames,
+						    &max_frames, (long)frames))
+			return frames;
+	}
+
+	return (size_t)max_frames;
+}
+
 static inline void get_sidechain_data(struct compressor_data *cd,
 				      const uint32_t num_samples)
 {
 	size_t data_size = cd->envelope_buf_len * sizeof(float);
+	size_t expected_size;
+	size_t size;
+
 	if (!data_size)
 		return;
 
-	pthread_mutex_lock(&cd->sidechain_mutex);
-	if (cd->max_sidechain_frames < num_samples)
-		cd->max_sidechain_frames = num_samples;
+	expected_size = update_max_sidechain_frames(cd, num_samples) *
+			sizeof(float);
 
-	if (cd->sidechain_data[0].size < data_size) {
-		pthread_mutex_unlock(&cd->sidechain_mutex);
+	/* channels are written in order, so once the last channel has the
+	 * data, every other channel has it as well */
+	size = spsc_ring_size(&cd->sidechain_data[cd->num_channels - 1]);
+	if (size < data_size)
 		goto clear;
+
+	/* don't let the sidechain fall too far behind */
+	if (size > expected_size * 2 && size - expected_size >= data_size) {
+		for (size_t i = 0; i < cd->num_channels; i++)
+			spsc_ring_read(&cd->sidechain_data[i], NULL,
+				       expected_size);
 	}
 
 	for (size_t i = 0; i < cd->num_channels; i++)
-		circlebuf_pop_front(&cd->sidechain_data[i],
-				    cd->sidechain_buf[i], data_size);
-
-	pthread_mutex_unlock(&cd->sidechain_mutex);
+		spsc_ring_read(&cd->sidechain_data[i], cd->sidechain_buf[i],
+			       data_size);
 	return;
 
 clear:
@@ -149,42 +174,27 @@ static void sidechain_capture(void *param, obs_source_t *source,
 			      const struct audio_data *audio_data, bool muted)
 {
 	struct compressor_data *cd = param;
+	size_t size = audio_data->frames * sizeof(float);
 
 	UNUSED_PARAMETER(source);
 
-	pthread_mutex_lock(&cd->sidechain_mutex);
-
-	if (cd->max_sidechain_frames < audio_data->frames)
-		cd->max_sidechain_frames = audio_data->frames;
-
-	size_t expected_size = cd->max_sidechain_frames * sizeof(float);
-
-	if (!expected_size)
-		goto unlock;
+	if (!update_max_sidechain_frames(cd, audio_data->frames))
+		return;
 
-	if (cd->sidechain_data[0].size > expected_size * 2) {
-		for (size_t i = 0; i < cd->num_channels; i++) {
-			circlebuf_pop_front(&cd->sidechain_data[i], NULL,
-					    expected_size);
-		}
+	/* the filter discards anything it falls behind on, so the ring only
+	 * fills up if the filter isn't processing audio at all */
+	for (size_t i = 0; i < cd->num_channels; i++) {
+		if (spsc_ring_space(&cd->sidechain_data[i]) < size)
+			return;
 	}
 
-	if (muted) {
-		for (size_t i = 0; i < cd->num_channels; i++) {
-			circlebuf_push_back_zero(&cd->sidechain_data[i],
-						 audio_data->frames *
-							 sizeof(float));
-		}
-	} else {
-		for (size_t i = 0; i < cd->num_channels; i++) {
-			circlebuf_push_back(&cd->sidechain_data[i],
-					    audio_data->data[i],
-					    audio_data->frames * sizeof(float));
-		}
+	for (size_t i = 0; i < cd->num_channels; i++) {
+		if (muted)
+			spsc_ring_write_zero(&cd->sidechain_data[i], size);
+		else
+			spsc_ring_write(&cd->sidechain_data[i],
+					audio_data->data[i], size);
 	}
-
-unlock:
-	pthread_mutex_unlock(&cd->sidechain_mutex);
 }
 
 static void compressor_update(void *data, obs_data_t *s)
@@ -264,21 +274,23 @@ static void compressor_update(void *data, obs_data_t *s)
 static void *compressor_create(obs_data_t *settings, obs_source_t *filter)
 {
 	struct compressor_data *cd = bzalloc(sizeof(struct compressor_data));
-	cd->context = filter;
+	const uint32_t sample_rate =
+		audio_output_get_sample_rate(obs_get_audio());
+	const size_t num_channels = audio_output_get_channels(obs_get_audio());
+	const size_t sidechain_size =
+		sample_rate * SIDECHAIN_BUF_MS / MS_IN_S * sizeof(float);
 
-	if (pthread_mutex_init(&cd->sidechain_mutex, NULL) != 0) {
-		blog(LOG_ERROR, "Failed to create mutex");
-		bfree(cd);
-		return NULL;
-	}
+	cd->context = filter;
 
 	if (pthread_mutex_init(&cd->sidechain_update_mutex, NULL) != 0) {
-		pthread_mutex_destroy(&cd->sidechain_mutex);
 		blog(LOG_ERROR, "Failed to create mutex");
 		bfree(cd);
 		return NULL;
 	}
 
+	for (size_t i = 0; i < num_channels; i++)
+		spsc_ring_init(&cd->sidechain_data[i], sidechain_size);
+
 	compressor_update(cd, settings);
 	return cd;
 }
@@ -299,10 +311,9 @@ static void compressor_destroy(void *data)
 	}
 
 	for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++) {
-		circlebuf_free(&cd->sidechain_data[i]);
+		spsc_ring_free(&cd->sidechain_data[i]);
 		bfree(cd->sidechain_buf[i]);
 	}
-	pthread_mutex_destroy(&cd->sidechain_mutex);
 	pthread_mutex_destroy(&cd->sidechain_update_mutex);
 
 	bfree(cd->sidechain_name);
@@ -317,27 +328,9 @@ static void analyze_envelope(struct compressor_data *cd, float **samples,
 		resize_env_buffer(cd, num_samples);
 	}
 
-	const float attack_gain = cd->attack_gain;
-	const float release_gain = cd->release_gain;
-
-	memset(cd->envelope_buf, 0, num_samples * sizeof(cd->envelope_buf[0]));
-	for (size_t chan = 0; chan < cd->num_channels; ++chan) {
-		if (!samples[chan])
-			continue;
-
-		float *envelope_buf = cd->envelope_buf;
-		float env = cd->envelope;
-		for (uint32_t i = 0; i < num_samples; ++i) {
-			const float env_in = fabsf(samples[chan][i]);
-			if (env < env_in) {
-				env = env_in + attack_gain * (env - env_in);
-			} else {
-				env = env_in + release_gain * (env - env_in);
-			}
-			envelope_buf[i] = fmaxf(envelope_buf[i], env);
-		}
-	}
-	cd->envelope = cd->envelope_buf[num_samples - 1];
+	dynamics_peak_envelope(cd->envelope_buf, samples, cd->num_channels,
+			       num_samples, &cd->envelope, cd->attack_gain,
+			       cd->release_gain);
 }
 
 static void analyze_sidechain(struct compressor_data *cd,
@@ -349,45 +342,21 @@ static void analyze_sidechain(struct compressor_data *cd,
 
 	get_sidechain_data(cd, num_samples);
 
-	const float attack_gain = cd->attack_gain;
-	const float release_gain = cd->release_gain;
-	float **sidechain_buf = cd->sidechain_buf;
-
-	memset(cd->envelope_buf, 0, num_samples * sizeof(cd->envelope_buf[0]));
-	for (size_t chan = 0; chan < cd->num_channels; ++chan) {
-		if (!sidechain_buf[chan])
-			continue;
-
-		float *envelope_buf = cd->envelope_buf;
-		float env = cd->envelope;
-		for (uint32_t i = 0; i < num_samples; ++i) {
-			const float env_in = fabsf(sidechain_buf[chan][i]);
-
-			if (env < env_in) {
-				env = env_in + attack_gain * (env - env_in);
-			} else {
-				env = env_in + release_gain * (env - env_in);
-			}
-			envelope_buf[i] = fmaxf(envelope_buf[i], env);
-		}
-	}
-	cd->envelope = cd->envelope_buf[num_samples - 1];
+	dynamics_peak_envelope(cd->envelope_buf, cd->sidechain_buf,
+			       cd->num_channels, num_samples, &cd->envelope,
+			       cd->attack_gain, cd->release_gain);
 }
 
 static inline void process_compression(const struct compressor_data *cd,
 				       float **samples, uint32_t num_samples)
 {
-	for (size_t i = 0; i < num_samples; ++i) {
-		const float env_db = mul_to_db(cd->envelope_buf[i]);
-		float gain = cd->slope * (cd->threshold - env_db);
-		gain = db_to_mul(fminf(0, gain));
-
-		for (size_t c = 0; c < cd->num_channels; ++c) {
-			if (samples[c]) {
-				samples[c][i] *= gain * cd->output_gain;
-			}
-		}
-	}
+	/* the envelope isn't needed past this point, so the gain curve
+	 * simply replaces it */
+	dynamics_compressor_gain(cd->envelope_buf, cd->envelope_buf,
+				 num_samples, cd->threshold, cd->slope,
+				 cd->output_gain);
+	dynamics_apply_gain(samples, cd->num_channels, cd->envelope_buf,
+			    num_samples);
 }
 
 static void compressor_tick(void *data, float seconds)
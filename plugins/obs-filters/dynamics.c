@@ -0,0 +1,501 @@
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include <util/sse-intrin.h>
+
+#include "dynamics.h"
+
+/* -------------------------------------------------------- */
+
+/* clang-format off */
+
+#define LANES                   4
+
+#define DB_PER_LOG2             6.0205999132796239f  /* 20 * log10(2) */
+#define LOG2_PER_DB             0.1660964047443681f  /* log2(10) / 20 */
+
+#define MIN_EXPANSION_DB        -60.0f
+
+/* clang-format on */
+
+/* -------------------------------------------------------- */
+/* channel lanes                                            */
+
+/* loads four samples of four channels, transposed so that each vector holds
+ * one sample of every channel.  missing channels read as silence */
+static inline void load_block(__m128 v[LANES], float *const in[LANES],
+			      size_t i)
+{
+	for (size_t c = 0; c < LANES; c++)
+		v[c] = in[c] ? _mm_loadu_ps(in[c] + i) : _mm_setzero_ps();
+
+	_MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+}
+
+static inline void store_block(float *const out[LANES], __m128 v[LANES],
+			       size_t i)
+{
+	_MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+
+	for (size_t c = 0; c < LANES; c++) {
+		if (out[c])
+			_mm_storeu_ps(out[c] + i, v[c]);
+	}
+}
+
+static inline __m128 load_lanes(float *const in[LANES], size_t i)
+{
+	float v[LANES];
+
+	for (size_t c = 0; c < LANES; c++)
+		v[c] = in[c] ? in[c][i] : 0.0f;
+
+	return _mm_loadu_ps(v);
+}
+
+static inline void store_lanes(float *const out[LANES], __m128 val, size_t i)
+{
+	float v[LANES];
+
+	_mm_storeu_ps(v, val);
+
+	for (size_t c = 0; c < LANES; c++) {
+		if (out[c])
+			out[c][i] = v[c];
+	}
+}
+
+static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 abs_ps(__m128 v)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+/* -------------------------------------------------------- */
+/* dB conversions                                           */
+
+/* log2 for positive values.  denormals are scaled up by 2^23 first so that
+ * they get their real exponent, like log10f.  the mantissa is moved into
+ * [sqrt(0.5), sqrt(2)) and log2 of it comes from the atanh series, which is
+ * accurate to about 1e-7 over that range */
+static inline __m128 log2_ps(__m128 x)
+{
+	const __m128i mant_mask = _mm_set1_epi32(0x007fffff);
+	const __m128i one_bits = _mm_set1_epi32(0x3f800000);
+	__m128i bits;
+	__m128i e;
+	__m128 m;
+	__m128 denormal;
+	__m128 big;
+	__m128 t;
+	__m128 t2;
+	__m128 p;
+
+	denormal = _mm_cmplt_ps(x, _mm_set1_ps(FLT_MIN));
+	x = select_ps(denormal, _mm_mul_ps(x, _mm_set1_ps(8388608.0f)), x);
+	bits = _mm_castps_si128(x);
+
+	e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+	e = _mm_sub_epi32(e, _mm_and_si128(_mm_castps_si128(denormal),
+					   _mm_set1_epi32(23)));
+	m = _mm_castsi128_ps(
+		_mm_or_si128(_mm_and_si128(bits, mant_mask), one_bits));
+
+	big = _mm_cmpge_ps(m, _mm_set1_ps(1.41421356f));
+	m = select_ps(big, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+	e = _mm_sub_epi32(e, _mm_castps_si128(big));
+
+	t = _mm_div_ps(_mm_sub_ps(m, _mm_set1_ps(1.0f)),
+		       _mm_add_ps(m, _mm_set1_ps(1.0f)));
+	t2 = _mm_mul_ps(t, t);
+
+	/* 2/ln(2) * (t + t^3/3 + t^5/5 + t^7/7) */
+	p = _mm_set1_ps(0.41219858f);
+	p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.57707801f));
+	p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.96179669f));
+	p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(2.88539008f));
+	p = _mm_mul_ps(p, t);
+
+	return _mm_add_ps(_mm_cvtepi32_ps(e), p);
+}
+
+/* 2^x, with x clamped to the range of normal floats.  the fraction is kept
+ * within [-0.5, 0.5] so that a sixth order Taylor series is accurate to
+ * about 1e-7 */
+static inline __m128 exp2_ps(__m128 x)
+{
+	__m128i n;
+	__m128 nf;
+	__m128 f;
+	__m128 p;
+
+	x = _mm_min_ps(x, _mm_set1_ps(126.0f));
+	x = _mm_max_ps(x, _mm_set1_ps(-126.0f));
+
+	/* round to nearest without depending on the rounding mode */
+	nf = _mm_add_ps(x, _mm_set1_ps(0.5f));
+	n = _mm_cvttps_epi32(nf);
+	n = _mm_add_epi32(n, _mm_castps_si128(_mm_cmplt_ps(
+				     nf, _mm_cvtepi32_ps(n))));
+	f = _mm_sub_ps(x, _mm_cvtepi32_ps(n));
+
+	/* e^(f * ln(2)) */
+	p = _mm_set1_ps(1.5403530e-4f);
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.3333558e-3f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.6181291e-3f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.5504109e-2f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.4022651e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.9314718e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+
+	n = _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+	return _mm_mul_ps(p, _mm_castsi128_ps(n));
+}
+
+/* same as mul_to_db, including -inf for silence and the real level of
+ * denormals */
+static inline __m128 mul_to_db_ps(__m128 mul)
+{
+	__m128 silent = _mm_cmpeq_ps(mul, _mm_setzero_ps());
+	__m128 db = _mm_mul_ps(log2_ps(mul), _mm_set1_ps(DB_PER_LOG2));
+
+	return select_ps(silent, _mm_set1_ps(-INFINITY), db);
+}
+
+static inline __m128 db_to_mul_ps(__m128 db)
+{
+	return exp2_ps(_mm_mul_ps(db, _mm_set1_ps(LOG2_PER_DB)));
+}
+
+/* -------------------------------------------------------- */
+/* envelope followers                                       */
+
+static inline __m128 peak_step(__m128 env, __m128 x, __m128 attack,
+			       __m128 release)
+{
+	__m128 env_in = abs_ps(x);
+	__m128 gain = select_ps(_mm_cmplt_ps(env, env_in), attack, release);
+
+	return _mm_add_ps(env_in, _mm_mul_ps(gain, _mm_sub_ps(env, env_in)));
+}
+
+static inline float max_lanes(__m128 v)
+{
+	v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(v);
+}
+
+void dynamics_peak_envelope(float *env, float **samples, size_t channels,
+			    size_t frames, float *env_state, float attack_gain,
+			    float release_gain)
+{
+	const __m128 attack = _mm_set1_ps(attack_gain);
+	const __m128 release = _mm_set1_ps(release_gain);
+
+	memset(env, 0, frames * sizeof(float));
+
+	for (size_t chan = 0; chan < channels; chan += LANES) {
+		float *in[LANES] = {NULL};
+		float active[LANES] = {0};
+		__m128 mask;
+		__m128 e = _mm_set1_ps(*env_state);
+		size_t i = 0;
+
+		for (size_t c = 0; c < LANES && chan + c < channels; c++) {
+			in[c] = samples[chan + c];
+			active[c] = in[c] ? 1.0f : 0.0f;
+		}
+
+		/* envelopes are never negative, so channels that aren't
+		 * there are simply zeroed before taking the maximum */
+		mask = _mm_cmpneq_ps(_mm_loadu_ps(active), _mm_setzero_ps());
+		if (!_mm_movemask_ps(mask))
+			continue;
+
+		for (; i + LANES <= frames; i += LANES) {
+			__m128 v[LANES];
+			__m128 max;
+
+			load_block(v, in, i);
+
+			for (size_t j = 0; j < LANES; j++) {
+				e = peak_step(e, v[j], attack, release);
+				v[j] = _mm_and_ps(e, mask);
+			}
+
+			_MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+			max = _mm_max_ps(_mm_max_ps(v[0], v[1]),
+					 _mm_max_ps(v[2], v[3]));
+			max = _mm_max_ps(_mm_loadu_ps(env + i), max);
+			_mm_storeu_ps(env + i, max);
+		}
+
+		for (; i < frames; i++) {
+			e = peak_step(e, load_lanes(in, i), attack, release);
+			env[i] = fmaxf(env[i], max_lanes(_mm_and_ps(e, mask)));
+		}
+	}
+
+	if (frames)
+		*env_state = env[frames - 1];
+}
+
+static inline __m128 rms_step(__m128 *mean_square, __m128 x, __m128 coef,
+			      __m128 inv_coef)
+{
+	*mean_square = _mm_add_ps(_mm_mul_ps(coef, *mean_square),
+				  _mm_mul_ps(inv_coef, _mm_mul_ps(x, x)));
+	return _mm_sqrt_ps(*mean_square);
+}
+
+void dynamics_rms_envelope(float **env, float **samples, size_t channels,
+			   size_t frames, float *mean_square, float coef)
+{
+	const __m128 c = _mm_set1_ps(coef);
+	const __m128 inv_c = _mm_set1_ps(1.0f - coef);
+
+	if (!frames)
+		return;
+
+	for (size_t chan = 0; chan < channels; chan += LANES) {
+		float *in[LANES] = {NULL};
+		float *out[LANES] = {NULL};
+		float ms[LANES] = {0};
+		__m128 ms_v;
+		size_t i = 0;
+
+		for (size_t j = 0; j < LANES && chan + j < channels; j++) {
+			in[j] = samples[chan + j];
+			if (in[j]) {
+				out[j] = env[chan + j];
+				ms[j] = mean_square[chan + j];
+			} else {
+				memset(env[chan + j], 0, frames * sizeof(float));
+			}
+		}
+
+		ms_v = _mm_loadu_ps(ms);
+
+		for (; i + LANES <= frames; i += LANES) {
+			__m128 v[LANES];
+
+			load_block(v, in, i);
+			for (size_t j = 0; j < LANES; j++)
+				v[j] = rms_step(&ms_v, v[j], c, inv_c);
+			store_block(out, v, i);
+		}
+
+		for (; i < frames; i++)
+			store_lanes(out, rms_step(&ms_v, load_lanes(in, i), c,
+						  inv_c),
+				    i);
+
+		_mm_storeu_ps(ms, ms_v);
+		for (size_t j = 0; j < LANES && chan + j < channels; j++) {
+			if (in[j])
+				mean_square[chan + j] = ms[j];
+		}
+	}
+}
+
+/* -------------------------------------------------------- */
+/* gain computers                                           */
+
+static inline __m128 compressor_gain(__m128 env, __m128 threshold,
+				     __m128 slope, __m128 output_gain)
+{
+	__m128 gain = _mm_mul_ps(slope, _mm_sub_ps(threshold,
+						   mul_to_db_ps(env)));
+
+	/* min returns the second operand for NaN, like fminf */
+	gain = db_to_mul_ps(_mm_min_ps(gain, _mm_setzero_ps()));
+	return _mm_mul_ps(gain, output_gain);
+}
+
+void dynamics_compressor_gain(float *gain, const float *env, size_t frames,
+			      float threshold_db, float slope,
+			      float output_gain)
+{
+	const __m128 thresh = _mm_set1_ps(threshold_db);
+	const __m128 s = _mm_set1_ps(slope);
+	const __m128 out = _mm_set1_ps(output_gain);
+	size_t i = 0;
+
+	for (; i + LANES <= frames; i += LANES) {
+		__m128 v = _mm_loadu_ps(env + i);
+		_mm_storeu_ps(gain + i, compressor_gain(v, thresh, s, out));
+	}
+
+	if (i < frames) {
+		float tmp[LANES] = {0};
+		size_t left = frames - i;
+
+		memcpy(tmp, env + i, left * sizeof(float));
+		_mm_storeu_ps(tmp, compressor_gain(_mm_loadu_ps(tmp), thresh,
+						   s, out));
+		memcpy(gain + i, tmp, left * sizeof(float));
+	}
+}
+
+static inline __m128 expansion_gain(__m128 env, __m128 threshold, __m128 slope)
+{
+	__m128 below = _mm_sub_ps(threshold, mul_to_db_ps(env));
+	__m128 gain = _mm_mul_ps(slope, below);
+
+	/* max also returns the second operand for NaN, like fmaxf */
+	gain = _mm_max_ps(gain, _mm_set1_ps(MIN_EXPANSION_DB));
+	return _mm_and_ps(_mm_cmpgt_ps(below, _mm_setzero_ps()), gain);
+}
+
+static inline __m128 ballistics_step(__m128 prev, __m128 gain, __m128 attack,
+				     __m128 release, __m128 inv_attack,
+				     __m128 inv_release)
+{
+	__m128 rising = _mm_cmpgt_ps(gain, prev);
+	__m128 coef = select_ps(rising, attack, release);
+	__m128 inv_coef = select_ps(rising, inv_attack, inv_release);
+	__m128 next;
+
+	next = _mm_add_ps(_mm_mul_ps(coef, prev), _mm_mul_ps(inv_coef, gain));
+
+	/* releasing towards 0 dB decays into denormals, which are very slow
+	 * to compute with for as long as the signal stays above threshold */
+	return _mm_and_ps(next,
+			  _mm_cmpge_ps(abs_ps(next), _mm_set1_ps(FLT_MIN)));
+}
+
+void dynamics_expander_gain(float **gain_db, float **env, size_t channels,
+			    size_t frames, float *gain_state,
+			    float threshold_db, float slope, float attack_gain,
+			    float release_gain)
+{
+	const __m128 thresh = _mm_set1_ps(threshold_db);
+	const __m128 s = _mm_set1_ps(slope);
+	const __m128 attack = _mm_set1_ps(attack_gain);
+	const __m128 release = _mm_set1_ps(release_gain);
+	const __m128 inv_attack = _mm_set1_ps(1.0f - attack_gain);
+	const __m128 inv_release = _mm_set1_ps(1.0f - release_gain);
+
+	if (!frames)
+		return;
+
+	/* static gain of every sample, which doesn't depend on the previous
+	 * one and can be computed across samples */
+	for (size_t chan = 0; chan < channels; chan++) {
+		float *out = gain_db[chan];
+		const float *in = env[chan];
+		size_t i = 0;
+
+		for (; i + LANES <= frames; i += LANES) {
+			__m128 v = _mm_loadu_ps(in + i);
+			_mm_storeu_ps(out + i, expansion_gain(v, thresh, s));
+		}
+
+		if (i < frames) {
+			float tmp[LANES] = {0};
+			size_t left = frames - i;
+
+			memcpy(tmp, in + i, left * sizeof(float));
+			_mm_storeu_ps(tmp, expansion_gain(_mm_loadu_ps(tmp),
+							  thresh, s));
+			memcpy(out + i, tmp, left * sizeof(float));
+		}
+	}
+
+	/* attack/release, in place, across channels */
+	for (size_t chan = 0; chan < channels; chan += LANES) {
+		float *lanes[LANES] = {NULL};
+		float prev[LANES] = {0};
+		__m128 p;
+		size_t i = 0;
+
+		for (size_t j = 0; j < LANES && chan + j < channels; j++) {
+			lanes[j] = gain_db[chan + j];
+			prev[j] = gain_state[chan + j];
+		}
+
+		p = _mm_loadu_ps(prev);
+
+		for (; i + LANES <= frames; i += LANES) {
+			__m128 v[LANES];
+
+			load_block(v, lanes, i);
+			for (size_t j = 0; j < LANES; j++) {
+				p = ballistics_step(p, v[j], attack, release,
+						    inv_attack, inv_release);
+				v[j] = p;
+			}
+			store_block(lanes, v, i);
+		}
+
+		for (; i < frames; i++) {
+			p = ballistics_step(p, load_lanes(lanes, i), attack,
+					    release, inv_attack, inv_release);
+			store_lanes(lanes, p, i);
+		}
+
+		_mm_storeu_ps(prev, p);
+		for (size_t j = 0; j < LANES && chan + j < channels; j++)
+			gain_state[chan + j] = prev[j];
+	}
+}
+
+/* -------------------------------------------------------- */
+/* gain application                                         */
+
+void dynamics_apply_gain(float **samples, size_t channels, const float *gain,
+			 size_t frames)
+{
+	for (size_t chan = 0; chan < channels; chan++) {
+		float *out = samples[chan];
+		size_t i = 0;
+
+		if (!out)
+			continue;
+
+		for (; i + LANES <= frames; i += LANES) {
+			__m128 v = _mm_mul_ps(_mm_loadu_ps(out + i),
+					      _mm_loadu_ps(gain + i));
+			_mm_storeu_ps(out + i, v);
+		}
+
+		for (; i < frames; i++)
+			out[i] *= gain[i];
+	}
+}
+
+static inline __m128 gain_db_to_mul(__m128 gain_db, __m128 output_gain)
+{
+	__m128 gain = db_to_mul_ps(_mm_min_ps(gain_db, _mm_setzero_ps()));
+	return _mm_mul_ps(gain, output_gain);
+}
+
+void dynamics_apply_gain_db(float *samples, const float *gain_db,
+			    size_t frames, float output_gain)
+{
+	const __m128 out = _mm_set1_ps(output_gain);
+	size_t i = 0;
+
+	for (; i + LANES <= frames; i += LANES) {
+		__m128 gain = gain_db_to_mul(_mm_loadu_ps(gain_db + i), out);
+		__m128 v = _mm_mul_ps(_mm_loadu_ps(samples + i), gain);
+		_mm_storeu_ps(samples + i, v);
+	}
+
+	if (i < frames) {
+		float tmp[LANES] = {0};
+		size_t left = frames - i;
+
+		memcpy(tmp, gain_db + i, left * sizeof(float));
+		_mm_storeu_ps(tmp, gain_db_to_mul(_mm_loadu_ps(tmp), out));
+
+		for (size_t j = 0; j < left; j++)
+			samples[i + j] *= tmp[j];
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Shared processing for the compressor, limiter and expander filters.
+ *
+ * The envelope followers and gain ballistics are recursive in time, so they
+ * are vectorized across channels instead, four at a time, and produce the
+ * same results as the equivalent scalar loops, except that the expander's
+ * gain is flushed to zero rather than decaying through denormals.  The dB
+ * conversions are vectorized across samples and use polynomial
+ * approximations of log2/exp2 rather than log10f/powf, which are accurate to
+ * well under 0.001 dB.
+ */
+
+/*
+ * Peak envelope follower.  Every channel starts from *env_state, and env
+ * receives the loudest channel's envelope for each sample.  NULL channels
+ * are skipped.  The last value of env becomes the new state.
+ */
+extern void dynamics_peak_envelope(float *env, float **samples,
+				   size_t channels, size_t frames,
+				   float *env_state, float attack_gain,
+				   float release_gain);
+
+/*
+ * RMS envelope of each channel using a running mean square with the given
+ * coefficient.  mean_square holds the running value of each channel between
+ * calls.  The envelope of a NULL channel is set to zero.
+ */
+extern void dynamics_rms_envelope(float **env, float **samples,
+				  size_t channels, size_t frames,
+				  float *mean_square, float coef);
+
+/*
+ * Compressor/limiter gain computer: turns an envelope into the linear gain
+ * to apply, including output_gain.  env and gain may be the same buffer.
+ */
+extern void dynamics_compressor_gain(float *gain, const float *env,
+				     size_t frames, float threshold_db,
+				     float slope, float output_gain);
+
+/*
+ * Expander gain computer with attack/release ballistics applied in the dB
+ * domain.  gain_state holds the last gain of each channel between calls.
+ * The resulting gains are in dB, see dynamics_apply_gain_db.
+ */
+extern void dynamics_expander_gain(float **gain_db, float **env,
+				   size_t channels, size_t frames,
+				   float *gain_state, float threshold_db,
+				   float slope, float attack_gain,
+				   float release_gain);
+
+/* multiplies every non-NULL channel by the same linear gain curve */
+extern void dynamics_apply_gain(float **samples, size_t channels,
+				const float *gain, size_t frames);
+
+/* multiplies samples by the gain in dB, clamped to 0 dB, and output_gain */
+extern void dynamics_apply_gain_db(float *samples, const float *gain_db,
+				   size_t frames, float output_gain);
+
+#ifdef __cplusplus
+}
+#endif
@@ -658,11 +658,21 @@ static inline void process_rnnoise(struct noise_suppress_data *ng)
 	}
 
 	/* Execute */
+#ifdef RNNOISE_BATCH_ENABLED
+	/* the bundled copy can run the network for all channels at once.
+	 * batching stops at the instance: filters run in
+	 * obs_source_output_audio on each source's own capture thread, so
+	 * separate instances are never processed on the same thread */
+	rnnoise_process_frames(ng->rnn_states, ng->rnn_segment_buffers,
+			       (const float **)ng->rnn_segment_buffers, NULL,
+			       (int)ng->channels);
+#else
 	for (size_t i = 0; i < ng->channels; i++) {
 		rnnoise_process_frame(ng->rnn_states[i],
 				      ng->rnn_segment_buffers[i],
 				      ng->rnn_segment_buffers[i]);
 	}
+#endif
 
 	/* Revert signal level adjustment, resample back if necessary */
 	if (ng->rnn_resampler) {
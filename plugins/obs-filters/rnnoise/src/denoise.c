@@ -453,44 +453,102 @@ void pitch_filter(kiss_fft_cpx *X, const kiss_fft_cpx *P, const float *Ex, const
   }
 }
 
-float rnnoise_process_frame(DenoiseState *st, float *out, const float *in) {
+static int frame_features(DenoiseState *st, kiss_fft_cpx *X, kiss_fft_cpx *P, float *Ex,
+                          float *Ep, float *Exp, float *features, const float *in) {
+  float x[FRAME_SIZE];
+  static const float a_hp[2] = {-1.99599f, 0.99600f};
+  static const float b_hp[2] = {-2, 1};
+  biquad(x, st->mem_hp_x, in, b_hp, a_hp, FRAME_SIZE);
+  return compute_frame_features(st, X, P, Ex, Ep, Exp, features, x);
+}
+
+static void apply_gains(DenoiseState *st, kiss_fft_cpx *X, const kiss_fft_cpx *P,
+                        const float *Ex, const float *Ep, const float *Exp, float *g) {
   int i;
+  float gf[FREQ_SIZE]={1};
+  pitch_filter(X, P, Ex, Ep, Exp, g);
+  for (i=0;i<NB_BANDS;i++) {
+    float alpha = .6f;
+    g[i] = MAX16(g[i], alpha*st->lastg[i]);
+    st->lastg[i] = g[i];
+  }
+  interp_band_gain(gf, g);
+#if 1
+  for (i=0;i<FREQ_SIZE;i++) {
+    X[i].r *= gf[i];
+    X[i].i *= gf[i];
+  }
+#endif
+}
+
+float rnnoise_process_frame(DenoiseState *st, float *out, const float *in) {
   kiss_fft_cpx X[FREQ_SIZE];
   kiss_fft_cpx P[WINDOW_SIZE];
-  float x[FRAME_SIZE];
   float Ex[NB_BANDS], Ep[NB_BANDS];
   float Exp[NB_BANDS];
   float features[NB_FEATURES];
   float g[NB_BANDS];
-  float gf[FREQ_SIZE]={1};
   float vad_prob = 0;
   int silence;
-  static const float a_hp[2] = {-1.99599f, 0.99600f};
-  static const float b_hp[2] = {-2, 1};
-  biquad(x, st->mem_hp_x, in, b_hp, a_hp, FRAME_SIZE);
-  silence = compute_frame_features(st, X, P, Ex, Ep, Exp, features, x);
+  silence = frame_features(st, X, P, Ex, Ep, Exp, features, in);
 
   if (!silence) {
     compute_rnn(&st->rnn, g, &vad_prob, features);
-    pitch_filter(X, P, Ex, Ep, Exp, g);
-    for (i=0;i<NB_BANDS;i++) {
-      float alpha = .6f;
-      g[i] = MAX16(g[i], alpha*st->lastg[i]);
-      st->lastg[i] = g[i];
-    }
-    interp_band_gain(gf, g);
-#if 1
-    for (i=0;i<FREQ_SIZE;i++) {
-      X[i].r *= gf[i];
-      X[i].i *= gf[i];
-    }
-#endif
+    apply_gains(st, X, P, Ex, Ep, Exp, g);
   }
 
   frame_synthesis(st, out, X);
   return vad_prob;
 }
 
+struct frame_batch {
+  kiss_fft_cpx X[FREQ_SIZE];
+  kiss_fft_cpx P[WINDOW_SIZE];
+  float Ex[NB_BANDS], Ep[NB_BANDS];
+  float Exp[NB_BANDS];
+  float features[NB_FEATURES];
+  float g[NB_BANDS];
+  float vad_prob;
+};
+
+/* Same as calling rnnoise_process_frame() on each state in turn, except that
+   the network is evaluated for all non-silent frames of a batch together. */
+void rnnoise_process_frames(DenoiseState **st, float **out, const float **in, float *vad_prob,
+                            int count) {
+  struct frame_batch frames[RNN_MAX_BATCH];
+  RNNState *rnn[RNN_MAX_BATCH];
+  float *g[RNN_MAX_BATCH];
+  float *vad[RNN_MAX_BATCH];
+  const float *features[RNN_MAX_BATCH];
+  int active[RNN_MAX_BATCH];
+  int i, n, batch;
+  for (batch=0;batch<count;batch+=RNN_MAX_BATCH) {
+    int size = IMIN(count - batch, RNN_MAX_BATCH);
+    n = 0;
+    for (i=0;i<size;i++) {
+      DenoiseState *s = st[batch+i];
+      struct frame_batch *f = &frames[i];
+      f->vad_prob = 0;
+      if (!frame_features(s, f->X, f->P, f->Ex, f->Ep, f->Exp, f->features, in[batch+i])) {
+        rnn[n] = &s->rnn;
+        g[n] = f->g;
+        vad[n] = &f->vad_prob;
+        features[n] = f->features;
+        active[n++] = i;
+      }
+    }
+    if (n) compute_rnn_batch(rnn, n, g, vad, features);
+    for (i=0;i<n;i++) {
+      struct frame_batch *f = &frames[active[i]];
+      apply_gains(st[batch+active[i]], f->X, f->P, f->Ex, f->Ep, f->Exp, f->g);
+    }
+    for (i=0;i<size;i++) {
+      frame_synthesis(st[batch+i], out[batch+i], frames[i].X);
+      if (vad_prob) vad_prob[batch+i] = frames[i].vad_prob;
+    }
+  }
+}
+
 #if TRAINING
 
 static float uni_rand() {
@@ -37,6 +37,8 @@
 #include "rnn.h"
 #include "rnn_data.h"
 #include <stdio.h>
+#include <string.h>
+#include <util/sse-intrin.h>
 
 static OPUS_INLINE float tansig_approx(float x)
 {
@@ -176,3 +178,192 @@ void compute_rnn(RNNState *rnn, float *gains, float *vad, const float *input) {
   compute_gru(rnn->model->denoise_gru, rnn->denoise_gru_state, denoise_input);
   compute_dense(rnn->model->denoise_output, gains, rnn->denoise_gru_state);
 }
+
+/* Batched versions of the layers above, evaluating the same model for several
+   states at once (one per channel).  Four neurons are computed per vector and
+   each weight vector is converted once for the whole batch.  Every sum is
+   accumulated in the same order as in the scalar code, so the results are the
+   same as calling compute_rnn() on each state. */
+
+static OPUS_INLINE __m128 load_weights(const rnn_weight *w)
+{
+   int bits;
+   __m128i v;
+   memcpy(&bits, w, sizeof(bits));
+   v = _mm_cvtsi32_si128(bits);
+   v = _mm_unpacklo_epi8(v, v);
+   v = _mm_unpacklo_epi16(v, v);
+   return _mm_cvtepi32_ps(_mm_srai_epi32(v, 24));
+}
+
+static OPUS_INLINE float activate(int activation, float x)
+{
+   if (activation == ACTIVATION_SIGMOID) return sigmoid_approx(x);
+   else if (activation == ACTIVATION_TANH) return tansig_approx(x);
+   else if (activation == ACTIVATION_RELU) return relu(x);
+   else *(int*)0=0;
+   return 0;
+}
+
+static void batch_bias(float *const *sum, const rnn_weight *bias, int N, int count)
+{
+   int b, i;
+   for (b=0;b<count;b++)
+      for (i=0;i<N;i++)
+         sum[b][i] = bias[i];
+}
+
+/* sum[b][i] += weights[j*stride + i]*input[b][j] */
+static void batch_accumulate(float *const *sum, const rnn_weight *weights, int stride,
+                             int N, const float *const *input, int M, int count)
+{
+   int b, i, j;
+   for (i=0;i+4<=N;i+=4)
+   {
+      __m128 acc[RNN_MAX_BATCH];
+      for (b=0;b<count;b++)
+         acc[b] = _mm_loadu_ps(&sum[b][i]);
+      for (j=0;j<M;j++)
+      {
+         __m128 w = load_weights(&weights[j*stride + i]);
+         for (b=0;b<count;b++)
+            acc[b] = _mm_add_ps(acc[b], _mm_mul_ps(w, _mm_set1_ps(input[b][j])));
+      }
+      for (b=0;b<count;b++)
+         _mm_storeu_ps(&sum[b][i], acc[b]);
+   }
+   for (;i<N;i++)
+      for (b=0;b<count;b++)
+         for (j=0;j<M;j++)
+            sum[b][i] += weights[j*stride + i]*input[b][j];
+}
+
+/* sum[b][i] += weights[j*stride + i]*state[b][j]*gate[b][j] */
+static void batch_accumulate_gated(float *const *sum, const rnn_weight *weights, int stride,
+                                   int N, const float *const *state, const float *const *gate,
+                                   int count)
+{
+   int b, i, j;
+   for (i=0;i+4<=N;i+=4)
+   {
+      __m128 acc[RNN_MAX_BATCH];
+      for (b=0;b<count;b++)
+         acc[b] = _mm_loadu_ps(&sum[b][i]);
+      for (j=0;j<N;j++)
+      {
+         __m128 w = load_weights(&weights[j*stride + i]);
+         for (b=0;b<count;b++)
+            acc[b] = _mm_add_ps(acc[b], _mm_mul_ps(_mm_mul_ps(w, _mm_set1_ps(state[b][j])),
+                                                   _mm_set1_ps(gate[b][j])));
+      }
+      for (b=0;b<count;b++)
+         _mm_storeu_ps(&sum[b][i], acc[b]);
+   }
+   for (;i<N;i++)
+      for (b=0;b<count;b++)
+         for (j=0;j<N;j++)
+            sum[b][i] += weights[j*stride + i]*state[b][j]*gate[b][j];
+}
+
+static void compute_dense_batch(const DenseLayer *layer, float **output, const float **input,
+                                int count)
+{
+   int b, i;
+   int N = layer->nb_neurons;
+   batch_bias(output, layer->bias, N, count);
+   batch_accumulate(output, layer->input_weights, N, N, input, layer->nb_inputs, count);
+   for (b=0;b<count;b++)
+      for (i=0;i<N;i++)
+         output[b][i] = activate(layer->activation, WEIGHTS_SCALE*output[b][i]);
+}
+
+static void compute_gru_batch(const GRULayer *gru, float **state, const float **input, int count)
+{
+   int b, i;
+   int N, M;
+   int stride;
+   float z[RNN_MAX_BATCH][MAX_NEURONS];
+   float r[RNN_MAX_BATCH][MAX_NEURONS];
+   float h[RNN_MAX_BATCH][MAX_NEURONS];
+   float *zp[RNN_MAX_BATCH], *rp[RNN_MAX_BATCH], *hp[RNN_MAX_BATCH];
+   M = gru->nb_inputs;
+   N = gru->nb_neurons;
+   stride = 3*N;
+   for (b=0;b<count;b++)
+   {
+      zp[b] = z[b];
+      rp[b] = r[b];
+      hp[b] = h[b];
+   }
+   /* Compute update gate. */
+   batch_bias(zp, gru->bias, N, count);
+   batch_accumulate(zp, gru->input_weights, stride, N, input, M, count);
+   batch_accumulate(zp, gru->recurrent_weights, stride, N, (const float **)state, N, count);
+   /* Compute reset gate. */
+   batch_bias(rp, gru->bias + N, N, count);
+   batch_accumulate(rp, gru->input_weights + N, stride, N, input, M, count);
+   batch_accumulate(rp, gru->recurrent_weights + N, stride, N, (const float **)state, N, count);
+   for (b=0;b<count;b++)
+   {
+      for (i=0;i<N;i++)
+      {
+         z[b][i] = sigmoid_approx(WEIGHTS_SCALE*z[b][i]);
+         r[b][i] = sigmoid_approx(WEIGHTS_SCALE*r[b][i]);
+      }
+   }
+   /* Compute output. */
+   batch_bias(hp, gru->bias + 2*N, N, count);
+   batch_accumulate(hp, gru->input_weights + 2*N, stride, N, input, M, count);
+   batch_accumulate_gated(hp, gru->recurrent_weights + 2*N, stride, N, (const float **)state,
+                          (const float **)rp, count);
+   for (b=0;b<count;b++)
+   {
+      for (i=0;i<N;i++)
+      {
+         float sum = activate(gru->activation, WEIGHTS_SCALE*h[b][i]);
+         h[b][i] = z[b][i]*state[b][i] + (1-z[b][i])*sum;
+      }
+      for (i=0;i<N;i++)
+         state[b][i] = h[b][i];
+   }
+}
+
+void compute_rnn_batch(RNNState **rnn, int count, float **gains, float **vad, const float **input) {
+  int b, i;
+  const RNNModel *model = rnn[0]->model;
+  float dense_out[RNN_MAX_BATCH][MAX_NEURONS];
+  float noise_input[RNN_MAX_BATCH][MAX_NEURONS*3];
+  float denoise_input[RNN_MAX_BATCH][MAX_NEURONS*3];
+  float *dense_p[RNN_MAX_BATCH], *noise_p[RNN_MAX_BATCH], *denoise_p[RNN_MAX_BATCH];
+  float *vad_state[RNN_MAX_BATCH], *noise_state[RNN_MAX_BATCH], *denoise_state[RNN_MAX_BATCH];
+  for (b=0;b<count;b++) {
+    /* only states sharing a model can be batched */
+    if (rnn[b]->model != model) {
+      for (b=0;b<count;b++) compute_rnn(rnn[b], gains[b], vad[b], input[b]);
+      return;
+    }
+    dense_p[b] = dense_out[b];
+    noise_p[b] = noise_input[b];
+    denoise_p[b] = denoise_input[b];
+    vad_state[b] = rnn[b]->vad_gru_state;
+    noise_state[b] = rnn[b]->noise_gru_state;
+    denoise_state[b] = rnn[b]->denoise_gru_state;
+  }
+  compute_dense_batch(model->input_dense, dense_p, input, count);
+  compute_gru_batch(model->vad_gru, vad_state, (const float **)dense_p, count);
+  compute_dense_batch(model->vad_output, vad, (const float **)vad_state, count);
+  for (b=0;b<count;b++) {
+    for (i=0;i<model->input_dense_size;i++) noise_input[b][i] = dense_out[b][i];
+    for (i=0;i<model->vad_gru_size;i++) noise_input[b][i+model->input_dense_size] = vad_state[b][i];
+    for (i=0;i<INPUT_SIZE;i++) noise_input[b][i+model->input_dense_size+model->vad_gru_size] = input[b][i];
+  }
+  compute_gru_batch(model->noise_gru, noise_state, (const float **)noise_p, count);
+
+  for (b=0;b<count;b++) {
+    for (i=0;i<model->vad_gru_size;i++) denoise_input[b][i] = vad_state[b][i];
+    for (i=0;i<model->noise_gru_size;i++) denoise_input[b][i+model->vad_gru_size] = noise_state[b][i];
+    for (i=0;i<INPUT_SIZE;i++) denoise_input[b][i+model->vad_gru_size+model->noise_gru_size] = input[b][i];
+  }
+  compute_gru_batch(model->denoise_gru, denoise_state, (const float **)denoise_p, count);
+  compute_dense_batch(model->denoise_output, gains, (const float **)denoise_state, count);
+}
@@ -475,6 +475,7 @@ static void *send_thread(void *data)
 	ftl_status_t status_code;
 
 	os_set_thread_name("ftl-stream: send_thread");
+	bmem_set_thread_tag(BMEM_TAG_OUTPUT);
 
 	while (os_sem_wait(stream->send_sem) == 0) {
 		struct encoder_packet packet;
@@ -574,6 +574,7 @@ static void *send_thread(void *data)
 	struct rtmp_stream *stream = data;
 
 	os_set_thread_name("rtmp-stream: send_thread");
+	bmem_set_thread_tag(BMEM_TAG_OUTPUT);
 
 	while (os_sem_wait(stream->send_sem) == 0) {
 		struct encoder_packet packet;
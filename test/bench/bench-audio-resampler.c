@@ -0,0 +1,158 @@
+#include <math.h>
+#include <stdio.h>
+
+#include <media-io/audio-resampler.h>
+#include <util/bmem.h>
+#include <util/platform.h>
+
+#define TONE_HZ 1000.0
+#define TONE_AMP 0.5
+#define SPEED_ITERATIONS 20000
+
+static const char *type_names[] = {"ffmpeg", "native fast", "native medium",
+				   "native high"};
+
+static const uint32_t rate_pairs[][2] = {
+	{44100, 48000},
+	{48000, 44100},
+	{48000, 16000},
+	{16000, 48000},
+};
+
+static audio_resampler_t *create(enum audio_resample_type type,
+				 uint32_t in_rate, uint32_t out_rate)
+{
+	struct resample_info src = {in_rate, AUDIO_FORMAT_FLOAT_PLANAR,
+				    SPEAKERS_STEREO};
+	struct resample_info dst = {out_rate, AUDIO_FORMAT_FLOAT_PLANAR,
+				    SPEAKERS_STEREO};
+
+	return audio_resampler_create2(&dst, &src, type);
+}
+
+/* one second of a 1 kHz tone in uneven packets, measured the same way as
+ * test_audio_resampler: every output sample is compared against the tone
+ * at the time the reported timestamp offset puts it at */
+static bool measure_thd_n(enum audio_resample_type type, uint32_t in_rate,
+			  uint32_t out_rate, double *thd_n_db)
+{
+	static const uint32_t packet_sizes[] = {441, 1024, 17, 480, 1, 700};
+	audio_resampler_t *rs = create(type, in_rate, out_rate);
+	float *buf = bmalloc(sizeof(float) * 1024);
+	double err_sum = 0.0;
+	double ref_sum = 0.0;
+	uint64_t in_pos = 0;
+	uint64_t out_pos = 0;
+	uint64_t delay_ns = 0;
+
+	if (!rs) {
+		bfree(buf);
+		return false;
+	}
+
+	for (size_t packet = 0; in_pos < in_rate; packet++) {
+		uint32_t frames = packet_sizes[packet % 6];
+		const uint8_t *input[2] = {(uint8_t *)buf, (uint8_t *)buf};
+		uint8_t *output[MAX_AV_PLANES] = {0};
+		uint32_t out_frames;
+		uint64_t ts_offset;
+
+		for (uint32_t i = 0; i < frames; i++)
+			buf[i] = (float)(TONE_AMP *
+					 sin(2.0 * M_PI * TONE_HZ *
+					     (double)(in_pos + i) / in_rate));
+
+		if (!audio_resampler_resample(rs, output, &out_frames,
+					      &ts_offset, input, frames))
+			break;
+
+		/* the first packet's offset is the resampler's delay */
+		if (packet == 0)
+			delay_ns = ts_offset;
+
+		for (uint32_t i = 0; i < out_frames; i++) {
+			const float *l = (const float *)output[0];
+			double t = (double)(out_pos + i) / out_rate +
+				   (double)delay_ns / 1e9;
+			double ref = TONE_AMP * sin(2.0 * M_PI * TONE_HZ * t);
+
+			/* skip the filter ramping up from silence */
+			if (out_pos + i < out_rate / 100)
+				continue;
+
+			err_sum += (l[i] - ref) * (l[i] - ref);
+			ref_sum += ref * ref;
+		}
+
+		in_pos += frames;
+		out_pos += out_frames;
+	}
+
+	*thd_n_db = 10.0 * log10(err_sum / ref_sum);
+
+	audio_resampler_destroy(rs);
+	bfree(buf);
+	return true;
+}
+
+/* stereo 44.1 kHz to 48 kHz, in 1024 frame packets */
+static bool measure_speed(enum audio_resample_type type, double *us)
+{
+	audio_resampler_t *rs = create(type, 44100, 48000);
+	float *buf = bmalloc(sizeof(float) * 1024);
+	const uint8_t *input[2] = {(uint8_t *)buf, (uint8_t *)buf};
+	uint64_t start;
+
+	if (!rs) {
+		bfree(buf);
+		return false;
+	}
+
+	for (int i = 0; i < 1024; i++)
+		buf[i] = sinf((float)i * 0.1f);
+
+	start = os_gettime_ns();
+	for (int i = 0; i < SPEED_ITERATIONS; i++) {
+		uint8_t *output[MAX_AV_PLANES];
+		uint32_t out_frames;
+		uint64_t ts_offset;
+
+		audio_resampler_resample(rs, output, &out_frames, &ts_offset,
+					 input, 1024);
+	}
+	*us = (double)(os_gettime_ns() - start) / SPEED_ITERATIONS / 1000.0;
+
+	audio_resampler_destroy(rs);
+	bfree(buf);
+	return true;
+}
+
+int main(void)
+{
+	for (int type = AUDIO_RESAMPLE_FFMPEG;
+	     type <= AUDIO_RESAMPLE_NATIVE_HIGH; type++) {
+		double us;
+
+		printf("%s\n", type_names[type]);
+
+		for (size_t i = 0; i < 4; i++) {
+			double thd_n;
+
+			if (!measure_thd_n((enum audio_resample_type)type,
+					   rate_pairs[i][0], rate_pairs[i][1],
+					   &thd_n)) {
+				printf("  unavailable\n");
+				break;
+			}
+
+			printf("  %5u -> %5u: THD+N %7.1f dB\n",
+			       rate_pairs[i][0], rate_pairs[i][1], thd_n);
+		}
+
+		if (measure_speed((enum audio_resample_type)type, &us))
+			printf("  %5u -> %5u: %.2f us per 1024 frames\n",
+			       44100, 48000, us);
+	}
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <util/bmem.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define ITERATIONS 2000000
+#define NUM_SIZES 64
+#define BATCH 16
+#define MAX_THREADS 4
+
+enum alloc_type {
+	ALLOC_MALLOC,
+	ALLOC_BMALLOC,
+	ALLOC_POOLED,
+};
+
+static const char *type_names[] = {"malloc", "bmalloc", "bmalloc_pooled"};
+
+struct bench_thread {
+	pthread_t thread;
+	enum alloc_type type;
+};
+
+static inline size_t get_size(size_t i)
+{
+	return 16 + (i % NUM_SIZES) * 64;
+}
+
+static inline void *do_alloc(enum alloc_type type, size_t size)
+{
+	switch (type) {
+	case ALLOC_MALLOC:
+		return malloc(size);
+	case ALLOC_POOLED:
+		return bmalloc_pooled(size, BMEM_TAG_DATA);
+	default:
+		return bmalloc(size);
+	}
+}
+
+static inline void do_free(enum alloc_type type, void *ptr)
+{
+	if (type == ALLOC_MALLOC)
+		free(ptr);
+	else
+		bfree(ptr);
+}
+
+/* allocates a small batch before freeing it, so frees don't always hand
+ * back the block that was just allocated */
+static void *bench_thread(void *param)
+{
+	struct bench_thread *bt = param;
+	void *ptrs[BATCH];
+
+	for (size_t i = 0; i < ITERATIONS; i += BATCH) {
+		for (size_t j = 0; j < BATCH; j++) {
+			ptrs[j] = do_alloc(bt->type, get_size(i + j));
+			*(volatile char *)ptrs[j] = 0;
+		}
+		for (size_t j = 0; j < BATCH; j++)
+			do_free(bt->type, ptrs[j]);
+	}
+
+	return NULL;
+}
+
+static void run(enum alloc_type type, int num_threads)
+{
+	struct bench_thread threads[MAX_THREADS] = {0};
+	uint64_t start = os_gettime_ns();
+	uint64_t total_ns;
+
+	for (int i = 0; i < num_threads; i++) {
+		threads[i].type = type;
+		pthread_create(&threads[i].thread, NULL, bench_thread,
+			       &threads[i]);
+	}
+	for (int i = 0; i < num_threads; i++)
+		pthread_join(threads[i].thread, NULL);
+
+	total_ns = os_gettime_ns() - start;
+
+	printf("%-16s %d thread(s): %6.1f ns per alloc/free\n",
+	       type_names[type], num_threads,
+	       (double)total_ns / (double)(ITERATIONS * num_threads));
+}
+
+int main(void)
+{
+	for (int type = ALLOC_MALLOC; type <= ALLOC_POOLED; type++) {
+		run((enum alloc_type)type, 1);
+		run((enum alloc_type)type, MAX_THREADS);
+	}
+
+	return 0;
+}
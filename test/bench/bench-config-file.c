@@ -0,0 +1,93 @@
+#include <stdio.h>
+
+#include <util/config-file.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+
+#define NUM_SECTIONS 20
+#define NUM_ITEMS 30
+#define LOAD_ITERATIONS 2000
+#define LOOKUP_ITERATIONS 2000
+
+/* roughly the size of a profile's basic.ini plus a few plugin sections */
+static void build_ini(struct dstr *ini)
+{
+	for (int s = 0; s < NUM_SECTIONS; s++) {
+		dstr_catf(ini, "[Section%d]\n", s);
+		for (int i = 0; i < NUM_ITEMS; i++)
+			dstr_catf(ini, "SomeSettingName%d=%d\n", i, s * i);
+		dstr_cat(ini, "\n");
+	}
+}
+
+static char sections[NUM_SECTIONS][32];
+static char names[NUM_ITEMS][32];
+
+/* lookups are case-insensitive, so look names up in a different case from
+ * the file */
+static void build_names(void)
+{
+	for (int s = 0; s < NUM_SECTIONS; s++)
+		snprintf(sections[s], sizeof(sections[s]), "section%d", s);
+	for (int i = 0; i < NUM_ITEMS; i++)
+		snprintf(names[i], sizeof(names[i]), "somesettingname%d", i);
+}
+
+/* includes one lookup, as the new index is built on the first one */
+static void bench_load(const char *ini)
+{
+	uint64_t start = os_gettime_ns();
+	uint64_t total_ns;
+
+	for (int i = 0; i < LOAD_ITERATIONS; i++) {
+		config_t *config;
+		config_open_string(&config, ini);
+		config_get_int(config, sections[0], names[0]);
+		config_close(config);
+	}
+
+	total_ns = os_gettime_ns() - start;
+	printf("%-8s: %8.1f us\n", "load",
+	       (double)total_ns / (double)LOAD_ITERATIONS / 1000.0);
+}
+
+static void bench_lookup(const char *ini)
+{
+	config_t *config;
+	uint64_t start;
+	uint64_t total_ns;
+	int64_t sum = 0;
+
+	config_open_string(&config, ini);
+
+	start = os_gettime_ns();
+	for (int n = 0; n < LOOKUP_ITERATIONS; n++) {
+		for (int s = 0; s < NUM_SECTIONS; s++) {
+			for (int i = 0; i < NUM_ITEMS; i++)
+				sum += config_get_int(config, sections[s],
+						      names[i]);
+		}
+	}
+	total_ns = os_gettime_ns() - start;
+
+	printf("%-8s: %8.1f ns (checksum %lld)\n", "lookup",
+	       (double)total_ns /
+		       (double)(LOOKUP_ITERATIONS * NUM_SECTIONS * NUM_ITEMS),
+	       (long long)sum);
+
+	config_close(config);
+}
+
+int main(void)
+{
+	struct dstr ini = {0};
+
+	build_ini(&ini);
+	build_names();
+	printf("%d sections of %d items\n", NUM_SECTIONS, NUM_ITEMS);
+	bench_load(ini.array);
+	bench_lookup(ini.array);
+
+	dstr_free(&ini);
+	return 0;
+}
@@ -0,0 +1,202 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <media-io/audio-math.h>
+#include <util/platform.h>
+
+#include "dynamics.h"
+
+#define SAMPLE_RATE 48000
+#define CHANNELS 2
+#define FRAMES 1024
+#define ITERATIONS 20000
+
+/* the loops the compressor and expander filters used before dynamics.c */
+
+static void scalar_peak_envelope(float *env_buf, float **samples,
+				 size_t channels, size_t frames,
+				 float *envelope, float attack_gain,
+				 float release_gain)
+{
+	memset(env_buf, 0, frames * sizeof(float));
+	for (size_t chan = 0; chan < channels; ++chan) {
+		float env = *envelope;
+		for (size_t i = 0; i < frames; ++i) {
+			const float env_in = fabsf(samples[chan][i]);
+			if (env < env_in) {
+				env = env_in + attack_gain * (env - env_in);
+			} else {
+				env = env_in + release_gain * (env - env_in);
+			}
+			env_buf[i] = fmaxf(env_buf[i], env);
+		}
+	}
+	*envelope = env_buf[frames - 1];
+}
+
+static void scalar_compression(const float *env_buf, float **samples,
+			       size_t channels, size_t frames, float threshold,
+			       float slope, float output_gain)
+{
+	for (size_t i = 0; i < frames; ++i) {
+		const float env_db = mul_to_db(env_buf[i]);
+		float gain = slope * (threshold - env_db);
+		gain = db_to_mul(fminf(0, gain));
+
+		for (size_t c = 0; c < channels; ++c)
+			samples[c][i] *= gain * output_gain;
+	}
+}
+
+static void scalar_rms_envelope(float **env, float **samples,
+				size_t channels, size_t frames,
+				float *runave_state, float coef)
+{
+	for (size_t chan = 0; chan < channels; ++chan) {
+		float runave = runave_state[chan];
+
+		for (size_t i = 0; i < frames; ++i) {
+			runave = coef * runave +
+				 (1 - coef) * powf(samples[chan][i], 2.0f);
+			env[chan][i] = sqrtf(runave);
+		}
+		runave_state[chan] = runave;
+	}
+}
+
+static void scalar_expansion(float **env, float **samples, size_t channels,
+			     size_t frames, float *gain_state, float threshold,
+			     float slope, float attack_gain,
+			     float release_gain, float output_gain)
+{
+	for (size_t chan = 0; chan < channels; chan++) {
+		float prev = gain_state[chan];
+
+		for (size_t i = 0; i < frames; ++i) {
+			float env_db = mul_to_db(env[chan][i]);
+			float gain = threshold - env_db > 0.0f
+					     ? fmaxf(slope * (threshold - env_db),
+						     -60.0f)
+					     : 0.0f;
+			if (gain > prev)
+				prev = attack_gain * prev +
+				       (1.0f - attack_gain) * gain;
+			else
+				prev = release_gain * prev +
+				       (1.0f - release_gain) * gain;
+
+			gain = db_to_mul(fminf(0, prev));
+			samples[chan][i] *= gain * output_gain;
+		}
+		gain_state[chan] = prev;
+	}
+}
+
+/* -------------------------------------------------------- */
+
+static float input[CHANNELS][FRAMES];
+static float buffers[CHANNELS][FRAMES];
+static float env_buffers[CHANNELS][FRAMES];
+static float gain_buffers[CHANNELS][FRAMES];
+static float *samples[CHANNELS];
+static float *env[CHANNELS];
+static float *gain_db[CHANNELS];
+
+static float attack;
+static float release;
+
+static inline float coef(float time_ms)
+{
+	return expf(-1.0f / (SAMPLE_RATE * time_ms / 1000.0f));
+}
+
+static void compressor_scalar(void)
+{
+	static float state;
+
+	scalar_peak_envelope(env[0], samples, CHANNELS, FRAMES, &state,
+			     attack, release);
+	scalar_compression(env[0], samples, CHANNELS, FRAMES, -18.0f, 0.9f,
+			   1.0f);
+}
+
+static void compressor_vector(void)
+{
+	static float state;
+
+	dynamics_peak_envelope(env[0], samples, CHANNELS, FRAMES, &state,
+			       attack, release);
+	dynamics_compressor_gain(env[0], env[0], FRAMES, -18.0f, 0.9f, 1.0f);
+	dynamics_apply_gain(samples, CHANNELS, env[0], FRAMES);
+}
+
+static void expander_scalar(void)
+{
+	static float runave[CHANNELS];
+	static float gain[CHANNELS];
+
+	scalar_rms_envelope(env, samples, CHANNELS, FRAMES, runave, 0.998f);
+	scalar_expansion(env, samples, CHANNELS, FRAMES, gain, -40.0f, -1.0f,
+			 attack, release, 1.0f);
+}
+
+static void expander_vector(void)
+{
+	static float mean_square[CHANNELS];
+	static float gain[CHANNELS];
+
+	dynamics_rms_envelope(env, samples, CHANNELS, FRAMES, mean_square,
+			      0.998f);
+	dynamics_expander_gain(gain_db, env, CHANNELS, FRAMES, gain, -40.0f,
+			       -1.0f, attack, release);
+	for (size_t c = 0; c < CHANNELS; c++)
+		dynamics_apply_gain_db(samples[c], gain_db[c], FRAMES, 1.0f);
+}
+
+static void run(const char *name, void (*func)(void))
+{
+	uint64_t start = os_gettime_ns();
+	uint64_t total_ns;
+
+	for (int i = 0; i < ITERATIONS; i++) {
+		memcpy(buffers, input, sizeof(buffers));
+		func();
+	}
+
+	total_ns = os_gettime_ns() - start;
+
+	printf("%-18s: %6.2f us per %d frame stereo block\n", name,
+	       (double)total_ns / (double)ITERATIONS / 1000.0, FRAMES);
+}
+
+int main(void)
+{
+	uint32_t rand_state = 1;
+
+	for (size_t c = 0; c < CHANNELS; c++) {
+		samples[c] = buffers[c];
+		env[c] = env_buffers[c];
+		gain_db[c] = gain_buffers[c];
+
+		/* noise that fades in and out, to move the envelopes */
+		for (size_t i = 0; i < FRAMES; i++) {
+			float level = (float)((i / 128) % 4) * 0.3f;
+			rand_state = rand_state * 1664525 + 1013904223;
+			input[c][i] = level *
+				      ((float)(rand_state >> 8) /
+					       (float)(1 << 23) -
+				       1.0f);
+		}
+	}
+
+	attack = coef(6.0f);
+	release = coef(60.0f);
+
+	run("compressor scalar", compressor_scalar);
+	run("compressor", compressor_vector);
+	run("expander scalar", expander_scalar);
+	run("expander", expander_vector);
+
+	return 0;
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <media-io/format-conversion.h>
+#include <util/bmem.h>
+#include <util/platform.h>
+
+#define WIDTH 1920
+#define HEIGHT 1080
+#define ITERATIONS 500
+
+static uint8_t *planes[3];
+static uint32_t linesizes[3];
+static uint8_t *packed;
+static uint8_t *output;
+
+static void fill(uint8_t *data, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		data[i] = (uint8_t)(i * 7 + (i >> 8));
+}
+
+static void bench_420(void)
+{
+	decompress_420((const uint8_t *const *)planes, linesizes, 0, HEIGHT,
+		       output, WIDTH * 4);
+}
+
+static void bench_nv12(void)
+{
+	decompress_nv12((const uint8_t *const *)planes, linesizes, 0, HEIGHT,
+			output, WIDTH * 4);
+}
+
+static void bench_422(void)
+{
+	/* decompress_422 converts in_linesize pixels from each line, so pass
+	 * the width rather than the pitch to convert a single frame's worth */
+	decompress_422(packed, WIDTH, 0, HEIGHT, output, WIDTH * 4, true);
+}
+
+static void run(const char *name, void (*func)(void))
+{
+	uint64_t start;
+	uint64_t total_ns;
+
+	func();
+
+	start = os_gettime_ns();
+	for (int i = 0; i < ITERATIONS; i++)
+		func();
+	total_ns = os_gettime_ns() - start;
+
+	printf("%-16s %dx%d: %8.1f us per frame\n", name, WIDTH, HEIGHT,
+	       (double)total_ns / (double)ITERATIONS / 1000.0);
+}
+
+int main(void)
+{
+	/* plane 1 is big enough for both I420 and interleaved NV12 chroma */
+	linesizes[0] = WIDTH;
+	linesizes[1] = WIDTH / 2;
+	linesizes[2] = WIDTH / 2;
+	planes[0] = bmalloc(WIDTH * HEIGHT);
+	planes[1] = bmalloc(WIDTH * HEIGHT / 2);
+	planes[2] = bmalloc(WIDTH * HEIGHT / 4);
+	packed = bmalloc(WIDTH * 2 * HEIGHT);
+	output = bmalloc(WIDTH * 4 * HEIGHT);
+
+	fill(planes[0], WIDTH * HEIGHT);
+	fill(planes[1], WIDTH * HEIGHT / 2);
+	fill(planes[2], WIDTH * HEIGHT / 4);
+	fill(packed, WIDTH * 2 * HEIGHT);
+
+	run("decompress_420", bench_420);
+	linesizes[1] = WIDTH;
+	run("decompress_nv12", bench_nv12);
+	run("decompress_422", bench_422);
+
+	bfree(planes[0]);
+	bfree(planes[1]);
+	bfree(planes[2]);
+	bfree(packed);
+	bfree(output);
+	return 0;
+}
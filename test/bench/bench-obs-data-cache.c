@@ -0,0 +1,101 @@
+#include <stdio.h>
+
+#include <obs-data.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+
+#define NUM_SOURCES 500
+#define ITERATIONS 50
+#define FILE_NAME "bench-obs-data-cache.json"
+
+/* something shaped like a large scene collection */
+static obs_data_t *build_collection(void)
+{
+	obs_data_t *collection = obs_data_create();
+	obs_data_array_t *sources = obs_data_array_create();
+	char name[64];
+
+	for (int i = 0; i < NUM_SOURCES; i++) {
+		obs_data_t *source = obs_data_create();
+		obs_data_t *settings = obs_data_create();
+		obs_data_array_t *filters = obs_data_array_create();
+
+		snprintf(name, sizeof(name), "Source %d", i);
+		obs_data_set_string(source, "name", name);
+		obs_data_set_string(source, "id", "image_source");
+		obs_data_set_int(source, "flags", 0);
+		obs_data_set_double(source, "volume", 1.0);
+		obs_data_set_bool(source, "enabled", true);
+
+		for (int j = 0; j < 12; j++) {
+			snprintf(name, sizeof(name), "setting_%d", j);
+			if (j % 3 == 0)
+				obs_data_set_string(settings, name,
+						    "/home/user/media/file.png");
+			else if (j % 3 == 1)
+				obs_data_set_int(settings, name, i * j);
+			else
+				obs_data_set_bool(settings, name, j & 1);
+		}
+		obs_data_set_obj(source, "settings", settings);
+
+		for (int j = 0; j < 2; j++) {
+			obs_data_t *filter = obs_data_create();
+			obs_data_set_string(filter, "id", "color_filter");
+			obs_data_set_string(filter, "name", "Color Correction");
+			obs_data_set_double(filter, "gamma", 0.1 * j);
+			obs_data_array_push_back(filters, filter);
+			obs_data_release(filter);
+		}
+		obs_data_set_array(source, "filters", filters);
+
+		obs_data_array_push_back(sources, source);
+		obs_data_array_release(filters);
+		obs_data_release(settings);
+		obs_data_release(source);
+	}
+
+	obs_data_set_array(collection, "sources", sources);
+	obs_data_array_release(sources);
+	return collection;
+}
+
+static void run(const char *name, bool cached)
+{
+	uint64_t start = os_gettime_ns();
+	uint64_t total_ns;
+
+	for (int i = 0; i < ITERATIONS; i++) {
+		obs_data_t *data =
+			cached ? obs_data_create_from_json_file_cached(FILE_NAME,
+								       "bak")
+			       : obs_data_create_from_json_file_safe(FILE_NAME,
+								     "bak");
+		obs_data_release(data);
+	}
+
+	total_ns = os_gettime_ns() - start;
+	printf("%-8s: %7.2f ms per load\n", name,
+	       (double)total_ns / (double)ITERATIONS / 1000000.0);
+}
+
+int main(void)
+{
+	obs_data_t *collection = build_collection();
+
+	if (!obs_data_save_json_cached(collection, FILE_NAME, "tmp", "bak")) {
+		printf("failed to save %s\n", FILE_NAME);
+		return 1;
+	}
+
+	printf("%d sources, %lld byte JSON file\n", NUM_SOURCES,
+	       (long long)os_get_file_size(FILE_NAME));
+	run("json", false);
+	run("cached", true);
+
+	os_unlink(FILE_NAME);
+	os_unlink(FILE_NAME ".bin");
+	os_unlink(FILE_NAME ".bak");
+	obs_data_release(collection);
+	return 0;
+}
@@ -0,0 +1,181 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <math.h>
+#include <string.h>
+
+#include <media-io/audio-resampler.h>
+#include <util/bmem.h>
+
+#define TONE_HZ 1000.0
+#define TONE_AMP 0.5
+
+struct sine_result {
+	double thd_n_db;
+	double max_ts_error_ns;
+};
+
+/* feeds a tone through the resampler in uneven packets, and compares every
+ * output sample against the tone at the time its timestamp says it is at */
+static struct sine_result run_sine(enum audio_resample_type type,
+				   uint32_t in_rate, uint32_t out_rate)
+{
+	static const uint32_t packet_sizes[] = {441, 1024, 17, 480, 1, 700};
+	struct resample_info src = {in_rate, AUDIO_FORMAT_FLOAT_PLANAR,
+				    SPEAKERS_STEREO};
+	struct resample_info dst = {out_rate, AUDIO_FORMAT_FLOAT_PLANAR,
+				    SPEAKERS_STEREO};
+	audio_resampler_t *rs = audio_resampler_create2(&dst, &src, type);
+	struct sine_result result = {0};
+	double err_sum = 0.0;
+	double ref_sum = 0.0;
+	uint64_t in_pos = 0;
+	uint64_t out_pos = 0;
+	float *buf = bmalloc(sizeof(float) * 1024);
+
+	assert_non_null(rs);
+
+	for (size_t packet = 0; in_pos < in_rate; packet++) {
+		uint32_t frames = packet_sizes[packet % 6];
+		const uint8_t *input[2] = {(uint8_t *)buf, (uint8_t *)buf};
+		uint8_t *output[MAX_AV_PLANES] = {0};
+		uint64_t in_ts = in_pos * 1000000000ULL / in_rate;
+		uint64_t ts_offset;
+		uint32_t out_frames;
+		double out_ts;
+		double ts_err;
+
+		for (uint32_t i = 0; i < frames; i++)
+			buf[i] = (float)(TONE_AMP *
+					 sin(2.0 * M_PI * TONE_HZ *
+					     (double)(in_pos + i) / in_rate));
+
+		assert_true(audio_resampler_resample(rs, output, &out_frames,
+						     &ts_offset, input,
+						     frames));
+
+		/* where the first output sample of the packet actually is */
+		out_ts = (double)out_pos * 1e9 / out_rate;
+		ts_err = fabs((double)in_ts - (double)ts_offset - out_ts);
+		if (out_frames && ts_err > result.max_ts_error_ns)
+			result.max_ts_error_ns = ts_err;
+
+		for (uint32_t i = 0; i < out_frames; i++) {
+			const float *l = (const float *)output[0];
+			const float *r = (const float *)output[1];
+			uint64_t n = out_pos + i;
+			double ref = TONE_AMP * sin(2.0 * M_PI * TONE_HZ *
+						    (double)n / out_rate);
+
+			assert_true(l[i] == r[i]);
+
+			/* skip the filter ramping up from silence */
+			if (n < out_rate / 100)
+				continue;
+
+			err_sum += (l[i] - ref) * (l[i] - ref);
+			ref_sum += ref * ref;
+		}
+
+		in_pos += frames;
+		out_pos += out_frames;
+	}
+
+	/* everything but the filter delay has to come out */
+	assert_true(out_pos + out_rate / 100 >=
+		    in_pos * out_rate / in_rate);
+
+	result.thd_n_db = 10.0 * log10(err_sum / ref_sum);
+
+	audio_resampler_destroy(rs);
+	bfree(buf);
+	return result;
+}
+
+static void check_sine(enum audio_resample_type type, uint32_t in_rate,
+		       uint32_t out_rate, double max_thd_n_db)
+{
+	struct sine_result r = run_sine(type, in_rate, out_rate);
+
+	if (r.thd_n_db > max_thd_n_db)
+		fail_msg("%u -> %u: THD+N %.1f dB, expected below %.1f dB",
+			 in_rate, out_rate, r.thd_n_db, max_thd_n_db);
+
+	/* only rounding of the nanosecond values */
+	assert_true(r.max_ts_error_ns < 2.0);
+}
+
+static void resample_quality_test(void **state)
+{
+	check_sine(AUDIO_RESAMPLE_NATIVE_FAST, 44100, 48000, -60.0);
+	check_sine(AUDIO_RESAMPLE_NATIVE_MEDIUM, 44100, 48000, -85.0);
+	check_sine(AUDIO_RESAMPLE_NATIVE_HIGH, 44100, 48000, -115.0);
+
+	check_sine(AUDIO_RESAMPLE_NATIVE_MEDIUM, 48000, 44100, -85.0);
+	check_sine(AUDIO_RESAMPLE_NATIVE_MEDIUM, 48000, 16000, -85.0);
+	check_sine(AUDIO_RESAMPLE_NATIVE_MEDIUM, 16000, 48000, -85.0);
+
+	/* too many phases for the filter bank, so they're interpolated */
+	check_sine(AUDIO_RESAMPLE_NATIVE_MEDIUM, 44100, 47999, -85.0);
+}
+
+static void remix_test(void **state)
+{
+	struct resample_info src = {48000, AUDIO_FORMAT_16BIT, SPEAKERS_STEREO};
+	struct resample_info dst = {48000, AUDIO_FORMAT_FLOAT_PLANAR,
+				    SPEAKERS_MONO};
+	int16_t packed[8] = {16384, 0, 0, -16384, 8192, 8192, -32768, 0};
+	const uint8_t *input[1] = {(uint8_t *)packed};
+	uint8_t *output[MAX_AV_PLANES] = {0};
+	uint64_t ts_offset = 1;
+	uint32_t frames = 0;
+	audio_resampler_t *rs;
+	const float *out;
+
+	rs = audio_resampler_create2(&dst, &src, AUDIO_RESAMPLE_NATIVE_MEDIUM);
+	assert_non_null(rs);
+	assert_true(audio_resampler_resample(rs, output, &frames, &ts_offset,
+					     input, 4));
+
+	/* same rate, so no delay, and stereo goes down at -3 dB each */
+	assert_int_equal(frames, 4);
+	assert_int_equal(ts_offset, 0);
+
+	out = (const float *)output[0];
+	assert_float_equal(out[0], 0.5 * M_SQRT1_2, 1e-6);
+	assert_float_equal(out[1], -0.5 * M_SQRT1_2, 1e-6);
+	assert_float_equal(out[2], 0.5 * M_SQRT1_2, 1e-6);
+	assert_float_equal(out[3], -1.0 * M_SQRT1_2, 1e-6);
+	audio_resampler_destroy(rs);
+
+	/* mono goes to every channel but the LFE */
+	src.speakers = SPEAKERS_MONO;
+	src.format = AUDIO_FORMAT_FLOAT;
+	dst.speakers = SPEAKERS_2POINT1;
+	dst.format = AUDIO_FORMAT_16BIT;
+
+	float mono[2] = {0.25f, -1.0f};
+	input[0] = (uint8_t *)mono;
+
+	rs = audio_resampler_create2(&dst, &src, AUDIO_RESAMPLE_NATIVE_MEDIUM);
+	assert_non_null(rs);
+	assert_true(audio_resampler_resample(rs, output, &frames, &ts_offset,
+					     input, 2));
+	assert_int_equal(frames, 2);
+
+	int16_t expected[6] = {8192, 8192, 0, -32768, -32768, 0};
+	assert_memory_equal(output[0], expected, sizeof(expected));
+	audio_resampler_destroy(rs);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(resample_quality_test),
+		cmocka_unit_test(remix_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,116 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/config-file.h>
+#include <util/platform.h>
+#include <util/dstr.h>
+#include <util/bmem.h>
+
+#define NUM_KEYS 500
+
+static const char *test_ini = "[General]\n"
+			      "Name=First\n"
+			      "Count=5\n"
+			      "[Video]\n"
+			      "BaseCX=1920\n"
+			      "[General]\n"
+			      "Extra=1\n"
+			      "Name=Shadowed\n";
+
+static void config_lookup_test(void **state)
+{
+	struct dstr name = {0};
+	config_t *config;
+
+	assert_int_equal(config_open_string(&config, ""), CONFIG_SUCCESS);
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		dstr_printf(&name, "Key%d", i);
+		config_set_int(config, i & 1 ? "Odd" : "Even", name.array, i);
+	}
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		dstr_printf(&name, "key%d", i);
+		assert_int_equal(config_get_int(config,
+						i & 1 ? "ODD" : "even",
+						name.array),
+				 i);
+		assert_false(config_has_user_value(
+			config, i & 1 ? "Even" : "Odd", name.array));
+	}
+
+	/* overwriting keeps a single item */
+	config_set_string(config, "Even", "KEY0", "zero");
+	assert_string_equal(config_get_string(config, "even", "key0"), "zero");
+	assert_true(config_remove_value(config, "Even", "Key0"));
+	assert_false(config_has_user_value(config, "Even", "Key0"));
+	assert_int_equal(config_get_int(config, "Even", "Key2"), 2);
+
+	/* user values take priority over defaults */
+	config_set_default_int(config, "Even", "Key0", 100);
+	config_set_default_int(config, "Even", "Key2", 100);
+	assert_int_equal(config_get_int(config, "Even", "Key0"), 100);
+	assert_int_equal(config_get_int(config, "Even", "Key2"), 2);
+	assert_int_equal(config_get_default_int(config, "Even", "Key2"), 100);
+
+	dstr_free(&name);
+	config_close(config);
+}
+
+static void config_duplicates_test(void **state)
+{
+	config_t *config;
+
+	assert_int_equal(config_open_string(&config, test_ini),
+			 CONFIG_SUCCESS);
+
+	/* the first match in file order wins, but later sections with the
+	 * same name are still searched */
+	assert_string_equal(config_get_string(config, "General", "Name"),
+			    "First");
+	assert_int_equal(config_get_int(config, "General", "Extra"), 1);
+	assert_int_equal(config_get_int(config, "Video", "BaseCX"), 1920);
+
+	assert_true(config_remove_value(config, "General", "Name"));
+	assert_string_equal(config_get_string(config, "General", "Name"),
+			    "Shadowed");
+
+	config_close(config);
+}
+
+static void config_save_order_test(void **state)
+{
+	const char *file = "test_config_file.ini";
+	config_t *config;
+	char *text;
+
+	assert_int_equal(config_open(&config, file, CONFIG_OPEN_ALWAYS),
+			 CONFIG_SUCCESS);
+
+	config_set_string(config, "B", "z", "1");
+	config_set_string(config, "A", "y", "2");
+	config_set_string(config, "B", "a", "3");
+	config_set_string(config, "b", "Z", "4");
+	assert_int_equal(config_save(config), CONFIG_SUCCESS);
+	config_close(config);
+
+	text = os_quick_read_utf8_file(file);
+	assert_non_null(text);
+	assert_string_equal(text, "[B]\nz=4\na=3\n\n[A]\ny=2\n");
+
+	bfree(text);
+	os_unlink(file);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(config_lookup_test),
+		cmocka_unit_test(config_duplicates_test),
+		cmocka_unit_test(config_save_order_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
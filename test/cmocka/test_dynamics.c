@@ -0,0 +1,354 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include <media-io/audio-math.h>
+#include <util/bmem.h>
+
+#include "dynamics.h"
+
+#define SAMPLE_RATE 48000
+#define MAX_CHANNELS 8
+
+/* the approximated dB conversions may differ from log10f/powf by a tiny
+ * fraction of a dB, which is about this much relative to the gain */
+#define GAIN_TOLERANCE 1e-5f
+
+static uint32_t rand_state = 1;
+
+static float next_sample(size_t i)
+{
+	/* loud and quiet passages with some silence in between, so that both
+	 * attack and release are exercised */
+	static const float levels[] = {0.9f, 0.05f, 0.0f, 0.3f, 0.001f, 1.2f};
+	float level = levels[(i / 700) % (sizeof(levels) / sizeof(levels[0]))];
+
+	rand_state = rand_state * 1664525 + 1013904223;
+	return level * ((float)(rand_state >> 8) / (float)(1 << 23) - 1.0f);
+}
+
+static void fill_channels(float **samples, size_t channels, size_t frames)
+{
+	for (size_t c = 0; c < channels; c++) {
+		if (!samples[c])
+			continue;
+		for (size_t i = 0; i < frames; i++)
+			samples[c][i] = next_sample(i + c * 97);
+	}
+}
+
+static float **alloc_channels(size_t channels, size_t frames)
+{
+	float **data = bzalloc(sizeof(float *) * MAX_CHANNELS);
+	for (size_t c = 0; c < channels; c++)
+		data[c] = bzalloc(sizeof(float) * frames);
+	return data;
+}
+
+static void free_channels(float **data)
+{
+	for (size_t c = 0; c < MAX_CHANNELS; c++)
+		bfree(data[c]);
+	bfree(data);
+}
+
+static void assert_close(const float *a, const float *b, size_t frames)
+{
+	for (size_t i = 0; i < frames; i++) {
+		float diff = fabsf(a[i] - b[i]);
+		float limit = fabsf(b[i]) * GAIN_TOLERANCE + 1e-30f;
+
+		if (diff > limit)
+			fail_msg("sample %d: %.9g != %.9g", (int)i, a[i], b[i]);
+	}
+}
+
+/* -------------------------------------------------------- */
+/* scalar reference, as the filters used to do it           */
+
+static float ref_coef(float time_ms)
+{
+	return expf(-1.0f / (SAMPLE_RATE * time_ms / 1000.0f));
+}
+
+static void ref_peak_envelope(float *env_buf, float **samples,
+			      size_t channels, size_t frames, float *envelope,
+			      float attack_gain, float release_gain)
+{
+	memset(env_buf, 0, frames * sizeof(float));
+	for (size_t chan = 0; chan < channels; ++chan) {
+		if (!samples[chan])
+			continue;
+
+		float env = *envelope;
+		for (size_t i = 0; i < frames; ++i) {
+			const float env_in = fabsf(samples[chan][i]);
+			if (env < env_in) {
+				env = env_in + attack_gain * (env - env_in);
+			} else {
+				env = env_in + release_gain * (env - env_in);
+			}
+			env_buf[i] = fmaxf(env_buf[i], env);
+		}
+	}
+	*envelope = env_buf[frames - 1];
+}
+
+static void ref_compression(const float *env_buf, float **samples,
+			    size_t channels, size_t frames, float threshold,
+			    float slope, float output_gain)
+{
+	for (size_t i = 0; i < frames; ++i) {
+		const float env_db = mul_to_db(env_buf[i]);
+		float gain = slope * (threshold - env_db);
+		gain = db_to_mul(fminf(0, gain));
+
+		for (size_t c = 0; c < channels; ++c) {
+			if (samples[c])
+				samples[c][i] *= gain * output_gain;
+		}
+	}
+}
+
+static void ref_rms_envelope(float **env, float **samples, size_t channels,
+			     size_t frames, float *runave_state, float coef)
+{
+	for (size_t chan = 0; chan < channels; ++chan) {
+		float runave = runave_state[chan];
+
+		memset(env[chan], 0, frames * sizeof(float));
+		if (!samples[chan])
+			continue;
+
+		for (size_t i = 0; i < frames; ++i) {
+			runave = coef * runave +
+				 (1 - coef) * powf(samples[chan][i], 2.0f);
+			env[chan][i] = sqrtf(runave);
+		}
+		runave_state[chan] = runave;
+	}
+}
+
+static void ref_expansion(float **env, float **samples, size_t channels,
+			  size_t frames, float *gain_state, float threshold,
+			  float slope, float attack_gain, float release_gain,
+			  float output_gain)
+{
+	for (size_t chan = 0; chan < channels; chan++) {
+		float prev = gain_state[chan];
+
+		for (size_t i = 0; i < frames; ++i) {
+			float env_db = mul_to_db(env[chan][i]);
+			float gain = threshold - env_db > 0.0f
+					     ? fmaxf(slope * (threshold - env_db),
+						     -60.0f)
+					     : 0.0f;
+			if (gain > prev)
+				prev = attack_gain * prev +
+				       (1.0f - attack_gain) * gain;
+			else
+				prev = release_gain * prev +
+				       (1.0f - release_gain) * gain;
+
+			gain = db_to_mul(fminf(0, prev));
+			if (samples[chan])
+				samples[chan][i] *= gain * output_gain;
+		}
+		gain_state[chan] = prev;
+	}
+}
+
+/* -------------------------------------------------------- */
+
+static void run_compressor(size_t channels, size_t frames, bool null_chan)
+{
+	const float attack = ref_coef(6.0f);
+	const float release = ref_coef(60.0f);
+	const float threshold = -18.0f;
+	const float slope = 1.0f - 1.0f / 10.0f;
+	const float output_gain = db_to_mul(3.0f);
+
+	float **ref = alloc_channels(channels, frames);
+	float **out = alloc_channels(channels, frames);
+	float *ref_env = bzalloc(frames * sizeof(float));
+	float *env = bzalloc(frames * sizeof(float));
+	float ref_state = 0.0f;
+	float state = 0.0f;
+
+	if (null_chan) {
+		bfree(ref[0]);
+		bfree(out[0]);
+		ref[0] = out[0] = NULL;
+	}
+
+	/* several blocks in a row to carry the envelope across calls */
+	for (int block = 0; block < 4; block++) {
+		fill_channels(ref, channels, frames);
+		for (size_t c = 0; c < channels; c++) {
+			if (ref[c])
+				memcpy(out[c], ref[c], frames * sizeof(float));
+		}
+
+		ref_peak_envelope(ref_env, ref, channels, frames, &ref_state,
+				  attack, release);
+		dynamics_peak_envelope(env, out, channels, frames, &state,
+				       attack, release);
+
+		/* the envelope follower must not change at all */
+		assert_memory_equal(env, ref_env, frames * sizeof(float));
+		assert_memory_equal(&state, &ref_state, sizeof(float));
+
+		ref_compression(ref_env, ref, channels, frames, threshold,
+				slope, output_gain);
+		dynamics_compressor_gain(env, env, frames, threshold, slope,
+					 output_gain);
+		dynamics_apply_gain(out, channels, env, frames);
+
+		for (size_t c = 0; c < channels; c++) {
+			if (ref[c])
+				assert_close(out[c], ref[c], frames);
+		}
+	}
+
+	bfree(ref_env);
+	bfree(env);
+	free_channels(ref);
+	free_channels(out);
+}
+
+static void compressor_test(void **state)
+{
+	run_compressor(1, 480, false);
+	run_compressor(2, 1024, false);
+	run_compressor(2, 1023, false);
+	run_compressor(6, 441, true);
+	run_compressor(8, 3, false);
+}
+
+static void run_expander(size_t channels, size_t frames)
+{
+	const float attack = ref_coef(10.0f);
+	const float release = ref_coef(50.0f);
+	const float rms_coef = exp2f(-100.0f / SAMPLE_RATE);
+	const float threshold = -40.0f;
+	const float slope = 1.0f - 2.0f;
+	const float output_gain = db_to_mul(-2.0f);
+
+	float **ref = alloc_channels(channels, frames);
+	float **out = alloc_channels(channels, frames);
+	float **ref_env = alloc_channels(channels, frames);
+	float **env = alloc_channels(channels, frames);
+	float **gain_db = alloc_channels(channels, frames);
+	float ref_runave[MAX_CHANNELS] = {0};
+	float runave[MAX_CHANNELS] = {0};
+	float ref_gain[MAX_CHANNELS] = {0};
+	float gain[MAX_CHANNELS] = {0};
+
+	for (int block = 0; block < 4; block++) {
+		fill_channels(ref, channels, frames);
+		for (size_t c = 0; c < channels; c++)
+			memcpy(out[c], ref[c], frames * sizeof(float));
+
+		ref_rms_envelope(ref_env, ref, channels, frames, ref_runave,
+				 rms_coef);
+		dynamics_rms_envelope(env, out, channels, frames, runave,
+				      rms_coef);
+
+		for (size_t c = 0; c < channels; c++)
+			assert_memory_equal(env[c], ref_env[c],
+					    frames * sizeof(float));
+		assert_memory_equal(runave, ref_runave, sizeof(runave));
+
+		ref_expansion(ref_env, ref, channels, frames, ref_gain,
+			      threshold, slope, attack, release, output_gain);
+		dynamics_expander_gain(gain_db, env, channels, frames, gain,
+				       threshold, slope, attack, release);
+
+		for (size_t c = 0; c < channels; c++) {
+			dynamics_apply_gain_db(out[c], gain_db[c], frames,
+					       output_gain);
+			assert_close(out[c], ref[c], frames);
+		}
+	}
+
+	free_channels(ref);
+	free_channels(out);
+	free_channels(ref_env);
+	free_channels(env);
+	free_channels(gain_db);
+}
+
+static void expander_test(void **state)
+{
+	run_expander(1, 480);
+	run_expander(2, 1024);
+	run_expander(5, 1021);
+	run_expander(8, 2);
+}
+
+static void db_conversion_test(void **state)
+{
+	float env[1001];
+	float gain[1001];
+	float gain_db[1001];
+	float samples[1001];
+
+	/* from well below the threshold up to clipping */
+	for (size_t i = 0; i < 1001; i++) {
+		env[i] = db_to_mul(-100.0f + (float)i * 0.11f);
+		gain_db[i] = -60.0f + (float)i * 0.07f;
+		samples[i] = 1.0f;
+	}
+	env[0] = 0.0f;
+
+	dynamics_compressor_gain(gain, env, 1001, -30.0f, 0.75f, 1.0f);
+	dynamics_apply_gain_db(samples, gain_db, 1001, 1.0f);
+
+	for (size_t i = 0; i < 1001; i++) {
+		float ref = db_to_mul(
+			fminf(0, 0.75f * (-30.0f - mul_to_db(env[i]))));
+		assert_close(&gain[i], &ref, 1);
+
+		ref = db_to_mul(fminf(0, gain_db[i]));
+		assert_close(&samples[i], &ref, 1);
+	}
+}
+
+/* silence and denormal envelopes must give the same dB as mul_to_db */
+static void tiny_envelope_test(void **state)
+{
+	float env[] = {0.0f,   1e-30f, FLT_MIN, 1e-39f, FLT_MIN / 4.0f,
+		       1e-42f, 1e-45f, 0.0f};
+	const size_t frames = sizeof(env) / sizeof(env[0]);
+	const float slope = -0.05f;
+	float *env_chan[1] = {env};
+	float gain_db[sizeof(env) / sizeof(env[0])];
+	float *gain_chan[1] = {gain_db};
+	float gain_state = 0.0f;
+
+	/* no ballistics, so gain_db is the static gain of every sample */
+	dynamics_expander_gain(gain_chan, env_chan, 1, frames, &gain_state,
+			       0.0f, slope, 0.0f, 0.0f);
+
+	for (size_t i = 0; i < frames; i++) {
+		float ref = fmaxf(slope * -mul_to_db(env[i]), -60.0f);
+		assert_close(&gain_db[i], &ref, 1);
+	}
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(compressor_test),
+		cmocka_unit_test(expander_test),
+		cmocka_unit_test(db_conversion_test),
+		cmocka_unit_test(tiny_envelope_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,222 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <media-io/format-conversion.h>
+#include <util/bmem.h>
+
+#include <string.h>
+
+/* widths chosen so that both the vector loops and the scalar tails run */
+static const uint32_t test_widths[] = {2, 6, 16, 38, 62, 130};
+#define NUM_TEST_WIDTHS (sizeof(test_widths) / sizeof(test_widths[0]))
+#define TEST_HEIGHT 6
+
+static uint32_t rand_state = 1;
+
+static uint8_t rand_u8(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return (uint8_t)(rand_state >> 16);
+}
+
+static void fill_random(uint8_t *data, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		data[i] = rand_u8();
+}
+
+static uint8_t clamp_u8(int val)
+{
+	return (uint8_t)(val < 0 ? 0 : (val > 255 ? 255 : val));
+}
+
+/* ------------------------------------------------------------------------- */
+/* scalar references                                                         */
+
+static void ref_decompress_420(const uint8_t *const input[],
+			       const uint32_t in_linesize[], uint32_t height,
+			       uint32_t width, uint32_t *output,
+			       uint32_t out_width)
+{
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			uint32_t lum = input[0][y * in_linesize[0] + x];
+			uint32_t u = input[1][(y / 2) * in_linesize[1] + x / 2];
+			uint32_t v = input[2][(y / 2) * in_linesize[2] + x / 2];
+
+			output[y * out_width + x] = (lum << 16) | (u << 8) | v;
+		}
+	}
+}
+
+static void ref_decompress_nv12(const uint8_t *const input[],
+				const uint32_t in_linesize[], uint32_t height,
+				uint32_t width, uint32_t *output,
+				uint32_t out_width)
+{
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			const uint8_t *uv =
+				input[1] + (y / 2) * in_linesize[1] + (x & ~1);
+			uint32_t lum = input[0][y * in_linesize[0] + x];
+
+			output[y * out_width + x] = lum | (uv[0] << 8) |
+						    ((uint32_t)uv[1] << 16);
+		}
+	}
+}
+
+/* mirrors the line size handling of decompress_422, which processes
+ * min(in_linesize, out_linesize) / 2 dwords of each line */
+static void ref_decompress_422(const uint8_t *input, uint32_t in_linesize,
+			       uint32_t height, uint8_t *output,
+			       uint32_t out_linesize, bool leading_lum)
+{
+	uint32_t count = (in_linesize < out_linesize ? in_linesize
+						      : out_linesize) /
+			 2;
+
+	for (uint32_t y = 0; y < height; y++) {
+		const uint8_t *in = input + y * in_linesize;
+		uint8_t *out = output + y * out_linesize;
+
+		for (uint32_t x = 0; x < count; x++) {
+			uint32_t dw, second;
+
+			memcpy(&dw, in + x * 4, sizeof(dw));
+
+			/* replace the first luma byte with the second */
+			if (leading_lum)
+				second = (dw & 0xFFFFFF00) |
+					 ((dw >> 16) & 0xFF);
+			else
+				second = (dw & 0xFFFF00FF) |
+					 ((dw >> 16) & 0xFF00);
+
+			memcpy(out + x * 8, &dw, sizeof(dw));
+			memcpy(out + x * 8 + 4, &second, sizeof(second));
+		}
+	}
+}
+
+static uint8_t ref_bgra_to_y(const uint8_t *px)
+{
+	int val = 47 * px[2] + 157 * px[1] + 16 * px[0];
+	return (uint8_t)(((val + 128) >> 8) + 16);
+}
+
+static uint32_t ref_nv12_to_bgra(int lum, int u, int v)
+{
+	int c = 298 * (lum - 16) + 128;
+	int d = u - 128;
+	int e = v - 128;
+
+	uint32_t r = clamp_u8((c + 459 * e) >> 8);
+	uint32_t g = clamp_u8((c - 55 * d - 136 * e) >> 8);
+	uint32_t b = clamp_u8((c + 541 * d) >> 8);
+
+	return b | (g << 8) | (r << 16) | 0xFF000000;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void decompress_420_test(void **state)
+{
+	for (size_t i = 0; i < NUM_TEST_WIDTHS; i++) {
+		uint32_t width = test_widths[i];
+		uint32_t in_linesize[3] = {width, width / 2, width / 2};
+		uint8_t *planes[3];
+		uint32_t *out = bzalloc(width * TEST_HEIGHT * 4);
+		uint32_t *ref = bzalloc(width * TEST_HEIGHT * 4);
+
+		planes[0] = bmalloc(width * TEST_HEIGHT);
+		planes[1] = bmalloc(width / 2 * TEST_HEIGHT / 2);
+		planes[2] = bmalloc(width / 2 * TEST_HEIGHT / 2);
+		fill_random(planes[0], width * TEST_HEIGHT);
+		fill_random(planes[1], width / 2 * TEST_HEIGHT / 2);
+		fill_random(planes[2], width / 2 * TEST_HEIGHT / 2);
+
+		decompress_420((const uint8_t *const *)planes, in_linesize, 0,
+			       TEST_HEIGHT, (uint8_t *)out, width * 4);
+		ref_decompress_420((const uint8_t *const *)planes, in_linesize,
+				   TEST_HEIGHT, width, ref, width);
+		assert_memory_equal(out, ref, width * TEST_HEIGHT * 4);
+
+		for (size_t p = 0; p < 3; p++)
+			bfree(planes[p]);
+		bfree(out);
+		bfree(ref);
+	}
+}
+
+static void decompress_nv12_test(void **state)
+{
+	for (size_t i = 0; i < NUM_TEST_WIDTHS; i++) {
+		uint32_t width = test_widths[i];
+		uint32_t in_linesize[2] = {width, width};
+		uint8_t *planes[2];
+		uint32_t *out = bzalloc(width * TEST_HEIGHT * 4);
+		uint32_t *ref = bzalloc(width * TEST_HEIGHT * 4);
+
+		planes[0] = bmalloc(width * TEST_HEIGHT);
+		planes[1] = bmalloc(width * TEST_HEIGHT / 2);
+		fill_random(planes[0], width * TEST_HEIGHT);
+		fill_random(planes[1], width * TEST_HEIGHT / 2);
+
+		decompress_nv12((const uint8_t *const *)planes, in_linesize, 0,
+				TEST_HEIGHT, (uint8_t *)out, width * 4);
+		ref_decompress_nv12((const uint8_t *const *)planes,
+				    in_linesize, TEST_HEIGHT, width, ref,
+				    width);
+		assert_memory_equal(out, ref, width * TEST_HEIGHT * 4);
+
+		bfree(planes[0]);
+		bfree(planes[1]);
+		bfree(out);
+		bfree(ref);
+	}
+}
+
+static void decompress_422_test(void **state)
+{
+	for (int leading_lum = 0; leading_lum < 2; leading_lum++) {
+		for (size_t i = 0; i < NUM_TEST_WIDTHS; i++) {
+			uint32_t width = test_widths[i];
+			uint32_t in_linesize = width * 2;
+			uint32_t out_linesize = width * 4;
+
+			/* each line is read and written past its line size,
+			 * so leave room for one more line */
+			size_t in_size = in_linesize * (TEST_HEIGHT + 1);
+			size_t out_size = out_linesize * (TEST_HEIGHT + 1);
+			uint8_t *in = bmalloc(in_size);
+			uint8_t *out = bzalloc(out_size);
+			uint8_t *ref = bzalloc(out_size);
+
+			fill_random(in, in_size);
+
+			decompress_422(in, in_linesize, 0, TEST_HEIGHT, out,
+				       out_linesize, leading_lum != 0);
+			ref_decompress_422(in, in_linesize, TEST_HEIGHT, ref,
+					   out_linesize, leading_lum != 0);
+			assert_memory_equal(out, ref, out_size);
+
+			bfree(in);
+			bfree(out);
+			bfree(ref);
+		}
+	}
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(decompress_420_test),
+		cmocka_unit_test(decompress_nv12_test),
+		cmocka_unit_test(decompress_422_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
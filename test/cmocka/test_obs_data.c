@@ -0,0 +1,290 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs-data.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+
+#include <string.h>
+
+#define NUM_ITEMS 200
+
+static void set_items(obs_data_t *data, size_t count)
+{
+	struct dstr name = {0};
+
+	/* add in reverse so items don't simply arrive in sorted order */
+	for (size_t i = count; i > 0; i--) {
+		dstr_printf(&name, "item%03d", (int)(i - 1));
+		obs_data_set_int(data, name.array, (long long)(i - 1));
+	}
+
+	dstr_free(&name);
+}
+
+static void obs_data_lookup_test(void **state)
+{
+	obs_data_t *data = obs_data_create();
+	struct dstr name = {0};
+
+	set_items(data, NUM_ITEMS);
+
+	for (size_t i = 0; i < NUM_ITEMS; i++) {
+		dstr_printf(&name, "item%03d", (int)i);
+		assert_true(obs_data_has_user_value(data, name.array));
+		assert_int_equal(obs_data_get_int(data, name.array), i);
+	}
+
+	assert_false(obs_data_has_user_value(data, "item"));
+	assert_false(obs_data_has_user_value(data, "missing"));
+
+	/* replacing values with larger ones reallocates the items */
+	for (size_t i = 0; i < NUM_ITEMS; i += 3) {
+		dstr_printf(&name, "item%03d", (int)i);
+		obs_data_set_string(data, name.array,
+				    "a string long enough to grow the item");
+	}
+
+	for (size_t i = 0; i < NUM_ITEMS; i++) {
+		dstr_printf(&name, "item%03d", (int)i);
+		if (i % 3 == 0)
+			assert_string_equal(
+				obs_data_get_string(data, name.array),
+				"a string long enough to grow the item");
+		else
+			assert_int_equal(obs_data_get_int(data, name.array),
+					 i);
+	}
+
+	dstr_free(&name);
+	obs_data_release(data);
+}
+
+static void obs_data_erase_test(void **state)
+{
+	obs_data_t *data = obs_data_create();
+	struct dstr name = {0};
+
+	set_items(data, NUM_ITEMS);
+
+	for (size_t i = 0; i < NUM_ITEMS; i += 2) {
+		dstr_printf(&name, "item%03d", (int)i);
+		obs_data_erase(data, name.array);
+	}
+
+	for (size_t i = 0; i < NUM_ITEMS; i++) {
+		dstr_printf(&name, "item%03d", (int)i);
+		assert_int_equal(obs_data_has_user_value(data, name.array),
+				 i % 2 == 1);
+	}
+
+	/* erased names can be added again */
+	obs_data_set_int(data, "item000", 1234);
+	assert_int_equal(obs_data_get_int(data, "item000"), 1234);
+
+	dstr_free(&name);
+	obs_data_release(data);
+}
+
+static size_t check_order(obs_data_t *data)
+{
+	obs_data_item_t *item;
+	size_t count = 0;
+	char last[16] = "";
+
+	for (item = obs_data_first(data); item; obs_data_item_next(&item)) {
+		const char *name = obs_data_item_get_name(item);
+		assert_true(strcmp(last, name) < 0);
+		strncpy(last, name, sizeof(last) - 1);
+		count++;
+	}
+
+	return count;
+}
+
+static void obs_data_order_test(void **state)
+{
+	obs_data_t *data = obs_data_create();
+	obs_data_item_t *item;
+
+	set_items(data, NUM_ITEMS);
+	obs_data_set_bool(data, "a", true);
+	obs_data_set_bool(data, "zzz", true);
+
+	/* iteration stays sorted by name */
+	assert_int_equal(check_order(data), NUM_ITEMS + 2);
+
+	/* items removed through a held item handle */
+	item = obs_data_item_byname(data, "zzz");
+	obs_data_item_remove(&item);
+	obs_data_item_release(&item);
+	assert_false(obs_data_has_user_value(data, "zzz"));
+	obs_data_set_bool(data, "zzzz", true);
+	assert_true(obs_data_get_bool(data, "zzzz"));
+
+	obs_data_release(data);
+}
+
+static void obs_data_relink_test(void **state)
+{
+	const char *grown = "a string long enough to grow the item";
+	obs_data_t *data = obs_data_create();
+
+	set_items(data, NUM_ITEMS);
+
+	/* grow the head, the tail and a middle item so they get reallocated
+	 * and relinked, then unlink them and their neighbors */
+	obs_data_set_string(data, "item000", grown);
+	obs_data_set_string(data, "item100", grown);
+	obs_data_set_string(data, "item199", grown);
+	assert_int_equal(check_order(data), NUM_ITEMS);
+
+	obs_data_erase(data, "item000");
+	obs_data_erase(data, "item001");
+	obs_data_erase(data, "item100");
+	obs_data_erase(data, "item101");
+	obs_data_erase(data, "item199");
+	obs_data_erase(data, "item198");
+	assert_int_equal(check_order(data), NUM_ITEMS - 6);
+
+	/* the list has to be intact from both ends after that */
+	obs_data_set_bool(data, "a", true);
+	obs_data_set_bool(data, "zzz", true);
+	obs_data_set_string(data, "item099", grown);
+	obs_data_set_string(data, "item102", grown);
+	assert_int_equal(check_order(data), NUM_ITEMS - 4);
+	assert_string_equal(obs_data_get_string(data, "item099"), grown);
+	assert_string_equal(obs_data_get_string(data, "item102"), grown);
+
+	obs_data_release(data);
+}
+
+static void obs_data_json_test(void **state)
+{
+	obs_data_t *data = obs_data_create();
+	obs_data_t *copy;
+	struct dstr name = {0};
+
+	set_items(data, NUM_ITEMS);
+	copy = obs_data_create_from_json(obs_data_get_json(data));
+
+	for (size_t i = 0; i < NUM_ITEMS; i++) {
+		dstr_printf(&name, "item%03d", (int)i);
+		assert_int_equal(obs_data_get_int(copy, name.array), i);
+	}
+
+	dstr_free(&name);
+	obs_data_release(copy);
+	obs_data_release(data);
+}
+
+static obs_data_t *create_tree(void)
+{
+	obs_data_t *data = obs_data_create();
+	obs_data_t *settings = obs_data_create();
+	obs_data_array_t *array = obs_data_array_create();
+
+	obs_data_set_string(data, "name", "Scene");
+	obs_data_set_string(data, "id", "scene");
+	obs_data_set_bool(data, "enabled", true);
+	obs_data_set_bool(data, "muted", false);
+	obs_data_set_double(data, "volume", 0.1);
+	obs_data_set_int(data, "flags", -1234567890123LL);
+	obs_data_set_default_int(data, "default_only", 5);
+
+	set_items(settings, NUM_ITEMS);
+	obs_data_set_string(settings, "name", "Scene");
+	obs_data_set_obj(data, "settings", settings);
+
+	for (int i = 0; i < 3; i++) {
+		obs_data_t *item = obs_data_create();
+		obs_data_set_int(item, "id", i);
+		obs_data_set_string(item, "name", i ? "Item" : "");
+		obs_data_array_push_back(array, item);
+		obs_data_release(item);
+	}
+	obs_data_set_array(data, "items", array);
+
+	obs_data_array_release(array);
+	obs_data_release(settings);
+	return data;
+}
+
+static void obs_data_binary_test(void **state)
+{
+	const char *file = "test_obs_data.bin";
+	obs_data_t *data = create_tree();
+	obs_data_t *copy;
+	char *json;
+
+	assert_true(obs_data_save_binary(data, file));
+	copy = obs_data_create_from_binary_file(file);
+	assert_non_null(copy);
+
+	/* non-user values aren't stored, just like with JSON */
+	assert_false(obs_data_has_user_value(copy, "default_only"));
+
+	json = bstrdup(obs_data_get_json(data));
+	assert_string_equal(json, obs_data_get_json(copy));
+	obs_data_release(copy);
+
+	/* flip a byte in the body, the checksum has to catch it */
+	FILE *f = os_fopen(file, "r+b");
+	assert_non_null(f);
+	fseek(f, 40, SEEK_SET);
+	int c = fgetc(f);
+	fseek(f, 40, SEEK_SET);
+	fputc(c ^ 0x01, f);
+	fclose(f);
+	assert_null(obs_data_create_from_binary_file(file));
+
+	os_unlink(file);
+	bfree(json);
+	obs_data_release(data);
+}
+
+static void obs_data_json_cached_test(void **state)
+{
+	const char *file = "test_obs_data.json";
+	const char *cache = "test_obs_data.json.bin";
+	obs_data_t *data = create_tree();
+	obs_data_t *copy;
+
+	assert_true(obs_data_save_json_cached(data, file, "tmp", NULL));
+	assert_true(os_file_exists(cache));
+
+	copy = obs_data_create_from_json_file_cached(file, NULL);
+	assert_non_null(copy);
+	assert_string_equal(obs_data_get_string(copy, "name"), "Scene");
+	obs_data_release(copy);
+
+	/* the cache must be ignored once the JSON changes underneath it */
+	obs_data_set_string(data, "name", "Changed");
+	assert_true(obs_data_save_json(data, file));
+
+	copy = obs_data_create_from_json_file_cached(file, NULL);
+	assert_non_null(copy);
+	assert_string_equal(obs_data_get_string(copy, "name"), "Changed");
+	obs_data_release(copy);
+
+	os_unlink(file);
+	os_unlink(cache);
+	obs_data_release(data);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(obs_data_lookup_test),
+		cmocka_unit_test(obs_data_erase_test),
+		cmocka_unit_test(obs_data_order_test),
+		cmocka_unit_test(obs_data_relink_test),
+		cmocka_unit_test(obs_data_json_test),
+		cmocka_unit_test(obs_data_binary_test),
+		cmocka_unit_test(obs_data_json_cached_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
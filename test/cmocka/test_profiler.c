@@ -0,0 +1,144 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs-data.h>
+#include <util/profiler.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define TRACE_FILE "test_profiler_trace.json"
+
+static obs_data_array_t *dump_trace_events(void)
+{
+	obs_data_array_t *events;
+	obs_data_t *trace;
+
+	assert_true(profiler_trace_dump_json(TRACE_FILE));
+
+	trace = obs_data_create_from_json_file(TRACE_FILE);
+	assert_non_null(trace);
+
+	events = obs_data_get_array(trace, "traceEvents");
+	obs_data_release(trace);
+	os_unlink(TRACE_FILE);
+
+	assert_non_null(events);
+	return events;
+}
+
+static void check_event(obs_data_array_t *events, size_t idx,
+			const char *name, const char *ph)
+{
+	obs_data_t *event = obs_data_array_item(events, idx);
+
+	assert_non_null(event);
+	assert_string_equal(obs_data_get_string(event, "name"), name);
+	assert_string_equal(obs_data_get_string(event, "ph"), ph);
+	obs_data_release(event);
+}
+
+static void profiler_trace_dump_test(void **state)
+{
+	obs_data_array_t *events;
+
+	profile_start("untraced");
+	profile_end("untraced");
+
+	profiler_trace_start(0);
+	assert_true(profiler_trace_active());
+
+	profile_start("outer");
+	profile_start("inner");
+	profile_end("inner");
+	profile_end("outer");
+
+	profiler_trace_stop();
+	assert_false(profiler_trace_active());
+
+	profile_start("after stop");
+	profile_end("after stop");
+
+	/* the thread is named after its first top level scope */
+	events = dump_trace_events();
+	assert_int_equal(obs_data_array_count(events), 5);
+	check_event(events, 0, "thread_name", "M");
+	check_event(events, 1, "outer", "B");
+	check_event(events, 2, "inner", "B");
+	check_event(events, 3, "inner", "E");
+	check_event(events, 4, "outer", "E");
+	obs_data_array_release(events);
+
+	/* a dump only has what was recorded since the last one */
+	events = dump_trace_events();
+	assert_int_equal(obs_data_array_count(events), 1);
+	check_event(events, 0, "thread_name", "M");
+	obs_data_array_release(events);
+
+	profiler_free();
+
+	UNUSED_PARAMETER(state);
+}
+
+#define THREAD_EVENTS 1000
+
+static void *trace_thread(void *param)
+{
+	for (size_t i = 0; i < THREAD_EVENTS; i++) {
+		profile_start("thread scope");
+		profile_end("thread scope");
+	}
+
+	UNUSED_PARAMETER(param);
+	return NULL;
+}
+
+static void profiler_trace_threads_test(void **state)
+{
+	obs_data_array_t *events;
+	pthread_t threads[2];
+	size_t begin = 0;
+	size_t end = 0;
+
+	profiler_trace_start(2 * THREAD_EVENTS);
+
+	for (size_t i = 0; i < 2; i++)
+		pthread_create(&threads[i], NULL, trace_thread, NULL);
+	for (size_t i = 0; i < 2; i++)
+		pthread_join(threads[i], NULL);
+
+	/* rings of exited threads are still dumped */
+	events = dump_trace_events();
+	for (size_t i = 0; i < obs_data_array_count(events); i++) {
+		obs_data_t *event = obs_data_array_item(events, i);
+		const char *ph = obs_data_get_string(event, "ph");
+
+		if (strcmp(ph, "B") == 0)
+			begin++;
+		else if (strcmp(ph, "E") == 0)
+			end++;
+
+		obs_data_release(event);
+	}
+	obs_data_array_release(events);
+
+	assert_int_equal(begin, 2 * THREAD_EVENTS);
+	assert_int_equal(end, 2 * THREAD_EVENTS);
+
+	/* stops tracing and frees the rings */
+	profiler_free();
+	assert_false(profiler_trace_active());
+
+	UNUSED_PARAMETER(state);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(profiler_trace_dump_test),
+		cmocka_unit_test(profiler_trace_threads_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
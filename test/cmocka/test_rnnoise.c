@@ -0,0 +1,94 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <math.h>
+#include <string.h>
+
+#include <util/bmem.h>
+
+#include <rnnoise.h>
+
+#define FRAME_SIZE 480
+#define FRAMES 200
+#define MAX_CHANNELS 8
+
+static uint32_t rand_state = 1;
+
+static float next_sample(size_t channel, size_t i)
+{
+	/* speech-like bursts of a tone over noise with pauses, plus stretches
+	 * of digital silence, which rnnoise skips the network for */
+	size_t frame = i / FRAME_SIZE + channel * 3;
+	float tone = (frame / 8) % 2 ? 0.0f : 8000.0f;
+	float noise = (frame / 30) % 4 == 3 ? 0.0f : 1500.0f;
+
+	rand_state = rand_state * 1664525 + 1013904223;
+	return tone * sinf((float)i * (0.05f + 0.01f * (float)channel)) +
+	       noise * ((float)(rand_state >> 8) / (float)(1 << 23) - 1.0f);
+}
+
+/* the batched network has to give the same output as running each channel
+ * through rnnoise_process_frame on its own */
+static void run_batch(int channels)
+{
+	DenoiseState *ref_states[MAX_CHANNELS];
+	DenoiseState *states[MAX_CHANNELS];
+	float *ref[MAX_CHANNELS];
+	float *out[MAX_CHANNELS];
+	float vad[MAX_CHANNELS];
+	size_t pos = 0;
+
+	for (int c = 0; c < channels; c++) {
+		ref_states[c] = rnnoise_create(NULL);
+		states[c] = rnnoise_create(NULL);
+		ref[c] = bmalloc(FRAME_SIZE * sizeof(float));
+		out[c] = bmalloc(FRAME_SIZE * sizeof(float));
+	}
+
+	for (int frame = 0; frame < FRAMES; frame++) {
+		for (int c = 0; c < channels; c++) {
+			for (size_t i = 0; i < FRAME_SIZE; i++)
+				ref[c][i] = next_sample(c, pos + i);
+			memcpy(out[c], ref[c], FRAME_SIZE * sizeof(float));
+		}
+		pos += FRAME_SIZE;
+
+		rnnoise_process_frames(states, out, (const float **)out, vad,
+				       channels);
+
+		for (int c = 0; c < channels; c++) {
+			float ref_vad = rnnoise_process_frame(ref_states[c],
+							      ref[c], ref[c]);
+
+			assert_memory_equal(&vad[c], &ref_vad, sizeof(float));
+			assert_memory_equal(out[c], ref[c],
+					    FRAME_SIZE * sizeof(float));
+		}
+	}
+
+	for (int c = 0; c < channels; c++) {
+		rnnoise_destroy(ref_states[c]);
+		rnnoise_destroy(states[c]);
+		bfree(ref[c]);
+		bfree(out[c]);
+	}
+}
+
+static void batch_test(void **state)
+{
+	run_batch(1);
+	run_batch(2);
+	run_batch(5);
+	run_batch(8);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(batch_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,159 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/spsc-ring.h>
+#include <util/threading.h>
+#include <util/platform.h>
+
+static void spsc_ring_basic_test(void **state)
+{
+	struct spsc_ring ring;
+	uint8_t in[16];
+	uint8_t out[16];
+
+	for (size_t i = 0; i < sizeof(in); i++)
+		in[i] = (uint8_t)i;
+
+	spsc_ring_init(&ring, 16);
+
+	assert_int_equal(spsc_ring_capacity(&ring), 16);
+	assert_int_equal(spsc_ring_size(&ring), 0);
+	assert_int_equal(spsc_ring_space(&ring), 16);
+	assert_false(spsc_ring_read(&ring, out, 1));
+
+	assert_true(spsc_ring_write(&ring, in, 10));
+	assert_int_equal(spsc_ring_size(&ring), 10);
+	assert_int_equal(spsc_ring_space(&ring), 6);
+
+	/* writes are all or nothing */
+	assert_false(spsc_ring_write(&ring, in, 7));
+	assert_int_equal(spsc_ring_size(&ring), 10);
+
+	assert_true(spsc_ring_peek(&ring, out, 4));
+	assert_memory_equal(out, in, 4);
+	assert_int_equal(spsc_ring_size(&ring), 10);
+
+	assert_true(spsc_ring_read(&ring, out, 10));
+	assert_memory_equal(out, in, 10);
+	assert_int_equal(spsc_ring_size(&ring), 0);
+
+	spsc_ring_free(&ring);
+}
+
+static void spsc_ring_wrap_test(void **state)
+{
+	struct spsc_ring ring;
+	uint8_t in[12];
+	uint8_t out[12];
+	uint8_t zero[12] = {0};
+
+	for (size_t i = 0; i < sizeof(in); i++)
+		in[i] = (uint8_t)(i + 1);
+
+	spsc_ring_init(&ring, 16);
+
+	/* move the positions close to the end of the buffer */
+	assert_true(spsc_ring_write(&ring, in, 12));
+	assert_true(spsc_ring_read(&ring, NULL, 12));
+
+	assert_true(spsc_ring_write(&ring, in, 12));
+	assert_int_equal(spsc_ring_size(&ring), 12);
+	assert_true(spsc_ring_read(&ring, out, 12));
+	assert_memory_equal(out, in, 12);
+
+	assert_true(spsc_ring_write_zero(&ring, 12));
+	assert_true(spsc_ring_read(&ring, out, 12));
+	assert_memory_equal(out, zero, 12);
+
+	/* fill completely across the wrap point */
+	assert_true(spsc_ring_write(&ring, in, 12));
+	assert_true(spsc_ring_write(&ring, in, 4));
+	assert_int_equal(spsc_ring_space(&ring), 0);
+	assert_false(spsc_ring_write(&ring, in, 1));
+
+	spsc_ring_free(&ring);
+}
+
+#define STRESS_TOTAL (1024 * 1024)
+#define STRESS_CHUNK 61
+
+static void *stress_producer(void *param)
+{
+	struct spsc_ring *ring = param;
+	uint8_t chunk[STRESS_CHUNK];
+	uint32_t val = 0;
+	size_t sent = 0;
+
+	while (sent < STRESS_TOTAL) {
+		size_t size = STRESS_CHUNK;
+		if (size > STRESS_TOTAL - sent)
+			size = STRESS_TOTAL - sent;
+
+		for (size_t i = 0; i < size; i++)
+			chunk[i] = (uint8_t)(val + i);
+
+		if (!spsc_ring_write(ring, chunk, size)) {
+			os_sleep_ms(0);
+			continue;
+		}
+
+		val += (uint32_t)size;
+		sent += size;
+	}
+
+	return NULL;
+}
+
+static void spsc_ring_threaded_test(void **state)
+{
+	struct spsc_ring ring;
+	pthread_t thread;
+	uint8_t chunk[STRESS_CHUNK];
+	uint32_t val = 0;
+	size_t received = 0;
+	bool valid = true;
+
+	spsc_ring_init(&ring, 1000);
+
+	assert_int_equal(
+		pthread_create(&thread, NULL, stress_producer, &ring), 0);
+
+	/* read in a different chunk size than the producer writes so that
+	 * reads and writes constantly straddle each other */
+	while (received < STRESS_TOTAL) {
+		size_t size = STRESS_CHUNK - 17;
+		if (size > STRESS_TOTAL - received)
+			size = STRESS_TOTAL - received;
+
+		if (!spsc_ring_read(&ring, chunk, size)) {
+			os_sleep_ms(0);
+			continue;
+		}
+
+		for (size_t i = 0; i < size; i++)
+			valid = valid && chunk[i] == (uint8_t)(val + i);
+
+		val += (uint32_t)size;
+		received += size;
+	}
+
+	pthread_join(thread, NULL);
+
+	assert_true(valid);
+	assert_int_equal(spsc_ring_size(&ring), 0);
+
+	spsc_ring_free(&ring);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(spsc_ring_basic_test),
+		cmocka_unit_test(spsc_ring_wrap_test),
+		cmocka_unit_test(spsc_ring_threaded_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
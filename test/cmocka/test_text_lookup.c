@@ -0,0 +1,109 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+
+#include <util/text-lookup.h>
+#include <util/platform.h>
+#include <util/dstr.h>
+#include <util/bmem.h>
+
+#define NUM_KEYS 1000
+
+static const char *base_file = "test_text_lookup_en.ini";
+static const char *locale_file = "test_text_lookup_de.ini";
+
+static const char *base_text = "# comment\n"
+				"Name=\"Plain\"\n"
+				"Quoted=\"Line\\nBreak \\\"quoted\\\"\"\n"
+				"Name.Prefix=\"Prefixed\"\n"
+				"Untranslated=\"English\"\n";
+
+static const char *locale_text = "Name=\"Schlicht\"\n"
+				  "NAME.prefix=\"Vorangestellt\"\n";
+
+static void text_lookup_basic_test(void **state)
+{
+	const char *out = NULL;
+	lookup_t *lookup;
+
+	assert_true(os_quick_write_utf8_file(base_file, base_text,
+					     strlen(base_text), false));
+	assert_true(os_quick_write_utf8_file(locale_file, locale_text,
+					     strlen(locale_text), false));
+
+	lookup = text_lookup_create(base_file);
+	assert_non_null(lookup);
+
+	assert_true(text_lookup_getstr(lookup, "Name", &out));
+	assert_string_equal(out, "Plain");
+	assert_true(text_lookup_getstr(lookup, "nAmE", &out));
+	assert_string_equal(out, "Plain");
+	assert_true(text_lookup_getstr(lookup, "Quoted", &out));
+	assert_string_equal(out, "Line\nBreak \"quoted\"");
+	assert_false(text_lookup_getstr(lookup, "Nam", &out));
+	assert_false(text_lookup_getstr(lookup, "Name.", &out));
+	assert_false(text_lookup_getstr(lookup, "# comment", &out));
+
+	/* a locale file added later replaces the values it defines */
+	assert_true(text_lookup_add(lookup, locale_file));
+	assert_true(text_lookup_getstr(lookup, "Name", &out));
+	assert_string_equal(out, "Schlicht");
+	assert_true(text_lookup_getstr(lookup, "Name.Prefix", &out));
+	assert_string_equal(out, "Vorangestellt");
+	assert_true(text_lookup_getstr(lookup, "Untranslated", &out));
+	assert_string_equal(out, "English");
+
+	assert_false(text_lookup_add(lookup, "test_text_lookup_missing.ini"));
+
+	text_lookup_destroy(lookup);
+	os_unlink(base_file);
+	os_unlink(locale_file);
+}
+
+static void text_lookup_many_test(void **state)
+{
+	struct dstr data = {0};
+	struct dstr name = {0};
+	struct dstr value = {0};
+	const char *out;
+	lookup_t *lookup;
+
+	for (int i = 0; i < NUM_KEYS; i++)
+		dstr_catf(&data, "Key%d=\"Value %d\"\n", i, i);
+
+	assert_true(os_quick_write_utf8_file(base_file, data.array, data.len,
+					     false));
+
+	lookup = text_lookup_create(base_file);
+	assert_non_null(lookup);
+
+	for (int i = 0; i < NUM_KEYS; i++) {
+		dstr_printf(&name, "KEY%d", i);
+		dstr_printf(&value, "Value %d", i);
+
+		out = NULL;
+		assert_true(text_lookup_getstr(lookup, name.array, &out));
+		assert_string_equal(out, value.array);
+	}
+
+	assert_false(text_lookup_getstr(lookup, "Key1000", &out));
+
+	text_lookup_destroy(lookup);
+	os_unlink(base_file);
+
+	dstr_free(&data);
+	dstr_free(&name);
+	dstr_free(&value);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(text_lookup_basic_test),
+		cmocka_unit_test(text_lookup_many_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,148 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs-internal.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#ifndef DL_OPENGL
+#define DL_OPENGL "libobs-opengl"
+#endif
+
+#define RELEASE_TIMEOUT_MS 5000
+
+static int setup(void **state)
+{
+	struct obs_video_info ovi = {
+		.graphics_module = DL_OPENGL,
+		.fps_num = 30,
+		.fps_den = 1,
+		.base_width = 640,
+		.base_height = 360,
+		.output_width = 640,
+		.output_height = 360,
+		.output_format = VIDEO_FORMAT_NV12,
+		.gpu_conversion = true,
+		.colorspace = VIDEO_CS_709,
+		.range = VIDEO_RANGE_PARTIAL,
+		.scale_type = OBS_SCALE_BICUBIC,
+	};
+
+	if (!obs_startup("en-US", NULL, NULL))
+		return -1;
+
+	/* rungs need a graphics device, which headless machines lack */
+	*state = (void *)(uintptr_t)(obs_reset_video(&ovi) == OBS_VIDEO_SUCCESS);
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	obs_shutdown();
+	return 0;
+}
+
+static size_t count_rungs(uint32_t width, uint32_t height,
+			  size_t *released)
+{
+	struct obs_core_video *video = &obs->video;
+	size_t count = 0;
+
+	pthread_mutex_lock(&video->rungs_mutex);
+	for (size_t i = 0; i < video->rungs.num; i++) {
+		struct obs_video_rung *rung = video->rungs.array[i];
+		if (rung->width == width && rung->height == height)
+			count++;
+	}
+	*released = video->released_rungs.num;
+	pthread_mutex_unlock(&video->rungs_mutex);
+
+	return count;
+}
+
+static void rung_share_test(void **state)
+{
+	struct obs_video_rung *a, *b, *c;
+	size_t released;
+
+	if (!*state)
+		skip();
+
+	a = obs_video_rung_acquire(320, 180);
+	b = obs_video_rung_acquire(320, 180);
+	c = obs_video_rung_acquire(160, 90);
+
+	assert_non_null(a);
+	assert_true(a == b);
+	assert_non_null(c);
+	assert_true(a != c);
+	assert_int_equal(count_rungs(320, 180, &released), 1);
+
+	obs_video_rung_release(a);
+	assert_int_equal(count_rungs(320, 180, &released), 1);
+	obs_video_rung_release(b);
+	obs_video_rung_release(c);
+	assert_int_equal(count_rungs(320, 180, &released), 0);
+	assert_int_equal(count_rungs(160, 90, &released), 0);
+}
+
+struct rung_release {
+	struct obs_video_rung *rung;
+	os_event_t *done;
+	volatile bool released;
+};
+
+/* mimics an encoder that stops itself from receive_video after an error,
+ * which drops the last reference on the rung's own video thread */
+static void release_from_rung_thread(void *param, struct video_data *frame)
+{
+	struct rung_release *rr = param;
+
+	if (os_atomic_exchange_bool(&rr->released, true))
+		return;
+
+	stop_raw_video(rr->rung->video, release_from_rung_thread, rr);
+	obs_video_rung_release(rr->rung);
+	os_event_signal(rr->done);
+
+	UNUSED_PARAMETER(frame);
+}
+
+static void rung_release_on_own_thread_test(void **state)
+{
+	struct rung_release rr = {0};
+	size_t released = 1;
+
+	if (!*state)
+		skip();
+
+	rr.rung = obs_video_rung_acquire(320, 180);
+	assert_non_null(rr.rung);
+	assert_int_equal(os_event_init(&rr.done, OS_EVENT_TYPE_MANUAL), 0);
+
+	start_raw_video(rr.rung->video, NULL, release_from_rung_thread, &rr);
+	assert_int_equal(os_event_timedwait(rr.done, RELEASE_TIMEOUT_MS), 0);
+
+	/* the graphics thread frees it on its next tick */
+	for (int i = 0; i < RELEASE_TIMEOUT_MS && released; i++) {
+		count_rungs(320, 180, &released);
+		if (released)
+			os_sleep_ms(1);
+	}
+
+	assert_int_equal(released, 0);
+	assert_int_equal(count_rungs(320, 180, &released), 0);
+	os_event_destroy(rr.done);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(rung_share_test),
+		cmocka_unit_test(rung_release_on_own_thread_test),
+	};
+
+	return cmocka_run_group_tests(tests, setup, teardown);
+}